@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <vector>
 #include <map>
+#include <set>
 #include <bitset>
 #include <string>
 #include <sstream>
@@ -11,9 +12,28 @@
 #include <climits>
 #include <iostream>
 #include <iomanip>
+#include <typeinfo>
+#include <algorithm>
+#include <new>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif // __SSE2__
 #include "optional.hpp"
 #include "cpp_magic.h"
 
+// Fixed size arrays and hashed maps: from the standard library since C++11,
+// from TR1 before
+//
+#if (__cplusplus >= 201103L)
+#include <array>
+#include <unordered_map>
+#define HOB_TR1_CONTAINERS
+#elif defined(__GLIBCXX__)
+#include <tr1/array>
+#include <tr1/unordered_map>
+#define HOB_TR1_CONTAINERS
+#endif // __GLIBCXX__
+
 #define FLOAT_TO_INTEGER_SERIALIZATION
 
 #define M_LOG(...)            printf("%s:%s:%d: ",        \
@@ -30,41 +50,78 @@
 #if defined(DEBUG_WRITE)
 #define ASSERT_SWRITE(f,v,s)  HOB::_w(f,v,s)
 #else // DEBUG_WRITE
-#define ASSERT_SWRITE(f,v,s)  (f.write(reinterpret_cast<const char *>(v),s)\
-                                .good())
+#define ASSERT_SWRITE(f,v,s)  HOB::_ws(f,v,s)
 #endif // DEBUG_WRITE
 
+#if (__cplusplus >= 201103L)
+#define CONSTEXPR             constexpr
+#else // __cplusplus < 201103L
+#define CONSTEXPR
+#endif // __cplusplus < 201103L
+
+// Compile time check, within a function body: m names the failure
+//
+#if (__cplusplus >= 201103L)
+#define STATIC_CHECK(c, m)    static_assert(c, #m)
+#else // __cplusplus < 201103L
+#define STATIC_CHECK(c, m)    typedef char m[(c) ? 1 : -1]; (void)sizeof(m)
+#endif // __cplusplus < 201103L
+
+#if defined(__GNUC__)
+#define DEPRECATED            __attribute__((deprecated))
+#else // !__GNUC__
+#define DEPRECATED
+#endif // !__GNUC__
+
+// Per thread state (see HOB::Sizes, HOB::Nesting) and atomic reference
+// counts (see HOB::Frame): HOBs are encoded and decoded by many threads at
+// once, so neither may fall back to plain shared variables
+//
+#if (__cplusplus >= 201103L)
+#include <atomic>
+#define THREAD_LOCAL          thread_local
+#define ATOMIC_LONG           std::atomic<long>
+#define ATOMIC_ADD(c, n)      ((c).fetch_add(n) + (n))
+#elif defined(__GNUC__)
+#define THREAD_LOCAL          __thread
+#define ATOMIC_LONG           long
+#define ATOMIC_ADD(c, n)      __sync_add_and_fetch(&(c), n)
+#else // !__GNUC__
+#error "HOB needs thread local storage and atomics: build as C++11, or with GCC"
+#endif // !__GNUC__
+
+// Decoding limits defaults (see HOB::limits())
+//
+#if !defined(HOB_MAX_FRAME)
+#define HOB_MAX_FRAME         (size_t(1) << 26) // payload bytes of a frame
+#endif // !HOB_MAX_FRAME
+
+#if !defined(HOB_MAX_ITEMS)
+#define HOB_MAX_ITEMS         (size_t(1) << 24) // items of a container
+#endif // !HOB_MAX_ITEMS
+
+#if !defined(HOB_MAX_STRING)
+#define HOB_MAX_STRING        (size_t(1) << 24) // bytes of a string
+#endif // !HOB_MAX_STRING
+
+#if !defined(HOB_MAX_DEPTH)
+#define HOB_MAX_DEPTH         64                // nested HOBs
+#endif // !HOB_MAX_DEPTH
+
+#if !defined(HOB_MAX_GROUPS)
+#define HOB_MAX_GROUPS        1024              // nested text groups
+#endif // !HOB_MAX_GROUPS
+
+// Change tracking mode of the HOBSTRUCTs not given one (see TRACK_CHANGES)
+//
+#if !defined(HOB_TRACKING)
+#define HOB_TRACKING          TRACK_VALUES
+#endif // !HOB_TRACKING
+
 #define INDENT(l)             string(((indent >= 0)?(indent + (l)):0)*4,' ')
 
 #define HSEED                 65599llu
 // #define HSEED                 11400714819323198485llu
-#define HLEN(s)	              ((sizeof(s)/sizeof(s[0])) - 1)
-#define H1(s,i,x)             (static_cast<uint64_t>(x)*(((i)<HLEN(s))?HSEED:1)\
-                               +                                               \
-                               static_cast<uint8_t>(s[((i)<HLEN(s))            \
-                                                      ?HLEN(s)-1-(i)           \
-                                                      :HLEN(s)]))
-
-#define H4(s,i,x)             H1(s,(i)    , \
-                              H1(s,(i)+  1, \
-                              H1(s,(i)+  2, \
-                              H1(s,(i)+  3, (x)))))
-
-#define H16(s,i,x)            H4(s,(i)    , \
-                              H4(s,(i)+  4, \
-                              H4(s,(i)+  8, \
-                              H4(s,(i)+ 12, (x)))))
-
-#define H64(s,i,x)            H16(s,(i)    , \
-                              H16(s,(i)+ 16, \
-                              H16(s,(i)+ 32, \
-                              H16(s,(i)+ 48, (x)))))
-
-#define H256(s,i,x)           H64(s,(i)    , \
-                              H64(s,(i)+ 64, \
-                              H64(s,(i)+128, \
-                              H64(s,(i)+192, (x)))))
-
 #define HASH(x)               (static_cast<uint64_t>((x)^((x)>>32)))
 
 #define ZIGZAG_DECODE(value)  static_cast<uint64_t>(              \
@@ -85,33 +142,23 @@
                                   )                               \
                               )
 
-// |--------------------------------|
-// |0..............................31|
-//
-// |----------------------------------------------------------------|
-// |0..............................................................63|
-//
-#if defined(ENABLE_CPP_HASH)
-#if defined(ENABLE_CPP_MAX_SIZE_HASH)
-#define HUPDATE(s)   update_id(static_cast<uint64_t>( \
-                               (HLEN(s)>0) ? H256(s,0,get_id()) \
-                                           : get_id()))
-#else // !ENABLE_CPP_MAX_SIZE_HASH
-#define HUPDATE(s)   update_id(static_cast<uint64_t>( \
-                               (HLEN(s)>0) ? H64(s,0,get_id()) \
-                                           : get_id()))
-#endif // !ENABLE_CPP_MAX_SIZE_HASH
-#else // !ENABLE_CPP_HASH
-#define HUPDATE(s)   update_id(s)
-#endif // !ENABLE_CPP_HASH
-
 using namespace std;
 using namespace nonstd;
 
+#if defined(HOB_TR1_CONTAINERS) && (__cplusplus < 201103L)
+using std::tr1::array;
+using std::tr1::unordered_map;
+#endif // HOB_TR1_CONTAINERS
+
 class HOB
 {
 public:
     class Buffer;
+    class View;
+    class Frame;
+
+    template<size_t N>
+    class LazyIndex;
 
     typedef uint64_t UID;
 
@@ -123,19 +170,133 @@ public:
         TEXT,
     };
 
+    // Field encoding hints (see HOBSTRUCT)
+    //
+    enum Encoding
+    {
+        DEFAULT, // as told by the field type
+        VARINT , // VARINT, signed values are not ZIGZAG encoded
+        ZIGZAG , // ZIGZAG VARINT
+        FIXED32, // 4 bytes, little endian
+        FIXED64, // 8 bytes, little endian
+        DELTA  , // vectors only: as packed<T> (integers), series<T> (floats)
+    };
+
+    template<Encoding E>
+    struct As {};
+
+    // How reading a HOBSTRUCT tells which fields changed (see TRACK_CHANGES)
+    //
+    enum Tracking
+    {
+        TRACK_VALUES, // the values read are compared with the previous ones
+        TRACK_READS , // no comparison, every field read is changed
+        TRACK_NONE  , // no comparison, no field is ever changed
+    };
+
+    template<Tracking M>
+    struct Track {};
+
+    template<class T>
+    struct Tracked
+    {
+        static const Tracking mode = HOB_TRACKING;
+    };
+
+    // Hard limits on the lengths read from the wire, checked before any
+    // allocation is done for them: frames, containers and strings past them,
+    // or past the bytes left in the frame, and HOBs (or text groups) nested
+    // deeper, fail to decode. Shared by all the threads, to be set before
+    // decoding:
+    //
+    //     HOB::limits().items = 4096;
+    //
+    struct Limits
+    {
+        size_t frame;  // payload bytes of a frame
+        size_t items;  // items of a container
+        size_t chars;  // bytes of a string
+        size_t depth;  // nested HOBs
+        size_t groups; // nested groups of the text format
+    };
+
+    static Limits &limits()
+    {
+        static Limits l = { HOB_MAX_FRAME ,
+                            HOB_MAX_ITEMS ,
+                            HOB_MAX_STRING,
+                            HOB_MAX_DEPTH ,
+                            HOB_MAX_GROUPS };
+
+        return l;
+    }
+
+    // Whether a HOBSTRUCT keeps its last encoded frame (see CACHE_ENCODING)
+    //
+    template<class T>
+    struct Cached
+    {
+        static const bool value = false;
+    };
+
+    // Last encoded frame of the N fields of a HOBSTRUCT, none kept unless C
+    //
+    template<size_t N, bool C>
+    struct Encoded
+    {
+        inline void touch(size_t f) { (void)f; }
+    };
+
+    template<size_t N>
+    struct Encoded<N, true>
+    {
+        // Room left for the ID and the payload size before the payload
+        //
+        static const size_t HEAD = 18;
+
+        struct Layout
+        {
+            vector<uint8_t> b;        // header room, then the payload
+            size_t          at[N+1];  // fields bounds within b
+            size_t          begin;    // frame start within b
+        };
+
+        Encoded() : cur(0), nested(false), valid(false) {}
+
+        // Marks the field f (every field, for f == N) to be encoded again
+        //
+        inline void touch(size_t f)
+        {
+            if (f < N)
+            {
+                dirty.set(f);
+            }
+            else
+            {
+                valid = false;
+            }
+        }
+
+        inline bool clean() const { return valid && !nested && dirty.none(); }
+
+        inline const Layout &frame() const { return l[cur]; }
+
+        Layout    l[2]; // the current frame, the one being encoded
+        size_t    cur;
+        bitset<N> dirty;
+        bool      nested; // HOB fields: encoded again, from their own frame
+        bool      valid;
+    };
+
     HOB()
         : _id(UNDEFINED)
-        , _is(     NULL)
-        , _sp(        0)
-        , _ep(        0)
+        , _pl(     NULL)
         , _np(       -1)
     { }
 
     HOB(const UID &id_)
         : _id(   0)
-        , _is(NULL)
-        , _sp(   0)
-        , _ep(   0)
+        , _pl(NULL)
         , _np(  -1)
     {
         update_id(id_);
@@ -143,9 +304,7 @@ public:
 
     HOB(const char *id_)
         : _id(   0)
-        , _is(NULL)
-        , _sp(   0)
-        , _ep(   0)
+        , _pl(NULL)
         , _np(  -1)
     {
         update_id(id_);
@@ -153,38 +312,48 @@ public:
 
     HOB(const string &id_)
         : _id(   0)
-        , _is(NULL)
-        , _sp(   0)
-        , _ep(   0)
+        , _pl(NULL)
         , _np(  -1)
     {
         update_id(id_);
     }
 
     HOB(const HOB &ref)
+        : _id(UNDEFINED)
+        , _pl(     NULL)
+        , _np(       -1)
     {
         *this = ref;
     }
 
     virtual ~HOB()
     {
+        delete _pl;
     }
 
     HOB & operator=(const HOB & ref)
     {
+        if (this == &ref)
+        {
+            return *this;
+        }
+
         _id = ref._id;
-        _ss.str(ref._ss.str()); // TODO: needed ?
-        _is = ref._is;
-        _sp = ref._sp;
-        _ep = ref._ep;
+
+        if ((NULL != ref._pl) && !ref._pl->empty())
+        {
+            buffer() = *ref._pl;
+        }
+        else if (NULL != _pl)
+        {
+            _pl->clear();
+        }
 
         return *this;
     }
 
     bool operator<<(istream &is_)
     {
-        flush_pending();
-
         return _r(is_);
     }
 
@@ -193,881 +362,4818 @@ public:
         return ((_id == ref._id) && _r(ref));
     }
 
-    bool operator>>(HOB::Buffer & buffer) const
+    bool operator<<(const View &v)
     {
-        /*
-        size_t payload = _l();
+        if ((UNDEFINED == _id) || (_id != v.id()))
+        {
+            return false;
+        }
 
-        buffer.reserve
-        (
-            buffer.size()
-            +
-            _l(_id)+((payload>0)?(_l(payload)+payload):0)
-        );
-        */
+        reset_changes();
 
-        ostream os(&buffer);
+        MemorySource ms(v.payload(), v.payload_size());
 
-        return *this >> os;
+        return _r(ms);
     }
 
-    bool operator>>(ostream &os) const
+    // Decodes an owned frame, possibly read by another thread. Generic HOBs
+    // take a copy of any frame.
+    //
+    bool operator<<(const Frame &f)
     {
-        if (UNDEFINED == _id)
+        if (typeid(*this) == typeid(HOB))
         {
+            if (f.empty())
+            {
+                return false;
+            }
+
+            buffer().assign(f.payload(), f.payload() + f.payload_size());
+
+            _id = f.id();
+
             return true;
         }
 
-        if (!_w(os, _id))
+        if ((UNDEFINED == _id) || (_id != f.id()))
         {
             return false;
         }
 
-        if (has_payload(_id))
-        {
-            if (!_w(os,_l()) || !_w(os))
-            {
-                return false;
-            }
-        }
+        reset_changes();
 
-        return true;
+        MemorySource ms(f.payload(), f.payload_size());
+
+        return _r(ms);
     }
 
-    bool operator==(const HOB &ref) const
+    // Single pass typed read: the next frame is decoded while read, when
+    // it has the ID of this HOB, and skipped otherwise. Either way, the
+    // stream is left past the frame.
+    //
+    // Returns 1 if the frame was read, 0 if it was skipped, -1 on errors or
+    // at the end of the stream:
+    //
+    //     int r;
+    //
+    //     while ((r = my_struct.read_from(is)) >= 0) { if (r > 0) { ... } }
+    //
+    int read_from(istream &is_)
     {
-        bool rv = (_id == ref._id);
+        uint64_t id_ = UNDEFINED;
+        size_t   sz_ = 0;
 
-        return rv;
-    }
+        if (!read_header(is_, id_, sz_))
+        {
+            return -1;
+        }
 
-    bool operator!=(const HOB &ref) const
-    {
-        bool rv = (_id != ref._id);
+        if ((UNDEFINED == _id) || (id_ != _id))
+        {
+            return skip_payload(is_, sz_) ? 0 : -1;
+        }
 
-        return rv;
+        return read_payload(is_, sz_) ? 1 : -1;
     }
 
-    operator size_t() const
+    // Single pass read of the next frame into whichever of the n HOBs has
+    // its ID. Generic HOBs among them take any frame the others don't.
+    //
+    // Returns the index of the HOB read, n if the frame matched none of
+    // them (it is skipped), -1 on errors or at the end of the stream:
+    //
+    //     HOB  any;
+    //     HOB *hobs[] = { &hello, &bye, &any };
+    //
+    //     ssize_t i;
+    //
+    //     while ((i = HOB::read_one_of(is, hobs)) >= 0) { ... }
+    //
+    static ssize_t read_one_of(istream &is_, HOB *const *hobs, size_t n)
     {
-        size_t sz = _l();
+        HOB      h;
+        uint64_t id_ = UNDEFINED;
+        size_t   sz_ = 0;
 
-        return _l(_id) + ((sz > 0) ? ( _l(sz) + sz ) : 0); // ( _ep - _sp );
-    }
+        if (!h.read_header(is_, id_, sz_))
+        {
+            return -1;
+        }
 
-    virtual bool rewind()
-    {
-        istream & s_ = static_cast<istream&>(*this);
+        ssize_t any = -1;
 
-        s_.clear();
+        for (size_t i=0; i<n; i++)
+        {
+            HOB &m = *hobs[i];
 
-        return s_.seekg(_sp,s_.beg).good();
-    }
+            if (typeid(m) == typeid(HOB))
+            {
+                if (any < 0)
+                {
+                    any = static_cast<ssize_t>(i);
+                }
+            }
+            else
+            if ((UNDEFINED != id_) && (m._id == id_))
+            {
+                return m.read_payload(is_, sz_) ? static_cast<ssize_t>(i) : -1;
+            }
+        }
 
-    operator istream &() { return (NULL != _is) ? *_is : _ss; }
+        if (any >= 0)
+        {
+            return hobs[any]->read_along(is_, id_, sz_) ? any : -1;
+        }
 
-    operator bool() const
-    {
-        return is_changed();
+        return skip_payload(is_, sz_) ? static_cast<ssize_t>(n) : -1;
     }
 
-    void operator~()
+    template<size_t N>
+    static ssize_t read_one_of(istream &is_, HOB *const (&hobs)[N])
     {
-        reset_changes();
+        return read_one_of(is_, &hobs[0], N);
     }
 
-    const string operator()(const Dump &dump = TEXT) const
+    bool operator>>(HOB::Buffer & buffer) const
     {
-        stringstream ss;
+        /*
+        size_t payload = _l();
 
-        ss.str(string());
+        buffer.reserve
+        (
+            buffer.size()
+            +
+            _l(_id)+((payload>0)?(_l(payload)+payload):0)
+        );
+        */
 
-        _s(ss, (JSON == dump) ? 0 : -1);
+        ostream os(&buffer);
 
-        return ss.str();
+        return *this >> os;
     }
 
-    class Buffer: public stringbuf
+    bool operator>>(ostream &os) const
     {
-    public:
-        Buffer(size_t reserve_=0)
-            : stringbuf()
-            , _buffer  (NULL)
-            , _size    (0)
-            , _capacity(0)
-        {
-            reserve(reserve_);
-        }
+        const uint8_t *p = NULL;
+        size_t         n = 0;
 
-        ~Buffer()
+        // Kept frame, encoded again where touched, in a single write
+
+        if (encoded(p, n))
         {
-            free(_buffer);
+            return ASSERT_SWRITE(os, p, n);
         }
 
-        const uint8_t *data    () const { return _buffer  ; }
-        size_t         size    () const { return _size    ; }
-        size_t         capacity() const { return _capacity; }
+        // The size pass records the payload size of each nested HOB, the
+        // write pass then uses them instead of evaluating them again
+        //
+        Sizes sizes;
 
-        void reserve(const size_t &s)
-        {
-            if (s > _capacity)
-            {
-                _buffer = reinterpret_cast<uint8_t*>(realloc(_buffer,s));
+        size_t sz = has_payload(_id) ? _l() : 0;
 
-                _capacity = s;
-            }
-        }
+        sizes.replay();
 
-        void clear() { _size = 0; }
+        return write_frame(os, sz);
+    }
 
-        void log(const string & h)
+    // Serializes the HOB straight into dst, without any iostream. Returns
+    // the number of bytes written, 0 when cap is too small (nothing useful
+    // is left in dst) or the HOB has an undefined ID.
+    //
+    size_t serialize_to(uint8_t *dst, size_t cap) const
+    {
+        if (UNDEFINED == _id)
         {
-            cerr << h
-                 << " - Capacity: "
-                 << _capacity
-                 << " Size: "
-                 << _size
-                 << endl;
+            return 0;
         }
 
-    private:
-        uint8_t *_buffer;
-        size_t   _size;
-        size_t   _capacity;
+        const uint8_t *p = NULL;
+        size_t         n = 0;
 
-        virtual int_type overflow(int_type c)
+        if (encoded(p, n))
         {
-            if (c != traits_type::eof())
+            if ((NULL == dst) || (n > cap))
             {
-                if ((_size + 1) > _capacity)
-                {
-                    reserve((_size + 1) * 1.2);
-                }
-
-                if (NULL != _buffer)
-                {
-                    _buffer[_size++] = traits_type::to_char_type(c);
-                }
+                return 0;
             }
 
-            return traits_type::not_eof(c);
+            memcpy(dst, p, n);
+
+            return n;
         }
-    };
 
-    template<class T>
-    class StreamWrapper
-    {
-    public:
-        StreamWrapper(T &s): _str_ref(s) {}
+        Sizes sizes;
 
-        T & operator()(void) { return _str_ref; }
+        size_t sz = has_payload(_id) ? _l() : 0;
+        size_t len = _l(_id) + (has_payload(_id) ? (_l(sz) + sz) : 0);
 
-    private:
-        T & _str_ref;
-    };
+        sizes.replay();
 
-    typedef StreamWrapper<istream> Src;
-    typedef StreamWrapper<ostream> Snk;
+        if ((NULL == dst) || (len > cap))
+        {
+            return 0;
+        }
 
-    static bool parse(Src &is, Snk &os)
-    {
-        return parse(is(),os(),'\0');
+        MemorySink ms(dst, cap);
+
+        if (!write_frame(ms, sz))
+        {
+            return 0;
+        }
+
+        return static_cast<size_t>(ms.tell() - dst);
     }
 
+    // Appends the serialized HOB to dst, returns the number of bytes added.
+    // The buffer is grown once, its storage is reused across the frames
+    // once cleared, and the bytes are written as they are: the cheapest way
+    // to serialize many frames one after the other.
+    //
+    size_t serialize_to(Buffer &dst) const
+    {
+        if (UNDEFINED == _id)
+        {
+            return 0;
+        }
+
+        const uint8_t *p = NULL;
+        size_t         n = 0;
+
+        if (encoded(p, n))
+        {
+            uint8_t *d = dst.room(n);
+
+            if (NULL == d)
+            {
+                return 0;
+            }
+
+            memcpy(d, p, n);
+
+            dst.commit(n);
+
+            return n;
+        }
+
+        Sizes sizes;
+
+        size_t sz = has_payload(_id) ? _l() : 0;
+        size_t len = _l(_id) + (has_payload(_id) ? (_l(sz) + sz) : 0);
+
+        sizes.replay();
+
+        uint8_t *d = dst.room(len);
+
+        if (NULL == d)
+        {
+            return 0;
+        }
+
+        MemorySink ms(d, len);
+
+        if (!write_frame(ms, sz))
+        {
+            return 0;
+        }
+
+        dst.commit(len);
+
+        return len;
+    }
+
+    // Appends the serialized HOB to dst, returns the number of bytes added.
+    // The bytes added are zero filled before being written, as vectors do:
+    // serialize_to(Buffer &) doesn't.
+    //
+    size_t serialize_to(vector<uint8_t> &dst) const
+    {
+        if (UNDEFINED == _id)
+        {
+            return 0;
+        }
+
+        const uint8_t *p = NULL;
+        size_t         n = 0;
+
+        if (encoded(p, n))
+        {
+            dst.insert(dst.end(), p, p + n);
+
+            return n;
+        }
+
+        Sizes sizes;
+
+        size_t sz = has_payload(_id) ? _l() : 0;
+        size_t len = _l(_id) + (has_payload(_id) ? (_l(sz) + sz) : 0);
+
+        sizes.replay();
+        size_t at = dst.size();
+
+        dst.resize(at + len);
+
+        MemorySink ms(&dst[at], len);
+
+        if (!write_frame(ms, sz))
+        {
+            dst.resize(at);
+
+            return 0;
+        }
+
+        return len;
+    }
+
+    bool operator==(const HOB &ref) const
+    {
+        bool rv = (_id == ref._id);
+
+        return rv;
+    }
+
+    bool operator!=(const HOB &ref) const
+    {
+        bool rv = (_id != ref._id);
+
+        return rv;
+    }
+
+    // 64 bits hash of the UID and of the fields, as serialized but for the
+    // integers taken at their full width, the vectors of numbers as laid in
+    // memory and the pairs of the unordered maps in any order. Equal HOBs
+    // hash the same, but for floating point zeros of opposite sign.
+    //
+    uint64_t content_hash(uint64_t seed = 0) const
+    {
+        DigestSink ds(seed);
+
+        (void)(_w(ds, _id) && _w(ds));
+
+        return ds.value();
+    }
+
+    // Hash functor of the unordered containers keyed by HOBs:
+    //
+    //     unordered_map<HOB::HashedKey<MyStruct>, Entry, HOB::ContentHash> m;
+    //
+    struct ContentHash
+    {
+        template<class T>
+        size_t operator()(const T &v) const
+        {
+            return static_cast<size_t>(v.content_hash());
+        }
+    };
+
+    // A HOB along with its content hash, evaluated once: unequal hashes
+    // tell unequal HOBs without comparing their fields
+    //
+    template<class T>
+    class HashedKey
+    {
+    public:
+        HashedKey() : _v(), _h(_v.content_hash()) {}
+
+        HashedKey(const T &v) : _v(v), _h(v.content_hash()) {}
+
+        inline const T &value() const { return _v; }
+
+        inline operator const T &() const { return _v; }
+
+        inline uint64_t content_hash() const { return _h; }
+
+        bool operator==(const HashedKey &ref) const
+        {
+            return (_h == ref._h) && (_v == ref._v);
+        }
+
+        bool operator!=(const HashedKey &ref) const
+        {
+            return !(*this == ref);
+        }
+
+    private:
+        T        _v;
+        uint64_t _h;
+    };
+
+    operator size_t() const
+    {
+        const uint8_t *p = NULL;
+        size_t         n = 0;
+
+        if (encoded(p, n))
+        {
+            return n;
+        }
+
+        size_t at = Sizes::reserve(this);
+        size_t sz = _l();
+
+        Sizes::record(at, sz);
+
+        return _l(_id) + ((sz > 0) ? ( _l(sz) + sz ) : 0);
+    }
+
+    operator bool() const
+    {
+        return is_changed();
+    }
+
+    // Deprecated: the payload is read along with the UID and decoded from
+    // memory, as many times as needed, the stream is never sought back.
+    // Only tells whether a payload was read.
+    //
+    DEPRECATED bool rewind()
+    {
+        return (NULL != _pl) && !_pl->empty();
+    }
+
+    void operator~()
+    {
+        reset_changes();
+    }
+
+    const string operator()(const Dump &dump = TEXT) const
+    {
+        stringstream ss;
+
+        ss.str(string());
+
+        _s(ss, (JSON == dump) ? 0 : -1);
+
+        return ss.str();
+    }
+
+    class Buffer: public stringbuf
+    {
+    public:
+        Buffer(size_t reserve_=0)
+            : stringbuf()
+            , _buffer  (NULL)
+            , _size    (0)
+            , _capacity(0)
+        {
+            reserve(reserve_);
+        }
+
+        ~Buffer()
+        {
+            free(_buffer);
+        }
+
+        const uint8_t *data    () const { return _buffer  ; }
+        size_t         size    () const { return _size    ; }
+        size_t         capacity() const { return _capacity; }
+
+        void reserve(const size_t &s)
+        {
+            if (s > _capacity)
+            {
+                _buffer = reinterpret_cast<uint8_t*>(realloc(_buffer,s));
+
+                _capacity = s;
+            }
+        }
+
+        void clear() { _size = 0; }
+
+        // Room for n more bytes past the data, as is (not zero filled),
+        // NULL if it can't be allocated: commit() the bytes written there
+        //
+        uint8_t *room(const size_t &n)
+        {
+            if ((_size + n) > _capacity)
+            {
+                reserve(max(_size + n, 2 * _capacity));
+            }
+
+            return (NULL != _buffer) ? (_buffer + _size) : NULL;
+        }
+
+        void commit(const size_t &n) { _size += n; }
+
+        void log(const string & h)
+        {
+            cerr << h
+                 << " - Capacity: "
+                 << _capacity
+                 << " Size: "
+                 << _size
+                 << endl;
+        }
+
+    private:
+        uint8_t *_buffer;
+        size_t   _size;
+        size_t   _capacity;
+
+        virtual int_type overflow(int_type c)
+        {
+            if (c != traits_type::eof())
+            {
+                if ((_size + 1) > _capacity)
+                {
+                    reserve((_size + 1) * 1.2);
+                }
+
+                if (NULL != _buffer)
+                {
+                    _buffer[_size++] = traits_type::to_char_type(c);
+                }
+            }
+
+            return traits_type::not_eof(c);
+        }
+
+        virtual streamsize xsputn(const char *s, streamsize n)
+        {
+            size_t l = static_cast<size_t>(n);
+
+            if ((_size + l) > _capacity)
+            {
+                reserve((_size + l) * 1.2);
+            }
+
+            if (NULL == _buffer)
+            {
+                return 0;
+            }
+
+            memcpy(&_buffer[_size], s, l);
+
+            _size += l;
+
+            return n;
+        }
+    };
+
+    //
+    // Read only view of a serialized HOB held in memory (mmap'd file, socket
+    // receive buffer, shared memory, ...)
+    //
+    // The frame at the start of the span is validated on construction, the
+    // typed HOBs then decode their payload straight from the span:
+    //
+    //     HOB::View v(data, size);
+    //
+    //     if (my_struct << v) { ... }
+    //
+    //     data += v.consumed(); // next frame, if any
+    //
+    // Nothing is ever read past the end of the span.
+    //
+    class View
+    {
+    public:
+        View(const uint8_t *data, size_t size)
+            : _id(UNDEFINED)
+            , _pl(NULL)
+            , _ps(0)
+            , _fl(0)
+        {
+            if (NULL == data)
+            {
+                return;
+            }
+
+            const uint8_t *p = data;
+            const uint8_t *e = data + size;
+
+            uint64_t id_ = UNDEFINED;
+            uint64_t sz_ = 0;
+
+            if (!varint_take(p, e, id_)
+                ||
+                (has_payload(id_) && !varint_take(p, e, sz_))
+                ||
+                (sz_ > static_cast<size_t>(e - p))
+                ||
+                (sz_ > limits().frame))
+            {
+                return;
+            }
+
+            _id = id_;
+            _pl = p;
+            _ps = sz_;
+            _fl = (p - data) + sz_;
+        }
+
+        // HOB ID, UNDEFINED if the span does not start with a whole frame
+        //
+        inline const UID &id() const { return _id; }
+
+        // Bytes taken by the frame, 0 if the span does not start with a
+        // whole frame
+        //
+        inline size_t consumed() const { return _fl; }
+
+        inline const uint8_t *payload() const { return _pl; }
+
+        inline size_t payload_size() const { return _ps; }
+
+    private:
+        UID            _id;
+        const uint8_t *_pl;
+        size_t         _ps;
+        size_t         _fl;
+    };
+
+    //
+    // Owned, immutable copy of a serialized HOB: the ID and the payload are
+    // held in a single reference counted allocation, so that frames are
+    // cheap to copy, to queue, and to hand to other threads to be decoded
+    // there into the typed HOBs:
+    //
+    //     HOB::Frame f;
+    //
+    //     while (f << is) { queue.push(f); }  // reader thread
+    //
+    //     if (my_struct << f) { ... }         // worker threads
+    //
+    // Only the reference count is ever updated, atomically.
+    //
+    class Frame
+    {
+    public:
+        Frame(): _b(NULL) {}
+
+        Frame(const View &v)
+            : _b(NULL)
+        {
+            if (v.consumed() > 0)
+            {
+                _b = alloc(v.id(), v.payload_size());
+
+                memcpy(data(), v.payload(), v.payload_size());
+            }
+        }
+
+        Frame(const Frame &ref)
+            : _b(ref._b)
+        {
+            retain();
+        }
+
+        ~Frame()
+        {
+            release();
+        }
+
+        Frame & operator=(const Frame &ref)
+        {
+            if (_b != ref._b)
+            {
+                release();
+
+                _b = ref._b;
+
+                retain();
+            }
+
+            return *this;
+        }
+
+        // Reads the next frame from the stream in a new allocation: the
+        // frames already read, and their copies, are left untouched
+        //
+        bool operator<<(istream &is_)
+        {
+            HOB      h;
+            uint64_t id_ = UNDEFINED;
+            size_t   sz_ = 0;
+
+            if (!h.read_header(is_, id_, sz_))
+            {
+                return false;
+            }
+
+            Block *b = alloc(id_, sz_);
+
+            if ((sz_ > 0) && !h.deserialize(is_, b + 1, sz_))
+            {
+                ::operator delete(b);
+
+                return false;
+            }
+
+            release();
+
+            _b = b;
+
+            return true;
+        }
+
+        // Writes the frame as read: the payload is not encoded again
+        //
+        bool operator>>(ostream &os) const
+        {
+            if (empty())
+            {
+                return false;
+            }
+
+            return _w(os, _b->id)
+                   &&
+                   (!has_payload(_b->id)
+                    ||
+                    (_w(os, _b->size)
+                     &&
+                     ((0 == _b->size) || ASSERT_SWRITE(os, payload(), _b->size))));
+        }
+
+        inline bool empty() const { return (NULL == _b); }
+
+        inline UID id() const { return empty() ? UNDEFINED : _b->id; }
+
+        inline const uint8_t *payload() const
+        {
+            return empty() ? NULL : reinterpret_cast<const uint8_t *>(_b + 1);
+        }
+
+        inline size_t payload_size() const { return empty() ? 0 : _b->size; }
+
+    private:
+        struct Block
+        {
+            ATOMIC_LONG refs;
+            UID         id;
+            size_t      size;
+            // followed by the payload bytes
+        };
+
+        Block *_b;
+
+        static Block *alloc(const UID &id_, size_t sz_)
+        {
+            Block *b = new (::operator new(sizeof(Block) + sz_)) Block;
+
+            b->refs = 1;
+            b->id   = id_;
+            b->size = sz_;
+
+            return b;
+        }
+
+        inline uint8_t *data() { return reinterpret_cast<uint8_t *>(_b + 1); }
+
+        inline void retain()
+        {
+            if (NULL != _b)
+            {
+                (void)ATOMIC_ADD(_b->refs, 1);
+            }
+        }
+
+        inline void release()
+        {
+            if ((NULL != _b) && (0 == ATOMIC_ADD(_b->refs, -1)))
+            {
+                ::operator delete(_b);
+            }
+
+            _b = NULL;
+        }
+    };
+
+    template<class T>
+    class StreamWrapper
+    {
+    public:
+        StreamWrapper(T &s): _str_ref(s) {}
+
+        T & operator()(void) { return _str_ref; }
+
+    private:
+        T & _str_ref;
+    };
+
+    typedef StreamWrapper<istream> Src;
+    typedef StreamWrapper<ostream> Snk;
+
+    // Integer vector serialized by the adaptive packed codecs (see _wp)
+    //
+    template<class T>
+    class packed: public vector<T>
+    {
+    public:
+        packed() {}
+
+        packed(size_t n, const T &v = T()): vector<T>(n, v) {}
+
+        packed(const vector<T> &v): vector<T>(v) {}
+
+        template<class I>
+        packed(I first, I last): vector<T>(first, last) {}
+    };
+
+    // Floating point series serialized by the XOR codec (see _wg)
+    //
+    template<class T>
+    class series: public vector<T>
+    {
+    public:
+        series() {}
+
+        series(size_t n, const T &v = T()): vector<T>(n, v) {}
+
+        series(const vector<T> &v): vector<T>(v) {}
+
+        template<class I>
+        series(I first, I last): vector<T>(first, last) {}
+    };
+
+    // Map held as a vector of pairs sorted by key: no allocation per pair,
+    // serialized as map<K,V>
+    //
+    template<class K, class V>
+    class flat_map: public vector<pair<K,V> >
+    {
+    public:
+        typedef K                                           key_type;
+        typedef V                                           mapped_type;
+        typedef pair<K,V>                                   value_type;
+        typedef typename vector<value_type>::iterator       iterator;
+        typedef typename vector<value_type>::const_iterator const_iterator;
+
+        using vector<value_type>::insert;
+        using vector<value_type>::erase;
+
+        iterator lower_bound(const K &k)
+        {
+            return std::lower_bound(this->begin(), this->end(), k, Less());
+        }
+
+        const_iterator lower_bound(const K &k) const
+        {
+            return std::lower_bound(this->begin(), this->end(), k, Less());
+        }
+
+        iterator find(const K &k)
+        {
+            iterator it = lower_bound(k);
+
+            return ((it != this->end()) && !(k < it->first)) ? it
+                                                             : this->end();
+        }
+
+        const_iterator find(const K &k) const
+        {
+            const_iterator it = lower_bound(k);
+
+            return ((it != this->end()) && !(k < it->first)) ? it
+                                                             : this->end();
+        }
+
+        size_t count(const K &k) const
+        {
+            return (find(k) != this->end()) ? 1 : 0;
+        }
+
+        pair<iterator,bool> insert(const value_type &p)
+        {
+            iterator it = lower_bound(p.first);
+
+            if ((it != this->end()) && !(p.first < it->first))
+            {
+                return make_pair(it, false);
+            }
+
+            return make_pair(vector<value_type>::insert(it, p), true);
+        }
+
+        V &operator[](const K &k)
+        {
+            return insert(value_type(k, V())).first->second;
+        }
+
+        size_t erase(const K &k)
+        {
+            iterator it = find(k);
+
+            if (it == this->end())
+            {
+                return 0;
+            }
+
+            vector<value_type>::erase(it);
+
+            return 1;
+        }
+
+        // Sorts the pairs by key, of the pairs with the same key the last
+        // one wins
+        //
+        void sort()
+        {
+            std::stable_sort(this->begin(), this->end(), Less());
+
+            iterator o = this->begin();
+
+            for (iterator i = this->begin(); i != this->end(); ++i)
+            {
+                if ((i + 1 != this->end()) && !(i->first < (i + 1)->first))
+                {
+                    continue;
+                }
+
+                if (o != i)
+                {
+                    *o = *i;
+                }
+
+                ++o;
+            }
+
+            vector<value_type>::erase(o, this->end());
+        }
+
+    private:
+        struct Less
+        {
+            bool operator()(const value_type &a, const K &b) const
+            {
+                return a.first < b;
+            }
+
+            bool operator()(const value_type &a, const value_type &b) const
+            {
+                return a.first < b.first;
+            }
+        };
+    };
+
+    static bool parse(Src &is, Snk &os)
+    {
+        return parse(is(),os(),'\0');
+    }
+
+protected:
+    // Direct to memory sink: the same write() ... good() interface used by
+    // the writers on ostream, with plain pointer bumps (see serialize_to)
+    //
+    class MemorySink
+    {
+    public:
+        MemorySink(uint8_t *dst, size_t cap)
+            : _p(dst)
+            , _e(dst + cap)
+            , _ok(true)
+        {
+        }
+
+        inline MemorySink &write(const char *s, size_t n)
+        {
+            if (_ok && (n <= static_cast<size_t>(_e - _p)))
+            {
+                memcpy(_p, s, n);
+
+                _p += n;
+            }
+            else
+            {
+                _ok = false;
+            }
+
+            return *this;
+        }
+
+        inline bool good() const { return _ok; }
+
+        inline const uint8_t *tell() const { return _p; }
+
+        // Room for n bytes at the write position, NULL if there is not: the
+        // bytes written there are kept by skip()
+        //
+        inline uint8_t *room(size_t n)
+        {
+            return (_ok && (n <= static_cast<size_t>(_e - _p))) ? _p : NULL;
+        }
+
+        inline void skip(size_t n) { _p += n; }
+
+    private:
+        uint8_t *_p;
+        uint8_t *_e;
+        bool     _ok;
+    };
+
+    // Digest sink: the same write() ... good() interface, hashing the bytes
+    // written a block at a time instead of keeping them (see content_hash)
+    //
+    class DigestSink
+    {
+    public:
+        DigestSink(uint64_t seed = 0)
+            : _h(seed)
+            , _n(0)
+        {
+        }
+
+        DigestSink &write(const char *s, size_t n)
+        {
+            const uint8_t *p = reinterpret_cast<const uint8_t *>(s);
+
+            if (n < (sizeof(_b) - _n))
+            {
+                memcpy(&_b[_n], p, n);
+
+                _n += n;
+
+                return *this;
+            }
+
+            if (_n > 0)
+            {
+                size_t c = min(n, sizeof(_b) - _n);
+
+                memcpy(&_b[_n], p, c);
+
+                _n += c;
+                p  += c;
+                n  -= c;
+
+                if (_n < sizeof(_b))
+                {
+                    return *this;
+                }
+
+                _h = digest(_b, sizeof(_b), _h);
+                _n = 0;
+            }
+
+            for (; n >= sizeof(_b); p += sizeof(_b), n -= sizeof(_b))
+            {
+                _h = digest(p, sizeof(_b), _h);
+            }
+
+            memcpy(_b, p, n);
+
+            _n = n;
+
+            return *this;
+        }
+
+        inline bool good() const { return true; }
+
+        inline uint64_t value() const { return digest(_b, _n, _h); }
+
+    private:
+        uint8_t  _b[128];
+        uint64_t _h;
+        size_t   _n;
+    };
+
+    // Payload sizes of the nested HOBs, recorded by the size pass of a
+    // serialization and taken back by its write pass, in the same order.
+    // One per call, on the stack of the serializing thread: the HOBs being
+    // serialized are left untouched, so that a const HOB can be serialized
+    // by many threads at once. A HOB not matching the next recorded size
+    // has its size evaluated again. The first sizes are kept in place, the
+    // others (large trees) on the heap.
+    //
+    class Sizes
+    {
+    public:
+        Sizes()
+            : _up(current())
+            , _n(0)
+            , _rd(0)
+            , _rec(true)
+        {
+            current() = this;
+        }
+
+        ~Sizes() { current() = _up; }
+
+        // The size pass is over, the write pass follows
+        //
+        inline void replay() { _rec = false; _rd = 0; }
+
+        // Slot of the size of v, taken before the sizes of its nested HOBs
+        //
+        static size_t reserve(const HOB *v)
+        {
+            Sizes *s = current();
+
+            if ((NULL == s) || !s->_rec)
+            {
+                return UNSIZED;
+            }
+
+            if (s->_n >= IN_PLACE)
+            {
+                s->_more.push_back(Entry());
+            }
+
+            s->at(s->_n) = Entry(v);
+
+            return s->_n++;
+        }
+
+        static void record(size_t at, size_t sz)
+        {
+            if (UNSIZED != at)
+            {
+                current()->at(at).sz = sz;
+            }
+        }
+
+        static size_t take(const HOB *v)
+        {
+            Sizes *s = current();
+
+            if ((NULL == s) || s->_rec || (s->_rd >= s->_n)
+                ||
+                (s->at(s->_rd).hob != v))
+            {
+                return UNSIZED;
+            }
+
+            return s->at(s->_rd++).sz;
+        }
+
+    private:
+        Sizes(const Sizes &);
+
+        Sizes & operator=(const Sizes &);
+
+        static const size_t IN_PLACE = 32;
+
+        struct Entry
+        {
+            Entry(const HOB *v = NULL) : hob(v), sz(UNSIZED) {}
+
+            const HOB *hob;
+            size_t     sz;
+        };
+
+        static Sizes *&current()
+        {
+            static THREAD_LOCAL Sizes *s = NULL;
+
+            return s;
+        }
+
+        inline Entry &at(size_t i)
+        {
+            return (i < IN_PLACE) ? _in[i] : _more[i - IN_PLACE];
+        }
+
+        Sizes        *_up;
+        Entry         _in[IN_PLACE];
+        vector<Entry> _more;
+        size_t        _n;
+        size_t        _rd;
+        bool          _rec;
+    };
+
+    // Nesting level of the HOBs (or text groups) being decoded by the
+    // current thread, past the limit while false
+    //
+    class Nesting
+    {
+    public:
+        Nesting(size_t max = limits().depth) : _ok(++level() <= max) {}
+
+        ~Nesting() { --level(); }
+
+        inline operator bool() const { return _ok; }
+
+    private:
+        Nesting(const Nesting &);
+
+        Nesting & operator=(const Nesting &);
+
+        static size_t &level()
+        {
+            static THREAD_LOCAL size_t l = 0;
+
+            return l;
+        }
+
+        bool _ok;
+    };
+
+    // Memory source: the subset of the istream interface used by the
+    // readers, checked against the end of the span (see View)
+    //
+    class MemorySource
+    {
+    public:
+        MemorySource(const uint8_t *src, size_t len)
+            : _p(src)
+            , _e(src + len)
+            , _ok(true)
+        {
+        }
+
+        inline MemorySource &read(char *d, size_t n)
+        {
+            if (_ok && (n <= size()))
+            {
+                memcpy(d, _p, n);
+
+                _p += n;
+            }
+            else
+            {
+                _ok = false;
+            }
+
+            return *this;
+        }
+
+        inline bool good() const { return _ok; }
+
+        inline bool eof() const { return (_p >= _e); }
+
+        inline const uint8_t *data() const { return _p; }
+
+        inline const uint8_t *end() const { return _e; }
+
+        inline size_t size() const { return static_cast<size_t>(_e - _p); }
+
+        inline void skip(size_t n) { _p += (n < size()) ? n : size(); }
+
+    private:
+        const uint8_t *_p;
+        const uint8_t *_e;
+        bool           _ok;
+    };
+
+public:
+    // Sender side of a stream of delta frames of a HOBSTRUCT: each frame
+    // holds the sequence number, the fields present and those fields. The
+    // first frame, one every 'every' frames (none for 0) and the one after
+    // resync() hold every field: they are snapshots. The other frames hold
+    // the fields changed (set or touched) since the previous one.
+    //
+    //     HOB::DeltaWriter w(100);
+    //
+    //     myState.set_position(p);
+    //
+    //     w.write(myState, stream); // only position, then ~myState
+    //
+    class DeltaWriter
+    {
+    public:
+        DeltaWriter(size_t every = 0)
+            : _seq(0)
+            , _every(every)
+            , _full(true)
+        {
+        }
+
+        // Next frame is a snapshot
+        //
+        inline void resync() { _full = true; }
+
+        inline uint64_t sequence() const { return _seq; }
+
+        template<class T>
+        bool write(T &v, ostream &os)
+        {
+            return v.write_delta(os, _seq, fields(v)) && sent(v);
+        }
+
+        // Appends the delta frame to dst, returns the number of bytes added
+        //
+        template<class T>
+        size_t write(T &v, vector<uint8_t> &dst)
+        {
+            bitset<T::_FIELDS_COUNT_> d = fields(v);
+
+            size_t at  = dst.size();
+            size_t len = v.delta_size(_seq, d);
+
+            dst.resize(at + len);
+
+            MemorySink ms(&dst[0] + at, len);
+
+            if (!v.write_delta(ms, _seq, d))
+            {
+                dst.resize(at);
+
+                return 0;
+            }
+
+            (void)sent(v);
+
+            return len;
+        }
+
+    private:
+        template<class T>
+        bitset<T::_FIELDS_COUNT_> fields(const T &v)
+        {
+            if (_full || ((_every > 0) && (0 == (_seq % _every))))
+            {
+                return bitset<T::_FIELDS_COUNT_>().set();
+            }
+
+            return v.changes();
+        }
+
+        template<class T>
+        bool sent(T &v)
+        {
+            ~v;
+
+            _full = false;
+
+            _seq++;
+
+            return true;
+        }
+
+        uint64_t _seq;
+        size_t   _every;
+        bool     _full;
+    };
+
+    // Receiver side of a stream of delta frames: a snapshot is applied as
+    // is, a partial frame only on top of the previous one in sequence. Out
+    // of sequence (lost) frames are not applied and leave the reader out
+    // of sync, until the next snapshot: the sender is to be asked for one.
+    //
+    class DeltaReader
+    {
+    public:
+        DeltaReader()
+            : _next(0)
+            , _synced(false)
+        {
+        }
+
+        inline bool synced() const { return _synced; }
+
+        // Applies the delta frame in f to v, false when not a delta frame
+        // of v, malformed or out of sequence
+        //
+        template<class T>
+        bool read(T &v, const View &f)
+        {
+            if (f.id() != T::DELTA_ID())
+            {
+                return false;
+            }
+
+            MemorySource is_(f.payload(), f.payload_size());
+
+            return apply(v, is_);
+        }
+
+        // Reads the next frame from is_, and applies it to v if a delta
+        // frame of v
+        //
+        // Returns 1 if the frame was applied, 0 if it was skipped (not a
+        // delta frame of v, malformed or out of sequence), -1 on errors or
+        // at the end of the stream, as read_from()
+        //
+        template<class T>
+        int read(T &v, istream &is_)
+        {
+            HOB     &h   = v;
+            uint64_t id_ = UNDEFINED;
+            size_t   sz_ = 0;
+
+            if (!h.read_header(is_, id_, sz_))
+            {
+                return -1;
+            }
+
+            if (id_ != T::DELTA_ID())
+            {
+                return skip_payload(is_, sz_) ? 0 : -1;
+            }
+
+            _b.resize(sz_);
+
+            if ((sz_ > 0) && !h.deserialize(is_, &_b[0], sz_))
+            {
+                return -1;
+            }
+
+            MemorySource ms((sz_ > 0) ? &_b[0] : NULL, sz_);
+
+            return apply(v, ms) ? 1 : 0;
+        }
+
+    private:
+        template<class T>
+        bool apply(T &v, MemorySource &is_)
+        {
+            HOB                      &h   = v;
+            uint64_t                  seq = 0;
+            bitset<T::_FIELDS_COUNT_> d;
+
+            if (!h._r(is_, seq) || !h._r(is_, d))
+            {
+                return false;
+            }
+
+            if ((d.count() < d.size()) && (!_synced || (seq != _next)))
+            {
+                _synced = false;
+
+                return false;
+            }
+
+            if (!v.read_delta(is_, d))
+            {
+                _synced = false;
+
+                return false;
+            }
+
+            _next   = seq + 1;
+            _synced = true;
+
+            return true;
+        }
+
+        uint64_t        _next;
+        bool            _synced;
+        vector<uint8_t> _b;
+    };
+
 protected:
     //========================================================================
     //
-    // Variable integer (VARINT) are packed in 1 to 9 bytes
+    // Variable integer (VARINT) are packed in 1 to 9 bytes
+    //
+    // The MSb bits in the MSB byte identify how many bytes are required
+    // to store the numeric value.
+    //
+    // x: single bit
+    // X: single byte (8 bits)
+    //
+    // 1 byte  [numeric value encoded in  7 bits]: 0xxxxxxx
+    // 2 bytes [numeric value encoded in 14 bits]: 10xxxxxx.X
+    // 3 bytes [numeric value encoded in 21 bits]: 110xxxxx.X.X
+    // 4 bytes [numeric value encoded in 28 bits]: 1110xxxx.X.X.X
+    // 5 bytes [numeric value encoded in 35 bits]: 11110xxx.X.X.X.X
+    // 6 bytes [numeric value encoded in 42 bits]: 111110xx.X.X.X.X.X
+    // 7 bytes [numeric value encoded in 49 bits]: 1111110x.X.X.X.X.X.X
+    // 8 bytes [numeric value encoded in 56 bits]: 11111110.X.X.X.X.X.X.X
+    // 9 bytes [numeric value encoded in 64 bits]: 11111111.X.X.X.X.X.X.X.X
+    //
+    // Signed Integer values are zigzag encoded by mapping negative values
+    // to positive values while going back and forth:
+    //
+    // (0=0, -1=1, 1=2, -2=3, 2=4, -3=5, 3=6 ...)
+    //
+    //========================================================================
+
+    //========================================================================
+    //
+    // VARINT codec core
+    //
+    // The packed length is taken from the count of significant bits of the
+    // value when packing, and from the count of leading ones of the first
+    // byte when unpacking.
+    // The value bytes are then moved at once as a big endian 64 bits word,
+    // so packing and unpacking don't need any per byte loop.
+    //
+    //========================================================================
+
+    // Count of significant bits of v (at least 1)
+    //
+    static inline uint8_t msb(const uint64_t &v)
+    {
+#if defined(__GNUC__)
+        return static_cast<uint8_t>(64 - __builtin_clzll(v | 1));
+#else // !__GNUC__
+        uint64_t x = v | 1;
+        uint8_t  n = 1;
+
+        if (x >> 32) { x >>= 32; n += 32; }
+        if (x >> 16) { x >>= 16; n += 16; }
+        if (x >>  8) { x >>=  8; n +=  8; }
+        if (x >>  4) { x >>=  4; n +=  4; }
+        if (x >>  2) { x >>=  2; n +=  2; }
+        if (x >>  1) {           n +=  1; }
+
+        return n;
+#endif // !__GNUC__
+    }
+
+    // Host to big endian (and back) 64 bits word conversion
+    //
+    static inline uint64_t be64(const uint64_t &v)
+    {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        return v;
+#elif defined(__GNUC__)
+        return __builtin_bswap64(v);
+#else // !__GNUC__
+        const uint8_t *b = reinterpret_cast<const uint8_t *>(&v);
+
+        return (static_cast<uint64_t>(b[0]) << 56) |
+               (static_cast<uint64_t>(b[1]) << 48) |
+               (static_cast<uint64_t>(b[2]) << 40) |
+               (static_cast<uint64_t>(b[3]) << 32) |
+               (static_cast<uint64_t>(b[4]) << 24) |
+               (static_cast<uint64_t>(b[5]) << 16) |
+               (static_cast<uint64_t>(b[6]) <<  8) |
+               (static_cast<uint64_t>(b[7])      );
+#endif // !__GNUC__
+    }
+
+    // Reinterpret the bits of a value as a same sized type
+    //
+    template<class T, class F>
+    static inline T pun(const F &f)
+    {
+        T t;
+
+        memcpy(&t, &f, sizeof(t));
+
+        return t;
+    }
+
+    // Host to little endian (and back) conversion of a fixed width value
+    //
+    template<class T>
+    static inline T le(const T &v)
+    {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        uint8_t b[sizeof(T)];
+
+        memcpy(b, &v, sizeof(T));
+
+        for (size_t i=0; i<(sizeof(T)/2); i++)
+        {
+            uint8_t x = b[i];
+
+            b[i] = b[sizeof(T)-1-i];
+
+            b[sizeof(T)-1-i] = x;
+        }
+
+        return pun<T>(b);
+#else // !__ORDER_BIG_ENDIAN__
+        return v;
+#endif // !__ORDER_BIG_ENDIAN__
+    }
+
+    // VARINT length from the value to be packed
+    //
+    static inline uint8_t varint_length(const uint64_t &v)
+    {
+        static const uint8_t length[65] =
+        {
+            1,                      //      0 bits
+            1, 1, 1, 1, 1, 1, 1,    //  1 ..  7 bits
+            2, 2, 2, 2, 2, 2, 2,    //  8 .. 14 bits
+            3, 3, 3, 3, 3, 3, 3,    // 15 .. 21 bits
+            4, 4, 4, 4, 4, 4, 4,    // 22 .. 28 bits
+            5, 5, 5, 5, 5, 5, 5,    // 29 .. 35 bits
+            6, 6, 6, 6, 6, 6, 6,    // 36 .. 42 bits
+            7, 7, 7, 7, 7, 7, 7,    // 43 .. 49 bits
+            8, 8, 8, 8, 8, 8, 8,    // 50 .. 56 bits
+            9, 9, 9, 9, 9, 9, 9, 9  // 57 .. 64 bits
+        };
+
+        return length[msb(v)];
+    }
+
+    // VARINT length from the first packed byte
+    //
+    static inline uint8_t varint_prefix_length(const uint8_t &d0)
+    {
+        // Short, well predicted, paths for the most common 1 to 3 bytes
+        // VARINTs, letting the following ones be decoded speculatively
+
+        if (d0 < 0x80)
+        {
+            return 1;
+        }
+
+        if (d0 < 0xc0)
+        {
+            return 2;
+        }
+
+        if (d0 < 0xe0)
+        {
+            return 3;
+        }
+
+#if defined(__GNUC__)
+        return static_cast<uint8_t>(
+                   __builtin_clz(~(static_cast<uint32_t>(d0) << 24)) + 1);
+#else // !__GNUC__
+        uint8_t b = 1;
+
+        for (uint8_t m = 0x80; (m != 0) && (d0 & m); m >>= 1)
+        {
+            b++;
+        }
+
+        return b;
+#endif // !__GNUC__
+    }
+
+    // Pack v in d, returns the count of bytes used.
+    //
+    // d shall address at least 9 writable bytes.
+    //
+    static inline uint8_t varint_pack(uint8_t *d, const uint64_t &v)
+    {
+        // Short paths for the most common 1 to 3 bytes values
+
+        if (v < 0x80)
+        {
+            d[0] = static_cast<uint8_t>(v);
+
+            return 1;
+        }
+
+        if (v < 0x4000)
+        {
+            d[0] = static_cast<uint8_t>(0x80 | (v >> 8));
+            d[1] = static_cast<uint8_t>(v);
+
+            return 2;
+        }
+
+        if (v < 0x200000)
+        {
+            d[0] = static_cast<uint8_t>(0xc0 | (v >> 16));
+            d[1] = static_cast<uint8_t>(v >> 8);
+            d[2] = static_cast<uint8_t>(v);
+
+            return 3;
+        }
+
+        uint8_t  b = varint_length(v);
+        uint64_t w;
+
+        if (b < 9)
+        {
+            w  = static_cast<uint64_t>((0xff << (9-b)) & 0xff) << (8*(b-1));
+            w |= v;
+            w  = be64(w << (8*(8-b)));
+
+            memcpy(d, &w, sizeof(w));
+        }
+        else
+        {
+            w = be64(v);
+
+            d[0] = 0xff;
+
+            memcpy(&d[1], &w, sizeof(w));
+        }
+
+        return b;
+    }
+
+    // Unpack the b bytes long VARINT in d.
+    //
+    // d shall address at least 8 readable bytes (9 when b is 9), bytes past
+    // the b-th one are ignored.
+    //
+    static inline uint64_t varint_unpack(const uint8_t *d, const uint8_t &b)
+    {
+        // Short paths for the most common 1 to 3 bytes VARINTs
+
+        if (b < 4)
+        {
+            if (1 == b)
+            {
+                return d[0];
+            }
+
+            if (2 == b)
+            {
+                return (static_cast<uint64_t>(d[0] & 0x3f) << 8) | d[1];
+            }
+
+            return (static_cast<uint64_t>(d[0] & 0x1f) << 16)
+                   |
+                   (static_cast<uint64_t>(d[1]) << 8)
+                   |
+                   d[2];
+        }
+
+        uint64_t w;
+
+        if (b < 9)
+        {
+            memcpy(&w, d, sizeof(w));
+
+            w = be64(w) >> (8*(8-b));
+
+            return w & ((1llu << (7*b)) - 1);
+        }
+
+        memcpy(&w, &d[1], sizeof(w));
+
+        return be64(w);
+    }
+
+    // Count of leading 1 byte VARINTs in the 16 bytes at s
+    //
+    static inline uint8_t varint_short_run(const uint8_t *s)
+    {
+#if defined(__SSE2__)
+        uint32_t m = static_cast<uint32_t>(
+                         _mm_movemask_epi8(
+                             _mm_loadu_si128(
+                                 reinterpret_cast<const __m128i *>(s))));
+
+        return (0 == m) ? 16 : static_cast<uint8_t>(__builtin_ctz(m));
+#else // !__SSE2__
+        uint8_t k = 0;
+
+        while ((k < 16) && (s[k] < 0x80))
+        {
+            k++;
+        }
+
+        return k;
+#endif // !__SSE2__
+    }
+
+    // Unpacked VARINT to integer type conversion, signed types are ZIGZAG
+    // decoded
+    //
+    template<class T>
+    struct Zigzag
+    {
+        static inline T decode(const uint64_t &r)
+        {
+            return static_cast<T>(r);
+        }
+    };
+
+    // Bulk VARINTs unpacking
+    //
+    // Unpacks up to n VARINTs from [s,e) in d, stopping at the first VARINT
+    // not entirely available in [s,e).
+    // Where the next 4 bytes are 1 byte VARINTs, the run is measured 16
+    // bytes at once and widened by a plain loop the compiler can vectorize.
+    // Elsewhere the VARINTs are unpacked one at time by the codec core, so
+    // that multibyte data doesn't pay for the runs lookup.
+    //
+    // Returns the count of unpacked values, s is moved past them.
+    //
+    template<class T>
+    static size_t varint_unpack(const uint8_t *&s,
+                                const uint8_t * e,
+                                T             * d,
+                                size_t          n)
+    {
+        size_t i = 0;
+
+        while ((i < n) && ((e - s) >= 16))
+        {
+            uint32_t h;
+
+            memcpy(&h, s, sizeof(h));
+
+            if (0 == (h & 0x80808080))
+            {
+                size_t k = varint_short_run(s);
+
+                if (k > (n - i))
+                {
+                    k = n - i;
+                }
+
+                for (size_t j=0; j<k; j++)
+                {
+                    d[i+j] = Zigzag<T>::decode(s[j]);
+                }
+
+                i += k;
+                s += k;
+
+                continue;
+            }
+
+            uint8_t b = varint_prefix_length(*s);
+
+            d[i++] = Zigzag<T>::decode(varint_unpack(s, b));
+
+            s += b;
+        }
+
+        while ((i < n) && (s < e))
+        {
+            uint8_t b = varint_prefix_length(*s);
+
+            if ((e - s) < b)
+            {
+                break;
+            }
+
+            uint8_t t[9] = { 0 };
+
+            memcpy(t, s, b);
+
+            d[i++] = Zigzag<T>::decode(varint_unpack(t, b));
+
+            s += b;
+        }
+
+        return i;
+    }
+
+    // Direct access to the get area of a stream buffer
+    //
+    class Window: public streambuf
+    {
+    public:
+        static inline const uint8_t *begin(streambuf *sb)
+        {
+            return reinterpret_cast<const uint8_t *>((sb->*(&Window::gptr))());
+        }
+
+        static inline const uint8_t *end(streambuf *sb)
+        {
+            return reinterpret_cast<const uint8_t *>((sb->*(&Window::egptr))());
+        }
+
+        static inline void consume(streambuf *sb, size_t n)
+        {
+            (sb->*(&Window::gbump))(static_cast<int>(n));
+        }
+
+        // Room left in the put area
+
+        static inline size_t room(streambuf *sb)
+        {
+            return static_cast<size_t>((sb->*(&Window::epptr))()
+                                       -
+                                       (sb->*(&Window::pptr))());
+        }
+
+        static inline void put(streambuf *sb, const void *v, size_t n)
+        {
+            memcpy((sb->*(&Window::pptr))(), v, n);
+
+            (sb->*(&Window::pbump))(static_cast<int>(n));
+        }
+    };
+
+    // Stream state allowing to bypass the iostream sentries: no tied stream
+    // to flush, nor flush after each output operation
+    //
+    static inline bool bare(ios &s)
+    {
+        return s.good()
+               &&
+               (NULL != s.rdbuf())
+               &&
+               (NULL == s.tie())
+               &&
+               (0 == (s.flags() & ios::unitbuf));
+    }
+
+    // Unpacks the VARINT at p, if whole before e
+    //
+    static inline bool varint_take(const uint8_t *&p,
+                                   const uint8_t * e,
+                                   uint64_t      & v)
+    {
+        if (p >= e)
+        {
+            return false;
+        }
+
+        uint8_t b = varint_prefix_length(*p);
+
+        if (b > (e - p))
+        {
+            return false;
+        }
+
+        if ((e - p) >= 9)
+        {
+            v = varint_unpack(p, b);
+        }
+        else
+        {
+            // varint_unpack() loads whole words: never past the end
+
+            uint8_t t[9] = { 0 };
+
+            memcpy(t, p, b);
+
+            v = varint_unpack(t, b);
+        }
+
+        p += b;
+
+        return true;
+    }
+
+    //========================================================================
+    //
+    // Packed integer vectors
+    //
+    // The items, widened to 64 bits words, are packed by whichever of the
+    // following methods gives the smallest size:
+    //
+    // FOR  : blocks of up to 128 words, each one stored as its reference
+    //        word (ZIGZAG VARINT), the bit width of the offsets from the
+    //        reference (VARINT) and the offsets, little endian bit packed
+    // DELTA: as FOR, on the ZIGZAG encoded differences between consecutive
+    //        words
+    // RLE  : count of runs (VARINT), followed by the word (ZIGZAG VARINT)
+    //        and the length (VARINT) of each run
+    //
+    // | items count | method | blocks / runs |
+    // |   VARINT    | VARINT |      ...      |
+    //
+    //========================================================================
+
+    enum Packing
+    {
+        PACKED_FOR,
+        PACKED_DELTA,
+        PACKED_RLE,
+    };
+
+    static const size_t PACKED_BLOCK = 128;
+
+    // Reference of the n words in v: the lowest one, as unsigned or as
+    // signed value, whichever gives the narrowest range.
+    // Returns the bit width of the offsets from the reference.
+    //
+    static inline uint8_t packed_for(const uint64_t *v,
+                                     size_t          n,
+                                     uint64_t       &ref)
+    {
+        uint64_t umin = v[0];
+        uint64_t umax = v[0];
+        int64_t  smin = static_cast<int64_t>(v[0]);
+        int64_t  smax = smin;
+
+        for (size_t i=1; i<n; i++)
+        {
+            int64_t x = static_cast<int64_t>(v[i]);
+
+            umin = (v[i] < umin) ? v[i] : umin;
+            umax = (v[i] > umax) ? v[i] : umax;
+            smin = (x    < smin) ? x    : smin;
+            smax = (x    > smax) ? x    : smax;
+        }
+
+        uint64_t urange = umax - umin;
+        uint64_t srange = static_cast<uint64_t>(smax)
+                          -
+                          static_cast<uint64_t>(smin);
+
+        ref = (srange < urange) ? static_cast<uint64_t>(smin) : umin;
+
+        uint64_t range = (srange < urange) ? srange : urange;
+
+        return (0 == range) ? 0 : msb(range);
+    }
+
+    // ZIGZAG encoded differences between consecutive words
+    //
+    static inline void packed_delta(uint64_t       *d,
+                                    const uint64_t *v,
+                                    size_t          n,
+                                    uint64_t        prev)
+    {
+        for (size_t i=0; i<n; i++)
+        {
+            d[i] = ZIGZAG_ENCODE(v[i] - prev);
+
+            prev = v[i];
+        }
+    }
+
+    // Bit packs the n offsets of v from ref, b bits each, in d.
+    //
+    // d shall address ((n*b+7)/8)+8 zeroed writable bytes.
+    //
+    static inline void bitpack(uint8_t        *d,
+                               const uint64_t *v,
+                               size_t          n,
+                               const uint64_t &ref,
+                               uint8_t         b)
+    {
+        for (size_t i=0; (b > 0) && (i<n); i++)
+        {
+            uint64_t x = v[i] - ref;
+            size_t   o = i * b;
+            uint8_t *p = &d[o >> 3];
+            uint8_t  s = o & 7;
+            uint64_t w;
+
+            memcpy(&w, p, sizeof(w));
+
+            w = le(static_cast<uint64_t>(le(w) | (x << s)));
+
+            memcpy(p, &w, sizeof(w));
+
+            if ((s + b) > 64)
+            {
+                p[8] |= static_cast<uint8_t>(x >> (64 - s));
+            }
+        }
+    }
+
+    // Unpacks n offsets, b bits each, from d and adds them to ref.
+    //
+    // d shall address ((n*b+7)/8)+8 readable bytes.
+    // The loop has no carried dependency, so the compiler can vectorize it.
+    //
+    static inline void bitunpack(uint64_t       *v,
+                                 const uint8_t  *d,
+                                 size_t          n,
+                                 const uint64_t &ref,
+                                 uint8_t         b)
+    {
+        uint64_t m = (b < 64) ? ((1llu << b) - 1) : ~0llu;
+
+        for (size_t i=0; i<n; i++)
+        {
+            size_t         o = i * b;
+            const uint8_t *p = &d[o >> 3];
+            uint8_t        s = o & 7;
+            uint64_t       w;
+
+            memcpy(&w, p, sizeof(w));
+
+            w = le(w) >> s;
+
+            if ((s + b) > 64)
+            {
+                w |= static_cast<uint64_t>(p[8]) << (64 - s);
+            }
+
+            v[i] = ref + (w & m);
+        }
+    }
+
+    static inline size_t packed_block_length(const uint64_t *v, size_t n)
+    {
+        uint64_t ref = 0;
+        uint8_t  b   = packed_for(v, n, ref);
+
+        return _l(ZIGZAG_ENCODE(ref)) + _l(b) + ((n * b + 7) >> 3);
+    }
+
+    template<class S>
+    static bool packed_block(S &os, const uint64_t *v, size_t n)
+    {
+        uint64_t ref = 0;
+        uint8_t  b   = packed_for(v, n, ref);
+        size_t   l   = (n * b + 7) >> 3;
+        uint8_t  d[PACKED_BLOCK * 8 + 9];
+
+        memset(d, 0, l + 9);
+
+        bitpack(d, v, n, ref, b);
+
+        return _w(os, ZIGZAG_ENCODE(ref))
+               &&
+               _w(os, b)
+               &&
+               ((0 == l) || ASSERT_SWRITE(os, d, l));
+    }
+
+    // Widens up to PACKED_BLOCK items from v in w, returns their count
+    //
+    template<class T>
+    static inline size_t packed_words(uint64_t *w, const T *v, size_t n)
+    {
+        size_t m = PACKED_BLOCK;
+
+        if (n < m)
+        {
+            m = n;
+        }
+
+        for (size_t i=0; i<m; i++)
+        {
+            w[i] = static_cast<uint64_t>(v[i]);
+        }
+
+        return m;
+    }
+
+    // Packed length of the n (> 0) items in v, method gets the best method
+    //
+    template<class T>
+    static size_t _lp(const T *v, size_t n, uint8_t &method)
+    {
+        size_t   for_l   = 0;
+        size_t   delta_l = 0;
+        size_t   rle_l   = 0;
+        size_t   runs    = 0;
+        uint64_t prev    = 0;
+        uint64_t w[PACKED_BLOCK];
+        uint64_t d[PACKED_BLOCK];
+
+        for (size_t i=0; i<n; )
+        {
+            size_t m = packed_words(w, &v[i], n - i);
+
+            packed_delta(d, w, m, prev);
+
+            for_l   += packed_block_length(w, m);
+            delta_l += packed_block_length(d, m);
+
+            prev = w[m-1];
+
+            i += m;
+        }
+
+        for (size_t i=0; i<n; runs++)
+        {
+            size_t j = i + 1;
+
+            while ((j < n) && (v[j] == v[i]))
+            {
+                j++;
+            }
+
+            rle_l += _l(ZIGZAG_ENCODE(static_cast<uint64_t>(v[i]))) + _l(j-i);
+
+            i = j;
+        }
+
+        rle_l += _l(runs);
+
+        method = PACKED_FOR;
+
+        size_t len = for_l;
+
+        if (delta_l < len) { method = PACKED_DELTA; len = delta_l; }
+        if (rle_l   < len) { method = PACKED_RLE  ; len = rle_l  ; }
+
+        return _l(method) + len;
+    }
+
+    // Packs the n (> 0) items in v, the items count is not written
+    //
+    template<class T, class S>
+    static bool _wp(S &os, const T *v, size_t n)
+    {
+        uint8_t method = PACKED_FOR;
+
+        _lp(v, n, method);
+
+        if (!_w(os, method))
+        {
+            return false;
+        }
+
+        if (PACKED_RLE == method)
+        {
+            size_t runs = 0;
+
+            for (size_t i=1; i<=n; i++)
+            {
+                runs += (i == n) || (v[i] != v[i-1]);
+            }
+
+            if (!_w(os, runs))
+            {
+                return false;
+            }
+
+            for (size_t i=0; i<n; )
+            {
+                size_t j = i + 1;
+
+                while ((j < n) && (v[j] == v[i]))
+                {
+                    j++;
+                }
+
+                if (!_w(os, ZIGZAG_ENCODE(static_cast<uint64_t>(v[i]))) ||
+                    !_w(os, j - i))
+                {
+                    return false;
+                }
+
+                i = j;
+            }
+
+            return true;
+        }
+
+        uint64_t prev = 0;
+        uint64_t w[PACKED_BLOCK];
+        uint64_t d[PACKED_BLOCK];
+
+        for (size_t i=0; i<n; )
+        {
+            size_t m = packed_words(w, &v[i], n - i);
+
+            if (PACKED_DELTA == method)
+            {
+                packed_delta(d, w, m, prev);
+            }
+
+            if (!packed_block(os, (PACKED_DELTA == method) ? d : w, m))
+            {
+                return false;
+            }
+
+            prev = w[m-1];
+
+            i += m;
+        }
+
+        return true;
+    }
+
+    //========================================================================
+    //
+    // Floating point series (Gorilla XOR codec)
+    //
+    // The items bits, widened to 64 bits words, are XORed with the previous
+    // item ones, then the meaningful bits of the XOR result are bit packed,
+    // most significant bit first:
+    //
+    // '0'                     : same value as the previous item
+    // '10' + bits             : meaningful bits within the window of the
+    //                           previous item
+    // '11' + 6 bits + 6 bits  : count of leading zeros, count of meaningful
+    //   + bits                  bits minus one, meaningful bits
+    //
+    // | items count | first item bits | bitstream size | bitstream   |
+    // |   VARINT    |     VARINT      |     VARINT     | size bytes  |
+    //
+    //========================================================================
+
+    class BitWriter
+    {
+    public:
+        BitWriter(): _acc(0), _n(0) {}
+
+        inline void put(const uint64_t &v, uint8_t n)
+        {
+            if (n > 32)
+            {
+                put(v >> 32, n - 32);
+                put(v      , 32    );
+
+                return;
+            }
+
+            _acc = (_acc << n) | (v & ((1llu << n) - 1));
+            _n  += n;
+
+            while (_n >= 8)
+            {
+                _n -= 8;
+
+                _bytes.push_back(static_cast<uint8_t>(_acc >> _n));
+            }
+        }
+
+        inline const vector<uint8_t> &flush()
+        {
+            if (_n > 0)
+            {
+                _bytes.push_back(static_cast<uint8_t>(_acc << (8 - _n)));
+
+                _n = 0;
+            }
+
+            return _bytes;
+        }
+
+    private:
+        vector<uint8_t> _bytes;
+        uint64_t        _acc;
+        uint8_t         _n;
+    };
+
+    class BitCounter
+    {
+    public:
+        BitCounter(): _bits(0) {}
+
+        inline void put(const uint64_t &v, uint8_t n) { (void)v; _bits += n; }
+
+        inline size_t bytes() const { return (_bits + 7) >> 3; }
+
+    private:
+        size_t _bits;
+    };
+
+    class BitReader
+    {
+    public:
+        BitReader(const uint8_t *s, const uint8_t *e)
+            : _p(s), _e(e), _acc(0), _n(0), _ok(true) {}
+
+        inline uint64_t get(uint8_t n)
+        {
+            if (n > 32)
+            {
+                uint64_t h = get(n - 32);
+
+                return (h << 32) | get(32);
+            }
+
+            while (_n < n)
+            {
+                _ok  = _ok && (_p < _e);
+                _acc = (_acc << 8) | (_ok ? *_p++ : 0);
+                _n  += 8;
+            }
+
+            _n -= n;
+
+            return (_acc >> _n) & ((1llu << n) - 1);
+        }
+
+        inline bool good() const { return _ok; }
+
+    private:
+        const uint8_t *_p;
+        const uint8_t *_e;
+        uint64_t       _acc;
+        uint8_t        _n;
+        bool           _ok;
+    };
+
+    // Streaming XOR codec: each call of encode() / decode() handles the
+    // item following the last one handled
+    //
+    class Gorilla
+    {
+    public:
+        Gorilla(const uint64_t &first)
+            : _prev(first), _lz(64), _tz(64), _ok(true) {}
+
+        template<class S>
+        inline void encode(S &bits, const uint64_t &w)
+        {
+            uint64_t x = w ^ _prev;
+
+            _prev = w;
+
+            if (0 == x)
+            {
+                bits.put(0, 1);
+
+                return;
+            }
+
+            uint8_t lz = 64 - msb(x);
+            uint8_t tz = ctz(x);
+
+            if (((_lz + _tz) < 64) && (lz >= _lz) && (tz >= _tz))
+            {
+                bits.put(2, 2);
+                bits.put(x >> _tz, 64 - _lz - _tz);
+
+                return;
+            }
+
+            _lz = lz;
+            _tz = tz;
+
+            bits.put(3, 2);
+            bits.put(_lz, 6);
+            bits.put(63 - _lz - _tz, 6);
+            bits.put(x >> _tz, 64 - _lz - _tz);
+        }
+
+        inline uint64_t decode(BitReader &bits)
+        {
+            if (0 == bits.get(1))
+            {
+                return _prev;
+            }
+
+            if (1 == bits.get(1))
+            {
+                uint8_t lz  = static_cast<uint8_t>(bits.get(6));
+                uint8_t len = static_cast<uint8_t>(bits.get(6) + 1);
+
+                _lz = lz;
+                _tz = ((lz + len) <= 64) ? (64 - lz - len) : 64;
+            }
+
+            if ((_lz + _tz) < 64)
+            {
+                _prev ^= bits.get(64 - _lz - _tz) << _tz;
+            }
+            else
+            {
+                _ok = false; // no valid window
+            }
+
+            return _prev;
+        }
+
+        inline bool good() const { return _ok; }
+
+    private:
+        uint64_t _prev;
+        uint8_t  _lz;
+        uint8_t  _tz;
+        bool     _ok;
+    };
+
+    // Count of trailing zero bits of v (v != 0)
+    //
+    static inline uint8_t ctz(const uint64_t &v)
+    {
+#if defined(__GNUC__)
+        return static_cast<uint8_t>(__builtin_ctzll(v));
+#else // !__GNUC__
+        uint8_t n = 0;
+
+        for (uint64_t x = v; 0 == (x & 1); x >>= 1)
+        {
+            n++;
+        }
+
+        return n;
+#endif // !__GNUC__
+    }
+
+    // Floating point bits as 64 bits word (and back)
+    //
+    // Integer values are sign extended.
+    //
+    template<class T>
+    static inline uint64_t word(const T &v) { return static_cast<uint64_t>(v); }
+
+    static inline uint64_t word(const float  &v) { return pun<uint32_t>(v); }
+    static inline uint64_t word(const double &v) { return pun<uint64_t>(v); }
+
+    template<class T>
+    static inline void unword(const uint64_t &w, T &v)
+    {
+        v = static_cast<T>(w);
+    }
+
+    static inline void unword(const uint64_t &w, float &v)
+    {
+        v = pun<float>(static_cast<uint32_t>(w));
+    }
+
+    static inline void unword(const uint64_t &w, double &v)
+    {
+        v = pun<double>(w);
+    }
+
+    // XOR encoded length of the n (> 0) items in v, the items count excluded
+    //
+    template<class T>
+    static size_t _lg(const T *v, size_t n)
+    {
+        BitCounter bits;
+        Gorilla    codec(word(v[0]));
+
+        for (size_t i=1; i<n; i++)
+        {
+            codec.encode(bits, word(v[i]));
+        }
+
+        return _l(word(v[0])) + _l(bits.bytes()) + bits.bytes();
+    }
+
+    // XOR encodes the n (> 0) items in v, the items count is not written
+    //
+    template<class T, class S>
+    static bool _wg(S &os, const T *v, size_t n)
+    {
+        BitWriter bits;
+        Gorilla   codec(word(v[0]));
+
+        for (size_t i=1; i<n; i++)
+        {
+            codec.encode(bits, word(v[i]));
+        }
+
+        const vector<uint8_t> &b = bits.flush();
+
+        return _w(os, word(v[0]))
+               &&
+               _w(os, b.size())
+               &&
+               (b.empty() || ASSERT_SWRITE(os, &b[0], b.size()));
+    }
+
+    template<class S>
+    static inline bool _w(S &os, const uint8_t &v)
+    {
+        return _w(os, static_cast<const uint64_t &>(v));
+    }
+
+    template<class S>
+    static inline bool _w(S &os, const uint16_t &v)
+    {
+        return _w(os, static_cast<const uint64_t &>(v));
+    }
+
+    template<class S>
+    static inline bool _w(S &os, const uint32_t &v)
+    {
+        return _w(os, static_cast<const uint64_t &>(v));
+    }
+
+    // VARINT packing
+    //
+    template<class S>
+    static inline bool _w(S &os, const uint64_t &v)
+    {
+        uint8_t d[9];
+
+        uint8_t b = varint_pack(d, v);
+
+        return ASSERT_SWRITE(os, d, b);
+    }
+
+    // Packed straight in place, where there is room for the longest VARINT
+    //
+    static inline bool _w(MemorySink &os, const uint64_t &v)
+    {
+        uint8_t *d = os.room(9);
+
+        if (NULL == d)
+        {
+            uint8_t t[9];
+
+            return ASSERT_SWRITE(os, t, varint_pack(t, v));
+        }
+
+        os.skip(varint_pack(d, v));
+
+        return true;
+    }
+
+    // Hashed integers: fixed width, no packing
+    //
+    static inline bool _w(DigestSink &os, const uint64_t &v)
+    {
+        uint64_t w = le(v);
+
+        return ASSERT_SWRITE(os, &w, sizeof(w));
+    }
+
+    template<class S>
+    static inline bool _w(S &os, const int8_t &v)
+    {
+        return _w(os, static_cast<int64_t>(v));
+    }
+
+    template<class S>
+    static inline bool _w(S &os, const int16_t &v)
+    {
+        return _w(os, static_cast<int64_t>(v));
+    }
+
+    template<class S>
+    static inline bool _w(S &os, const int32_t &v)
+    {
+        return _w(os, static_cast<int64_t>(v));
+    }
+
+    // ZIGZAG encoding
+    //
+    template<class S>
+    static inline bool _w(S &os, const int64_t &v)
+    {
+        return _w(os, ZIGZAG_ENCODE(v));
+    }
+
+    template<class S>
+    static inline bool _w(S &os, const bool &v)
+    {
+        return ASSERT_SWRITE(os, &v, sizeof(v));
+    }
+
+    template<class S>
+    static inline bool _w(S &os, const float &v)
+    {
+#if defined(FLOAT_TO_INTEGER_SERIALIZATION)
+        return _w(os, pun<uint32_t>(v));
+#else // !FLOAT_TO_INTEGER_SERIALIZATION
+        return ASSERT_SWRITE(os, &v, sizeof(v));
+#endif // !FLOAT_TO_INTEGER_SERIALIZATION
+    }
+
+    template<class S>
+    static inline bool _w(S &os, const double &v)
+    {
+#if defined(FLOAT_TO_INTEGER_SERIALIZATION)
+        return _w(os, pun<uint64_t>(v));
+#else // !FLOAT_TO_INTEGER_SERIALIZATION
+        return ASSERT_SWRITE(os, &v, sizeof(v));
+#endif // !FLOAT_TO_INTEGER_SERIALIZATION
+    }
+
+    // Fixed width, little endian, packing
+    //
+    template<class T, class S>
+    static inline bool _wf(S &os, const T &v)
+    {
+        T x = le(v);
+
+        return ASSERT_SWRITE(os, &x, sizeof(x));
+    }
+
+    template<class S>
+    static inline bool _w(S &os, const long double &v)
+    {
+        return ASSERT_SWRITE(os, &v, sizeof(v));
+    }
+
+    template<class S>
+    static inline bool _w(S &os, const string &v)
+    {
+        if (!_w(os, v.size()))
+        {
+            return false;
+        }
+
+        return ASSERT_SWRITE(os, v.data(), v.size());
+    }
+
+    template<class S>
+    static inline bool _w(S &os, uint8_t size_, const void *v)
+    {
+        if (!_w(os, size_))
+        {
+            return false;
+        }
+
+        return ASSERT_SWRITE(os, v, size_);
+    }
+
+    template<class S>
+    static bool _w(S &os, const HOB &v)
+    {
+        const uint8_t *p = NULL;
+        size_t         n = 0;
+
+        if (v.encoded(p, n))
+        {
+            return ASSERT_SWRITE(os, p, n);
+        }
+
+        // Payload size recorded by the size pass of the enclosing HOB, if any
+
+        size_t sz = Sizes::take(&v);
+
+        if (UNSIZED == sz)
+        {
+            sz = has_payload(v._id) ? v._l() : 0;
+        }
+
+        return v.write_frame(os, sz);
+    }
+
+    // Hashed nested HOBs: the payload size follows from the fields
+    //
+    static bool _w(DigestSink &os, const HOB &v)
+    {
+        return _w(os, v._id) && v._w(os);
+    }
+
+    template<size_t N, class S>
+    static bool _w(S &os, const std::bitset<N>& v)
+    {
+        return _wbits(os, v, N);
+    }
+
+    //
+    // Bit containers
+    //
+    // The bits are serialized as bytes, LSB first, preceded by the bytes
+    // count. They are converted a storage word at a time, where the layout
+    // of the container is known (libstdc++), a bit at a time elsewhere,
+    // through a fixed size scratch on the stack.
+    //
+    typedef unsigned long BitWord;
+
+    static const size_t BIT_WORD      = sizeof(BitWord) * 8;
+    static const size_t BIT_SCRATCH   = 32; // words
+
+    // The bits of the k-th word within the first n
+    //
+    static inline BitWord bit_mask(size_t k, size_t n)
+    {
+        size_t m = n - (k * BIT_WORD);
+
+        return (m >= BIT_WORD) ? ~BitWord(0) : ((BitWord(1) << m) - 1);
+    }
+
+#if defined(__GLIBCXX__) && !defined(_GLIBCXX_DEBUG)
+    // The words of a bitset<> are its only data, the words of a vector<bool>
+    // are pointed by its iterators
+
+    template<size_t N>
+    static inline BitWord bit_word(const bitset<N> &v, size_t k, size_t n)
+    {
+        return reinterpret_cast<const BitWord *>(&v)[k] & bit_mask(k, n);
+    }
+
+    template<size_t N>
+    static inline void bit_word(bitset<N> &v, size_t k, size_t n, BitWord w)
+    {
+        (void)n;
+
+        reinterpret_cast<BitWord *>(&v)[k] = w;
+    }
+
+    static inline BitWord bit_word(const vector<bool> &v, size_t k, size_t n)
+    {
+        return v.begin()._M_p[k] & bit_mask(k, n);
+    }
+
+    static inline void bit_word(vector<bool> &v, size_t k, size_t n, BitWord w)
+    {
+        (void)n;
+
+        v.begin()._M_p[k] = w;
+    }
+#else // !__GLIBCXX__
+    template<class C>
+    static inline BitWord bit_word(const C &v, size_t k, size_t n)
+    {
+        BitWord w = 0;
+        size_t  j = k * BIT_WORD;
+        size_t  e = j + BIT_WORD;
+
+        for (size_t i=0; (j < e) && (j < n); i++, j++)
+        {
+            w |= static_cast<BitWord>(v[j] ? 1 : 0) << i;
+        }
+
+        return w;
+    }
+
+    template<class C>
+    static inline void bit_word(C &v, size_t k, size_t n, BitWord w)
+    {
+        size_t j = k * BIT_WORD;
+        size_t e = j + BIT_WORD;
+
+        for (; (j < e) && (j < n); j++, w >>= 1)
+        {
+            v[j] = (w & 1);
+        }
+    }
+#endif // !__GLIBCXX__
+
+    // The first n bits of v, as bytes count and bytes
+    //
+    template<class C, class S>
+    static bool _wbits(S &os, const C &v, size_t n)
+    {
+        size_t len = (n + 7) >> 3;
+
+        if (!_w(os, len))
+        {
+            return false;
+        }
+
+        BitWord  t[BIT_SCRATCH];
+        uint8_t *b = reinterpret_cast<uint8_t *>(t);
+
+        for (size_t k=0; len > 0;)
+        {
+            size_t m = 0;
+
+            for (; (m < BIT_SCRATCH) && ((k * BIT_WORD) < n); m++, k++)
+            {
+                t[m] = le(bit_word(v, k, n));
+            }
+
+            size_t c = (len < (m * sizeof(BitWord))) ? len
+                                                     : (m * sizeof(BitWord));
+
+            if (!ASSERT_SWRITE(os, b, c))
+            {
+                return false;
+            }
+
+            len -= c;
+        }
+
+        return true;
+    }
+
+    template<class T, class S>
+    static bool _w(S &os, const vector<T> &v)
+    {
+        if (!_w(os, v.size()))
+        {
+            return false;
+        }
+
+        for (size_t i=0; i<v.size(); i++)
+        {
+            if (!_w(os, static_cast<const T &>(v[i])))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Hashed vectors of numbers: items count followed by the items memory,
+    // in one block
+    //
+    template<class T>
+    static bool _wh(DigestSink &os, const vector<T> &v)
+    {
+        return _w(os, v.size())
+               &&
+               (v.empty() || ASSERT_SWRITE(os, &v[0], v.size() * sizeof(T)));
+    }
+
+    static bool _w(DigestSink &os, const vector<uint16_t> &v) { return _wh(os, v); }
+    static bool _w(DigestSink &os, const vector<uint32_t> &v) { return _wh(os, v); }
+    static bool _w(DigestSink &os, const vector<uint64_t> &v) { return _wh(os, v); }
+    static bool _w(DigestSink &os, const vector<int16_t > &v) { return _wh(os, v); }
+    static bool _w(DigestSink &os, const vector<int32_t > &v) { return _wh(os, v); }
+    static bool _w(DigestSink &os, const vector<int64_t > &v) { return _wh(os, v); }
+    static bool _w(DigestSink &os, const vector<uint8_t > &v) { return _wh(os, v); }
+    static bool _w(DigestSink &os, const vector<int8_t  > &v) { return _wh(os, v); }
+    static bool _w(DigestSink &os, const vector<float   > &v) { return _wh(os, v); }
+    static bool _w(DigestSink &os, const vector<double  > &v) { return _wh(os, v); }
+
+#if defined(CONTIGUOUS_VECTORS)
+    // Contiguous vectors: items count followed by one little endian block
+    //
+    template<class T, class S>
+    static bool _wc(S &os, const vector<T> &v)
+    {
+        if (!_w(os, v.size()))
+        {
+            return false;
+        }
+
+        if (v.empty())
+        {
+            return true;
+        }
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        for (size_t i=0; i<v.size(); i++)
+        {
+            T x = le(v[i]);
+
+            if (!ASSERT_SWRITE(os, &x, sizeof(x)))
+            {
+                return false;
+            }
+        }
+
+        return true;
+#else // !__ORDER_BIG_ENDIAN__
+        return ASSERT_SWRITE(os, &v[0], v.size() * sizeof(T));
+#endif // !__ORDER_BIG_ENDIAN__
+    }
+
+    template<class S>
+    static bool _w(S &os, const vector<uint8_t> &v) { return _wc(os,v); }
+    template<class S>
+    static bool _w(S &os, const vector<int8_t > &v) { return _wc(os,v); }
+    template<class S>
+    static bool _w(S &os, const vector<float  > &v) { return _wc(os,v); }
+    template<class S>
+    static bool _w(S &os, const vector<double > &v) { return _wc(os,v); }
+#endif // CONTIGUOUS_VECTORS
+
+    template<class S>
+    static bool _w(S &os, const vector<bool> &v, bool dump_size=true)
+    {
+        if (dump_size && !_w(os, v.size()))
+        {
+            return false;
+        }
+
+        return _wbits(os, v, v.size());
+    }
+
+    template<class T, class S>
+    static bool _w(S &os, const packed<T> &v)
+    {
+        if (!_w(os, v.size()))
+        {
+            return false;
+        }
+
+        return v.empty() || _wp(os, &v[0], v.size());
+    }
+
+    template<class T, class S>
+    static bool _w(S &os, const series<T> &v)
+    {
+        if (!_w(os, v.size()))
+        {
+            return false;
+        }
+
+        return v.empty() || _wg(os, &v[0], v.size());
+    }
+
+    template<class T, class S>
+    static bool _w(S &os, const optional<T> &v)
+    {
+        if (!_w(os, static_cast<bool>(v)))
+        {
+            return false;
+        }
+
+        if (static_cast<bool>(v))
+        {
+            if (!_w(os, static_cast<const T &>(*v)))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template<class K, class V, class S>
+    static bool _w(S &os, const map<K,V> &v) { return _wm(os, v); }
+
+    template<class K, class V, class S>
+    static bool _w(S &os, const flat_map<K,V> &v) { return _wm(os, v); }
+
+#if defined(HOB_TR1_CONTAINERS)
+    template<class K, class V, class S>
+    static bool _w(S &os, const unordered_map<K,V> &v) { return _wm(os, v); }
+
+    // Hashed unordered maps: the pairs count, then the sum of the hashes
+    // of the pairs, whatever their order
+    //
+    template<class K, class V>
+    static bool _w(DigestSink &os, const unordered_map<K,V> &v)
+    {
+        uint64_t sum = 0;
+
+        for (typename unordered_map<K,V>::const_iterator ci = v.begin();
+             ci != v.end();
+             ++ci)
+        {
+            DigestSink ps;
+
+            (void)(_w(ps, static_cast<const K &>((*ci).first))
+                   &&
+                   _w(ps, static_cast<const V &>((*ci).second)));
+
+            sum += ps.value();
+        }
+
+        return _w(os, v.size()) && _w(os, sum);
+    }
+#endif // HOB_TR1_CONTAINERS
+
+    // Maps: pairs count, followed by the pairs as iterated
+    //
+    template<class M, class S>
+    static bool _wm(S &os, const M &v)
+    {
+        typedef typename M::key_type    K;
+        typedef typename M::mapped_type V;
+
+        size_t len = v.size();
+
+        if (!_w(os, len))
+        {
+            return false;
+        }
+
+        for (typename M::const_iterator ci = v.begin();
+             (len > 0) && (ci != v.end());
+             ++ci)
+        {
+            if (!_w(os, static_cast<const K &>((*ci).first)))
+            {
+                return false;
+            }
+
+            if (!_w(os, static_cast<const V &>((*ci).second)))
+            {
+                return false;
+            }
+
+            len--;
+        }
+
+        return true;
+    }
+
+    template<class K, class S>
+    static bool _w(S &os, const set<K> &v)
+    {
+        if (!_w(os, v.size()))
+        {
+            return false;
+        }
+
+        for (typename set<K>::const_iterator ci = v.begin(); ci != v.end(); ++ci)
+        {
+            if (!_w(os, static_cast<const K &>(*ci)))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+#if defined(HOB_TR1_CONTAINERS)
+    // Fixed size arrays: the items only, their count is told by the type
+    //
+    template<class T, size_t N, class S>
+    static bool _w(S &os, const array<T,N> &v)
+    {
+        for (size_t i=0; i<N; i++)
+        {
+            if (!_w(os, static_cast<const T &>(v[i])))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+#endif // HOB_TR1_CONTAINERS
+
+    //========================================================================
+    //
+    // Hinted encodings
+    //
+    // The value bits, widened to a 64 bits word, are packed as told by the
+    // field encoding hint.
+    //
+    //========================================================================
+
+    static inline CONSTEXPR const char *encoding_name(Encoding e)
+    {
+        return (VARINT  == e) ? "VARINT"  :
+               (ZIGZAG  == e) ? "ZIGZAG"  :
+               (FIXED32 == e) ? "FIXED32" :
+               (FIXED64 == e) ? "FIXED64" :
+               (DELTA   == e) ? "DELTA"   : "";
+    }
+
+    template<class T, class S>
+    static inline bool _w(S &os, const T &v, As<DEFAULT>)
+    {
+        return _w(os, v);
+    }
+
+    template<class T, class S>
+    static inline bool _w(S &os, const T &v, As<VARINT>)
+    {
+        return _w(os, word(v));
+    }
+
+    template<class T, class S>
+    static inline bool _w(S &os, const T &v, As<ZIGZAG>)
+    {
+        return _w(os, ZIGZAG_ENCODE(word(v)));
+    }
+
+    // FIXED32 holds 32 bits at most: integers up to 32 bits and floats,
+    // wider types (int64_t, double) would be truncated
+    //
+    template<class T, class S>
+    static inline bool _w(S &os, const T &v, As<FIXED32>)
+    {
+        STATIC_CHECK(sizeof(T) <= sizeof(uint32_t), FIXED32_of_a_wider_type);
+
+        return _wf(os, static_cast<uint32_t>(word(v)));
+    }
+
+    template<class T, class S>
+    static inline bool _w(S &os, const T &v, As<FIXED64>)
+    {
+        return _wf(os, word(v));
+    }
+
+    template<class T, class S>
+    static bool _w(S &os, const vector<T> &v, As<DELTA>)
+    {
+        if (!_w(os, v.size()))
+        {
+            return false;
+        }
+
+        return v.empty() || _wd(os, &v[0], v.size());
+    }
+
+    // Delta encoding: integers as packed<T>, floating points as series<T>
+    //
+    template<class T, class S>
+    static bool _wd(S &os, const T *v, size_t n)
+    {
+        return _wp(os, v, n);
+    }
+
+    template<class S>
+    static bool _wd(S &os, const float  *v, size_t n) { return _wg(os, v, n); }
+    template<class S>
+    static bool _wd(S &os, const double *v, size_t n) { return _wg(os, v, n); }
+
+    // Packs the value bits w as told by the encoding hint name
+    //
+    static bool _wh(ostream &os, const uint64_t &w, const string &hint)
+    {
+        if ("ZIGZAG"  == hint) { return _w (os, ZIGZAG_ENCODE(w))       ; }
+        if ("FIXED32" == hint) { return _wf(os, static_cast<uint32_t>(w)); }
+        if ("FIXED64" == hint) { return _wf(os, w)                      ; }
+
+        return _w(os, w);
+    }
+
+    template<class S>
+    bool _r(S &is_, uint8_t &v, ssize_t field=-1)
+    {
+        uint64_t r = 0;
+
+        if (!_r(is_, r))
+        {
+            return false;
+        }
+
+        uint8_t rv = static_cast<uint8_t>(r & 0xff);
+
+        set_changed(field, v != rv);
+
+        v = rv;
+
+        return true;
+    }
+
+    template<class S>
+    bool _r(S &is_, uint16_t &v, ssize_t field=-1)
+    {
+        uint64_t r = 0;
+
+        if (!_r(is_, r))
+        {
+            return false;
+        }
+
+        uint16_t rv = static_cast<uint16_t>(r & 0xffff);
+
+        set_changed(field, v != rv);
+
+        v = rv;
+
+        return true;
+    }
+
+    template<class S>
+    bool _r(S &is_, uint32_t &v, ssize_t field=-1)
+    {
+        uint64_t r = 0;
+
+        if (!_r(is_, r))
+        {
+            return false;
+        }
+
+        uint32_t rv = static_cast<uint32_t>(r & 0xffffffff);
+
+        set_changed(field, v != rv);
+
+        v = rv;
+
+        return true;
+    }
+
+    // VARINT unpacking
+    //
+    // VARINT unpacking straight from the buffered bytes, when all there
+    //
+    static inline bool _rq(MemorySource &is_, uint64_t &v)
+    {
+        const uint8_t *s = is_.data();
+        const uint8_t *p = s;
+
+        if (!is_.good() || !varint_take(p, is_.end(), v))
+        {
+            return false;
+        }
+
+        is_.skip(p - s);
+
+        return true;
+    }
+
+    static inline bool _rq(istream &is_, uint64_t &v)
+    {
+        if (!bare(is_))
+        {
+            return false;
+        }
+
+        streambuf *sb = is_.rdbuf();
+
+        const uint8_t *s = Window::begin(sb);
+        const uint8_t *p = s;
+
+        if (!varint_take(p, Window::end(sb), v))
+        {
+            return false;
+        }
+
+        Window::consume(sb, p - s);
+
+        return true;
+    }
+
+    template<class S>
+    bool _r(S &is_, uint64_t &v, ssize_t field=-1)
+    {
+        uint64_t rv = 0;
+
+        if (!_rq(is_, rv))
+        {
+            if (is_.eof())
+            {
+                return false;
+            }
+
+            uint8_t d[9] = { 0 };
+
+            if (!ASSERT_SREAD(is_, &d[0], sizeof(uint8_t)))
+            {
+                return false;
+            }
+
+            uint8_t b = varint_prefix_length(d[0]);
+
+            if (b > 1)
+            {
+                if (!ASSERT_SREAD(is_, &d[1], b-1))
+                {
+                    return false;
+                }
+            }
+
+            rv = varint_unpack(d, b);
+        }
+
+        set_changed(field, v != rv);
+
+        v = rv;
+
+        return true;
+    }
+
+    template<class S>
+    bool _r(S &is_, int8_t &v, ssize_t field=-1)
+    {
+        return _z<int8_t>(is_,v,field);
+    }
+
+    template<class S>
+    bool _r(S &is_, int16_t &v, ssize_t field=-1)
+    {
+        return _z<int16_t>(is_,v,field);
+    }
+
+    template<class S>
+    bool _r(S &is_, int32_t &v, ssize_t field=-1)
+    {
+        return _z<int32_t>(is_,v,field);
+    }
+
+    template<class S>
+    bool _r(S &is_, int64_t &v, ssize_t field=-1)
+    {
+        return _z<int64_t>(is_,v,field);
+    }
+
+    template<class S>
+    bool _r(S &is_, bool &v, ssize_t field=-1)
+    {
+        bool rv;
+
+        if (!ASSERT_SREAD(is_, &rv, sizeof(v)))
+        {
+            return false;
+        }
+
+        set_changed(field, v != rv);
+
+        v = rv;
+
+        return true;
+    }
+
+    template<class S>
+    bool _r(S &is_, float &v, ssize_t field=-1)
+    {
+        float rv;
+
+#if defined(FLOAT_TO_INTEGER_SERIALIZATION)
+        uint32_t r = 0;
+
+        if (!_r(is_, r))
+        {
+            return false;
+        }
+
+        rv = pun<float>(r);
+#else // !FLOAT_TO_INTEGER_SERIALIZATION
+        if (!ASSERT_SREAD(is_, &rv, sizeof(v)))
+        {
+            return false;
+        }
+#endif // !FLOAT_TO_INTEGER_SERIALIZATION
+
+        set_changed(field, v != rv);
+
+        v = rv;
+
+        return true;
+    }
+
+    template<class S>
+    bool _r(S &is_, double &v, ssize_t field=-1)
+    {
+        double rv;
+
+#if defined(FLOAT_TO_INTEGER_SERIALIZATION)
+        uint64_t r = 0;
+
+        if (!_r(is_, r))
+        {
+            return false;
+        }
+
+        rv = pun<double>(r);
+#else // !FLOAT_TO_INTEGER_SERIALIZATION
+        if (!ASSERT_SREAD(is_, &rv, sizeof(v)))
+        {
+            return false;
+        }
+#endif // !FLOAT_TO_INTEGER_SERIALIZATION
+
+        set_changed(field, v != rv);
+
+        v = rv;
+
+        return true;
+    }
+
+    template<class S>
+    bool _r(S &is_, long double &v, ssize_t field=-1)
+    {
+        long double rv;
+
+        if (!ASSERT_SREAD(is_, &rv, sizeof(v)))
+        {
+            return false;
+        }
+
+        set_changed(field, v != rv);
+
+        v = rv;
+
+        return true;
+    }
+
+    template<class S>
+    bool _r(S &is_, string &v, ssize_t field=-1)
+    {
+        return _rf(is_, v, field);
+    }
+
+    //
+    // In place reading
     //
-    // The MSb bits in the MSB byte identify how many bytes are required
-    // to store the numeric value.
+    // Strings, vectors, maps and optional values are read into the storage
+    // they already have, reusing its capacity: decoding the same kind of
+    // HOB over and over into the same object doesn't allocate once it got
+    // its steady state.
     //
-    // x: single bit
-    // X: single byte (8 bits)
+    // changed is set when the value read differs from the previous one,
+    // it is never reset. On errors the value is left partially read.
     //
-    // 1 byte  [numeric value encoded in  7 bits]: 0xxxxxxx
-    // 2 bytes [numeric value encoded in 14 bits]: 10xxxxxx.X
-    // 3 bytes [numeric value encoded in 21 bits]: 110xxxxx.X.X
-    // 4 bytes [numeric value encoded in 28 bits]: 1110xxxx.X.X.X
-    // 5 bytes [numeric value encoded in 35 bits]: 11110xxx.X.X.X.X
-    // 6 bytes [numeric value encoded in 42 bits]: 111110xx.X.X.X.X.X
-    // 7 bytes [numeric value encoded in 49 bits]: 1111110x.X.X.X.X.X.X
-    // 8 bytes [numeric value encoded in 56 bits]: 11111110.X.X.X.X.X.X.X
-    // 9 bytes [numeric value encoded in 64 bits]: 11111111.X.X.X.X.X.X.X.X
+
+    // Reads v in place, then tells whether the field changed
     //
-    // Signed Integer values are zigzag encoded by mapping negative values
-    // to positive values while going back and forth:
+    template<class T, class S>
+    bool _rf(S &is_, T &v, ssize_t field)
+    {
+        bool changed = false;
+
+        if (!_ri(is_, v, changed))
+        {
+            return false;
+        }
+
+        set_changed(field, changed);
+
+        return true;
+    }
+
+    // Reads the items count of a container, of b bytes at least each on the
+    // wire
     //
-    // (0=0, -1=1, 1=2, -2=3, 2=4, -3=5, 3=6 ...)
+    template<class S>
+    bool _rn(S &is_, size_t &n, size_t b = 1)
+    {
+        return _r(is_, n) && (n <= limits().items) && fits(is_, n, b);
+    }
+
+    // Whether n items of b bytes are left, when known
     //
-    //========================================================================
+    static inline bool fits(const MemorySource &is_, uint64_t n, size_t b)
+    {
+        return (0 == b) || (n <= (is_.size() / b));
+    }
+
+    static inline bool fits(const istream &is_, uint64_t n, size_t b)
+    {
+        (void)is_;
+        (void)n;
+        (void)b;
+
+        return true;
+    }
+
+    // HOBSTRUCT fields reading, as told by their tracking mode
+    //
+    template<class T, class S, class H>
+    inline bool _r(S &is_, T &v, ssize_t field, H h, Track<TRACK_VALUES>)
+    {
+        return _r(is_, v, field, h);
+    }
+
+    template<class T, class S, class H>
+    inline bool _r(S &is_, T &v, ssize_t field, H h, Track<TRACK_READS>)
+    {
+        if (!_ru(is_, v, h))
+        {
+            return false;
+        }
+
+        set_changed(field, true);
+
+        return true;
+    }
+
+    template<class T, class S, class H>
+    inline bool _r(S &is_, T &v, ssize_t field, H h, Track<TRACK_NONE>)
+    {
+        (void)field;
+
+        return _ru(is_, v, h);
+    }
+
+    // Reads v in place, not comparing it with its previous value: starting
+    // as changed short circuits every comparison on the way
+    //
+    template<class T, class S>
+    inline bool _ru(S &is_, T &v, As<DEFAULT>)
+    {
+        bool changed = true;
+
+        return _ri(is_, v, changed);
+    }
+
+    template<class T, class S, Encoding E>
+    inline bool _ru(S &is_, T &v, As<E> h)
+    {
+        return _r(is_, v, -1, h);
+    }
+
+    template<class T, class S>
+    bool _ri(S &is_, T &v, bool &changed)
+    {
+        return _rix(is_, v, changed, &v);
+    }
+
+    // Nested HOBs: their own changes tell whether they changed
+    //
+    template<class T, class S>
+    bool _rix(S &is_, T &v, bool &changed, HOB *h)
+    {
+        (void)h;
+
+        if (!_r(is_, static_cast<HOB &>(v)))
+        {
+            return false;
+        }
+
+        changed = changed || static_cast<const HOB &>(v);
+
+        return true;
+    }
+
+    // Plain values, and containers with their own wire layout
+    //
+    template<class T, class S>
+    bool _rix(S &is_, T &v, bool &changed, void *h)
+    {
+        (void)h;
+
+        T rv = T();
+
+        if (!_r(is_, rv))
+        {
+            return false;
+        }
+
+        changed = changed || (v != rv);
+
+        v = rv;
+
+        return true;
+    }
+
+    template<class S>
+    bool _ri(S &is_, string &v, bool &changed)
+    {
+        uint64_t len = 0;
+
+        if (!_r(is_, len) || (len > limits().chars) || !fits(is_, len, 1))
+        {
+            return false;
+        }
+
+        if (len != v.size())
+        {
+            changed = true;
+
+            v.resize(len);
+        }
+
+        return (0 == len) || _rr(is_, &v[0], len, changed);
+    }
+
+    // Reads n raw bytes in d, changed is set when they differ from the ones
+    // already there
+    //
+    bool _rr(MemorySource &is_, void *d, size_t n, bool &changed)
+    {
+        if (!changed && (n <= is_.size()))
+        {
+            changed = (0 != memcmp(d, is_.data(), n));
+        }
+
+        return deserialize(is_, d, n);
+    }
+
+    bool _rr(istream &is_, void *d, size_t n, bool &changed)
+    {
+        if (changed)
+        {
+            return deserialize(is_, d, n);
+        }
+
+        uint8_t  t[256];
+        uint8_t *p = static_cast<uint8_t *>(d);
+
+        while (n > 0)
+        {
+            size_t m = (n < sizeof(t)) ? n : sizeof(t);
+
+            if (!deserialize(is_, t, m))
+            {
+                return false;
+            }
+
+            changed = changed || (0 != memcmp(p, t, m));
+
+            memcpy(p, t, m);
+
+            p += m;
+            n -= m;
+        }
+
+        return true;
+    }
+
+    // Nested HOBs are decoded in place, one forward pass: the ID is checked
+    // inline, the payload decoded straight from the stream buffer when whole
+    // there. Generic HOBs take any ID and keep the payload.
+    //
+    bool _r(istream &is_, HOB &v, ssize_t field=-1)
+    {
+        uint64_t id_ = UNDEFINED;
+        size_t   sz_ = 0;
+        Nesting  in_;
+
+        if (!in_ || is_.eof() || !read_header(is_, id_, sz_))
+        {
+            return false;
+        }
+
+        if (typeid(v) == typeid(HOB))
+        {
+            if (!v.read_along(is_, id_, sz_))
+            {
+                return false;
+            }
+        }
+        else
+        if ((id_ != v._id) || !v.read_payload(is_, sz_))
+        {
+            return false;
+        }
+
+        set_changed(field, v);
+
+        return true;
+    }
+
+    bool _r(MemorySource &is_, HOB &v, ssize_t field=-1)
+    {
+        View    m(is_.data(), is_.size());
+        Nesting in_;
+
+        if (!in_ || (0 == m.consumed()))
+        {
+            return false;
+        }
+
+        if (typeid(v) == typeid(HOB))
+        {
+            v.buffer().assign(m.payload(), m.payload() + m.payload_size());
+
+            v._id = m.id();
+        }
+        else
+        {
+            if (m.id() != v._id)
+            {
+                return false;
+            }
+
+            // The payload is decoded straight from the span
+
+            MemorySource ps(m.payload(), m.payload_size());
+
+            v.reset_changes();
+
+            if (!v._r(ps))
+            {
+                return false;
+            }
+        }
+
+        is_.skip(m.consumed());
+
+        set_changed(field, v);
+
+        return true;
+    }
+
+    template<size_t N, class S>
+    bool _r(S &is_, bitset<N> &v, ssize_t field=-1)
+    {
+        return _rf(is_, v, field);
+    }
+
+    template<size_t N, class S>
+    bool _ri(S &is_, bitset<N> &v, bool &changed)
+    {
+        return _rbits(is_, v, N, changed);
+    }
+
+    // The first n bits of v, in place, a scratch full of words at a time:
+    // the bits past n in the last byte are dropped
+    //
+    template<class C, class S>
+    bool _rbits(S &is_, C &v, size_t n, bool &changed)
+    {
+        size_t len = 0;
+
+        if (!_r(is_, len) || (len != ((n + 7) >> 3)))
+        {
+            return false;
+        }
+
+        BitWord  t[BIT_SCRATCH];
+        uint8_t *b = reinterpret_cast<uint8_t *>(t);
+
+        for (size_t k=0; len > 0;)
+        {
+            size_t c = (len < sizeof(t)) ? len : sizeof(t);
+            size_t m = (c + sizeof(BitWord) - 1) / sizeof(BitWord);
+
+            t[m - 1] = 0;
+
+            if (!ASSERT_SREAD(is_, b, c))
+            {
+                return false;
+            }
+
+            for (size_t i=0; i<m; i++, k++)
+            {
+                BitWord w = le(t[i]) & bit_mask(k, n);
+
+                if (w != bit_word(v, k, n))
+                {
+                    bit_word(v, k, n, w);
+
+                    changed = true;
+                }
+            }
+
+            len -= c;
+        }
+
+        return true;
+    }
+
+    // Read len consecutive values
+    //
+    template<class T, class S>
+    bool _rv(S &is_, T *v, size_t len)
+    {
+        for (size_t i=0; i<len; i++)
+        {
+            if (!_r(is_, static_cast<T&>(v[i])))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template<class S>
+    bool _rv(S &is_, uint8_t  *v, size_t len) { return _rb(is_,v,len); }
+    template<class S>
+    bool _rv(S &is_, uint16_t *v, size_t len) { return _rb(is_,v,len); }
+    template<class S>
+    bool _rv(S &is_, uint32_t *v, size_t len) { return _rb(is_,v,len); }
+    template<class S>
+    bool _rv(S &is_, uint64_t *v, size_t len) { return _rb(is_,v,len); }
+    template<class S>
+    bool _rv(S &is_, int8_t   *v, size_t len) { return _rb(is_,v,len); }
+    template<class S>
+    bool _rv(S &is_, int16_t  *v, size_t len) { return _rb(is_,v,len); }
+    template<class S>
+    bool _rv(S &is_, int32_t  *v, size_t len) { return _rb(is_,v,len); }
+    template<class S>
+    bool _rv(S &is_, int64_t  *v, size_t len) { return _rb(is_,v,len); }
+
+    // Bulk read of len consecutive integer values
+    //
+    // The VARINTs already available in the stream buffer are unpacked in
+    // place, the stream is read one value at time only across the buffer
+    // boundaries.
+    //
+    template<class T>
+    bool _rb(MemorySource &is_, T *v, size_t len)
+    {
+        const uint8_t *s = is_.data();
+        const uint8_t *p = s;
+
+        size_t i = varint_unpack(p, is_.end(), v, len);
+
+        is_.skip(p - s);
+
+        for (; i < len; i++)
+        {
+            if (!_r(is_, static_cast<T&>(v[i])))
+            {
+                return false;
+            }
+        }
 
-    static inline bool _w(ostream &os, const uint8_t &v)
-    {
-        return _w(os, static_cast<const uint64_t &>(v));
+        return true;
     }
 
-    static inline bool _w(ostream &os, const uint16_t &v)
+    template<class T>
+    bool _rb(istream &is_, T *v, size_t len)
     {
-        return _w(os, static_cast<const uint64_t &>(v));
+        streambuf *sb = is_.rdbuf();
+
+        size_t i = 0;
+
+        while (i < len)
+        {
+            if ((NULL != sb) && is_.good())
+            {
+                const uint8_t *s = Window::begin(sb);
+                const uint8_t *p = s;
+
+                i += varint_unpack(p, Window::end(sb), &v[i], len - i);
+
+                Window::consume(sb, p - s);
+            }
+
+            if (i < len)
+            {
+                if (!_r(is_, static_cast<T&>(v[i])))
+                {
+                    return false;
+                }
+
+                i++;
+            }
+        }
+
+        return true;
     }
 
-    static inline bool _w(ostream &os, const uint32_t &v)
+    template<class T, class S>
+    bool _r(S &is_, vector<T> &v, ssize_t field=-1)
     {
-        return _w(os, static_cast<const uint64_t &>(v));
+        return _rf(is_, v, field);
     }
 
-    // VARINT packing
-    //
-    static inline bool _w(ostream &os, const uint64_t &v)
+    template<class T, class S>
+    bool _ri(S &is_, vector<T> &v, bool &changed)
     {
-        uint8_t d[9];
-
-        uint8_t b = (v <= 0x000000000000007fllu) ? 1 :
-                    (v <= 0x0000000000003fffllu) ? 2 :
-                    (v <= 0x00000000001fffffllu) ? 3 :
-                    (v <= 0x000000000fffffffllu) ? 4 :
-                    (v <= 0x00000007ffffffffllu) ? 5 :
-                    (v <= 0x000003ffffffffffllu) ? 6 :
-                    (v <= 0x0001ffffffffffffllu) ? 7 :
-                    (v <= 0x00ffffffffffffffllu) ? 8 : 9;
-
-        uint8_t  m = 0xff;
-        uint32_t c = 0xfffffe00;
+        size_t len = 0;
 
-        for (uint8_t i=0; i<b; i++)
+        if (!_rn(is_, len))
         {
-            d[b-i-1] = static_cast<uint8_t>( ( v >> (8*i) ) & 0xff );
-
-            c >>= 1;
-            m >>= 1;
+            return false;
         }
 
-        d[0] &= static_cast<uint8_t>(m & 0xff);
-        d[0] |= static_cast<uint8_t>(c & 0xff);
+        changed = changed || (v.size() != len);
 
-        return ASSERT_SWRITE(os, d, b);
+        v.resize(len);
+
+        return (0 == len) || _rvi(is_, &v[0], len, changed);
     }
 
-    static inline bool _w(ostream &os, const int8_t &v)
+    template<class S>
+    bool _ri(S &is_, vector<bool> &v, bool &changed)
     {
-        return _w(os, static_cast<int64_t>(v));
+        size_t count = 0;
+
+        if (!_rn(is_, count, 0) || !fits(is_, (count + 7) >> 3, 1))
+        {
+            return false;
+        }
+
+        changed = changed || (v.size() != count);
+
+        v.resize(count);
+
+        return _rbits(is_, v, count, changed);
     }
 
-    static inline bool _w(ostream &os, const int16_t &v)
+    // Read len consecutive items in place
+    //
+    template<class T, class S>
+    bool _rvi(S &is_, T *v, size_t len, bool &changed)
     {
-        return _w(os, static_cast<int64_t>(v));
+        for (size_t i=0; i<len; i++)
+        {
+            if (!_ri(is_, static_cast<T&>(v[i]), changed))
+            {
+                return false;
+            }
+        }
+
+        return true;
     }
 
-    static inline bool _w(ostream &os, const int32_t &v)
+    template<class S>
+    bool _rvi(S &is_, uint8_t  *v, size_t len, bool &c) { return _rbi(is_,v,len,c); }
+    template<class S>
+    bool _rvi(S &is_, uint16_t *v, size_t len, bool &c) { return _rbi(is_,v,len,c); }
+    template<class S>
+    bool _rvi(S &is_, uint32_t *v, size_t len, bool &c) { return _rbi(is_,v,len,c); }
+    template<class S>
+    bool _rvi(S &is_, uint64_t *v, size_t len, bool &c) { return _rbi(is_,v,len,c); }
+    template<class S>
+    bool _rvi(S &is_, int8_t   *v, size_t len, bool &c) { return _rbi(is_,v,len,c); }
+    template<class S>
+    bool _rvi(S &is_, int16_t  *v, size_t len, bool &c) { return _rbi(is_,v,len,c); }
+    template<class S>
+    bool _rvi(S &is_, int32_t  *v, size_t len, bool &c) { return _rbi(is_,v,len,c); }
+    template<class S>
+    bool _rvi(S &is_, int64_t  *v, size_t len, bool &c) { return _rbi(is_,v,len,c); }
+
+    // Bulk read of len consecutive integer items in place: blocks of items
+    // are unpacked on the stack, then compared with the items and copied
+    // over them. Once changed, the items are unpacked straight in place.
+    //
+    template<class T, class S>
+    bool _rbi(S &is_, T *v, size_t len, bool &changed)
     {
-        return _w(os, static_cast<int64_t>(v));
+        T t[PACKED_BLOCK];
+
+        for (size_t i=0; i<len; )
+        {
+            if (changed)
+            {
+                return _rv(is_, &v[i], len - i);
+            }
+
+            size_t m = ((len - i) < PACKED_BLOCK) ? (len - i) : PACKED_BLOCK;
+
+            if (!_rv(is_, t, m))
+            {
+                return false;
+            }
+
+            changed = (0 != memcmp(&v[i], t, m * sizeof(T)));
+
+            memcpy(&v[i], t, m * sizeof(T));
+
+            i += m;
+        }
+
+        return true;
     }
 
-    // ZIGZAG encoding
-    //
-    static inline bool _w(ostream &os, const int64_t &v)
+#if defined(CONTIGUOUS_VECTORS)
+    template<class T, class S>
+    bool _rc(S &is_, vector<T> &v, bool &changed)
     {
-        return _w(os, ZIGZAG_ENCODE(v));
+        size_t len = 0;
+
+        if (!_rn(is_, len, sizeof(T)))
+        {
+            return false;
+        }
+
+        changed = changed || (v.size() != len);
+
+        v.resize(len);
+
+        if (0 == len)
+        {
+            return true;
+        }
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        // Items compared in their wire byte order
+
+        for (size_t i=0; i<len; i++)
+        {
+            v[i] = le(v[i]);
+        }
+
+        bool rv = _rr(is_, &v[0], len * sizeof(T), changed);
+
+        for (size_t i=0; i<len; i++)
+        {
+            v[i] = le(v[i]);
+        }
+
+        return rv;
+#else // !__ORDER_BIG_ENDIAN__
+        return _rr(is_, &v[0], len * sizeof(T), changed);
+#endif // !__ORDER_BIG_ENDIAN__
     }
 
-    static inline bool _w(ostream &os, const bool &v)
+    template<class S>
+    bool _ri(S &is_, vector<uint8_t> &v, bool &c) { return _rc(is_, v, c); }
+    template<class S>
+    bool _ri(S &is_, vector<int8_t > &v, bool &c) { return _rc(is_, v, c); }
+    template<class S>
+    bool _ri(S &is_, vector<float  > &v, bool &c) { return _rc(is_, v, c); }
+    template<class S>
+    bool _ri(S &is_, vector<double > &v, bool &c) { return _rc(is_, v, c); }
+
+    template<class S>
+    bool _r(S &is_, vector<uint8_t> &v, ssize_t field=-1)
     {
-        return ASSERT_SWRITE(os, &v, sizeof(v));
+        return _rf(is_, v, field);
     }
 
-    static inline bool _w(ostream &os, const float &v)
+    template<class S>
+    bool _r(S &is_, vector<int8_t> &v, ssize_t field=-1)
     {
-#if defined(FLOAT_TO_INTEGER_SERIALIZATION)
-        return _w(os, *reinterpret_cast<const uint32_t*>(&v));
-#else // !FLOAT_TO_INTEGER_SERIALIZATION
-        return ASSERT_SWRITE(os, &v, sizeof(v));
-#endif // !FLOAT_TO_INTEGER_SERIALIZATION
+        return _rf(is_, v, field);
     }
 
-    static inline bool _w(ostream &os, const double &v)
+    template<class S>
+    bool _r(S &is_, vector<float> &v, ssize_t field=-1)
     {
-#if defined(FLOAT_TO_INTEGER_SERIALIZATION)
-        return _w(os, *reinterpret_cast<const uint64_t*>(&v));
-#else // !FLOAT_TO_INTEGER_SERIALIZATION
-        return ASSERT_SWRITE(os, &v, sizeof(v));
-#endif // !FLOAT_TO_INTEGER_SERIALIZATION
+        return _rf(is_, v, field);
     }
 
-    static inline bool _w(ostream &os, const long double &v)
+    template<class S>
+    bool _r(S &is_, vector<double> &v, ssize_t field=-1)
     {
-        return ASSERT_SWRITE(os, &v, sizeof(v));
+        return _rf(is_, v, field);
     }
+#endif // CONTIGUOUS_VECTORS
 
-    static inline bool _w(ostream &os, const string &v)
+    // Unpacks n (> 0) items in v
+    //
+    template<class T, class S>
+    bool _rp(S &is_, T *v, size_t n)
     {
-        if (!_w(os, v.size()))
+        uint8_t method = PACKED_FOR;
+
+        if (!_r(is_, method))
         {
             return false;
         }
 
-        return ASSERT_SWRITE(os, v.data(), v.size());
-    }
+        if (PACKED_RLE == method)
+        {
+            size_t runs = 0;
 
-    static inline bool _w(ostream &os, uint8_t size_, const void *v)
-    {
-        if (!_w(os, size_))
+            if (!_r(is_, runs))
+            {
+                return false;
+            }
+
+            size_t i = 0;
+
+            for (size_t r=0; r<runs; r++)
+            {
+                uint64_t x   = 0;
+                size_t   len = 0;
+
+                if (!_r(is_, x) || !_r(is_, len) || (len > (n - i)))
+                {
+                    return false;
+                }
+
+                T item = static_cast<T>(ZIGZAG_DECODE(x));
+
+                for (size_t j=0; j<len; j++)
+                {
+                    v[i+j] = item;
+                }
+
+                i += len;
+            }
+
+            return (i == n);
+        }
+
+        if ((PACKED_FOR != method) && (PACKED_DELTA != method))
         {
             return false;
         }
 
-        return ASSERT_SWRITE(os, v, size_);
-    }
+        uint64_t prev = 0;
+        uint64_t w[PACKED_BLOCK];
+        uint8_t  d[PACKED_BLOCK * 8 + 9];
 
-    static bool _w(ostream &os, const HOB &v)
-    {
-        return (v >> os);
-    }
+        for (size_t i=0; i<n; )
+        {
+            size_t   m   = ((n - i) < PACKED_BLOCK) ? (n - i) : PACKED_BLOCK;
+            uint64_t ref = 0;
+            uint8_t  b   = 0;
 
-    template<size_t N>
-    static bool _w(ostream &os, const std::bitset<N>& v)
-    {
-        uint8_t bits[(N+7)>>3];
+            if (!_r(is_, ref) || !_r(is_, b) || (b > 64))
+            {
+                return false;
+            }
 
-        memset(bits, 0, ((N+7)>>3));
+            size_t l = (m * b + 7) >> 3;
 
-        for (size_t j=0; j<size_t(N); j++)
-        {
-            bits[j>>3] |= (v[j]<<(j&7));
+            memset(&d[l], 0, 9);
+
+            if ((l > 0) && !ASSERT_SREAD(is_, d, l))
+            {
+                return false;
+            }
+
+            bitunpack(w, d, m, ZIGZAG_DECODE(ref), b);
+
+            if (PACKED_DELTA == method)
+            {
+                for (size_t j=0; j<m; j++)
+                {
+                    prev += ZIGZAG_DECODE(w[j]);
+
+                    v[i+j] = static_cast<T>(prev);
+                }
+            }
+            else
+            {
+                for (size_t j=0; j<m; j++)
+                {
+                    v[i+j] = static_cast<T>(w[j]);
+                }
+            }
+
+            i += m;
         }
 
-        return _w(os, ((N+7)>>3), bits);
+        return true;
     }
 
-    template<class T>
-    static bool _w(ostream &os, const vector<T> &v)
+    template<class T, class S>
+    bool _r(S &is_, packed<T> &v, ssize_t field=-1)
     {
-        if (!_w(os, v.size()))
+        size_t len = 0;
+
+        if (!_rn(is_, len, 0))
         {
             return false;
         }
 
-        for (size_t i=0; i<v.size(); i++)
+        packed<T> tmp(len);
+
+        if ((len > 0) && !_rp(is_, &tmp[0], len))
         {
-            if (!_w(os, static_cast<const T &>(v[i])))
-            {
-                return false;
-            }
+            return false;
         }
 
+        set_changed(field, v != tmp);
+
+        v = tmp;
+
         return true;
     }
 
-    static bool _w(ostream &os, const vector<bool> &v, bool dump_size=true)
+    // XOR decodes n (> 0) items in v
+    //
+    template<class T, class S>
+    bool _rg(S &is_, T *v, size_t n)
     {
-        if (dump_size && !_w(os, v.size()))
+        uint64_t first = 0;
+        size_t   len   = 0;
+
+        if (!_r(is_, first) || !_rn(is_, len))
+        {
+            return false;
+        }
+
+        vector<uint8_t> b(len);
+
+        if ((len > 0) && !ASSERT_SREAD(is_, &b[0], len))
         {
             return false;
         }
 
-        uint8_t bits[(v.size()+7)>>3];
+        BitReader bits(b.empty() ? NULL : &b[0], b.empty() ? NULL : &b[0] + len);
+        Gorilla   codec(first);
 
-        memset(bits, 0, ((v.size()+7)>>3));
+        unword(first, v[0]);
 
-        for (size_t j=0; j<v.size(); j++)
+        for (size_t i=1; i<n; i++)
         {
-            bits[j>>3] |= (v[j]<<(j&7));
+            unword(codec.decode(bits), v[i]);
         }
 
-        return _w(os, ((v.size()+7)>>3), bits);
+        return bits.good() && codec.good();
     }
 
-    template<class T>
-    static bool _w(ostream &os, const optional<T> &v)
+    template<class T, class S>
+    bool _r(S &is_, series<T> &v, ssize_t field=-1)
     {
-        if (!_w(os, static_cast<bool>(v)))
+        size_t len = 0;
+
+        if (!_rn(is_, len, 0))
         {
             return false;
         }
 
-        if (static_cast<bool>(v))
+        series<T> tmp(len);
+
+        if ((len > 0) && !_rg(is_, &tmp[0], len))
         {
-            if (!_w(os, static_cast<const T &>(*v)))
-            {
-                return false;
-            }
+            return false;
         }
 
+        set_changed(field, v != tmp);
+
+        v = tmp;
+
         return true;
     }
 
-    template<class K, class V>
-    static bool _w(ostream &os, const map<K,V> &v)
+    template<class S>
+    bool _r(S &is_, vector<bool> &v, ssize_t field=-1)
     {
-        size_t len = v.size();
+        return _rf(is_, v, field);
+    }
 
-        if (!_w(os, len))
+    template<class T, class S>
+    bool _r(S &is_, optional<T> &v, ssize_t field=-1)
+    {
+        return _rf(is_, v, field);
+    }
+
+    // Optional values are read in place, into the value held if any
+    //
+    template<class T, class S>
+    bool _ri(S &is_, optional<T> &v, bool &changed)
+    {
+        bool has_field = false;
+
+        if (!_r(is_, has_field))
         {
             return false;
         }
 
-        for (typename map<K,V>::const_iterator ci = v.begin();
-             (len > 0) && (ci != v.end());
-             ++ci)
+        if (!has_field)
         {
-            if (!_w(os, static_cast<const K &>((*ci).first)))
+            changed = changed || v.has_value();
+
+            v = optional<T>();
+
+            return true;
+        }
+
+        if (!v.has_value())
+        {
+            changed = true;
+
+            v = T();
+        }
+
+        return _ri(is_, static_cast<T&>(*v), changed);
+    }
+
+    template<class K, class V, class S>
+    bool _r(S &is_, map<K,V> &v_, ssize_t field=-1)
+    {
+        return _rf(is_, v_, field);
+    }
+
+    // Maps are merged in place with the pairs read, sorted by key as written:
+    // the values of the keys read again are read in place, the pairs of the
+    // keys no longer there are dropped, the new pairs are inserted at the
+    // merge point, in constant time. Keys out of order (not written by a
+    // map) are inserted by lookup.
+    //
+    template<class K, class V, class S>
+    bool _ri(S &is_, map<K,V> &v_, bool &changed)
+    {
+        size_t len = 0;
+
+        if (!_rn(is_, len))
+        {
+            return false;
+        }
+
+        typename map<K,V>::iterator it = v_.begin();
+
+        K k = K();
+        K p = K();
+
+        for (size_t i=0; i<len; i++)
+        {
+            if (!_r(is_, static_cast<K&>(k)))
             {
                 return false;
             }
 
-            if (!_w(os, static_cast<const V &>((*ci).second)))
+            if ((i > 0) && !(p < k))
             {
-                return false;
+                typename map<K,V>::iterator o = v_.find(k);
+
+                if (o == v_.end())
+                {
+                    o = v_.insert(make_pair(k, V())).first;
+
+                    changed = true;
+                }
+
+                if (!_ri(is_, static_cast<V&>(o->second), changed))
+                {
+                    return false;
+                }
+
+                continue;
             }
 
-            len--;
-        }
+            p = k;
 
-        return true;
-    }
+            while ((it != v_.end()) && (it->first < k))
+            {
+                v_.erase(it++);
 
-    bool _r(istream &is_, uint8_t &v, ssize_t field=-1)
-    {
-        uint64_t r;
+                changed = true;
+            }
+
+            if ((it == v_.end()) || (k < it->first))
+            {
+                it = v_.insert(it, make_pair(k, V()));
+
+                changed = true;
+            }
+
+            if (!_ri(is_, static_cast<V&>(it->second), changed))
+            {
+                return false;
+            }
 
-        if (!_r(is_, r))
-        {
-            return false;
+            ++it;
         }
 
-        uint8_t rv = static_cast<uint8_t>(r & 0xff);
-
-        set_changed(field, v != rv);
+        if (it != v_.end())
+        {
+            v_.erase(it, v_.end());
 
-        v = rv;
+            changed = true;
+        }
 
         return true;
     }
 
-    bool _r(istream &is_, uint16_t &v, ssize_t field=-1)
+    template<class K, class V, class S>
+    bool _r(S &is_, flat_map<K,V> &v_, ssize_t field=-1)
     {
-        uint64_t r;
+        return _rf(is_, v_, field);
+    }
 
-        if (!_r(is_, r))
+    // Flat maps are read in place, pair by pair, then sorted if the keys
+    // were out of order
+    //
+    template<class K, class V, class S>
+    bool _ri(S &is_, flat_map<K,V> &v_, bool &changed)
+    {
+        size_t len = 0;
+
+        if (!_rn(is_, len))
         {
             return false;
         }
 
-        uint16_t rv = static_cast<uint16_t>(r & 0xffff);
-
-        set_changed(field, v != rv);
+        changed = changed || (v_.size() != len);
 
-        v = rv;
+        v_.resize(len);
 
-        return true;
-    }
+        bool sorted = true;
 
-    bool _r(istream &is_, uint32_t &v, ssize_t field=-1)
-    {
-        uint64_t r;
+        typename flat_map<K,V>::iterator it = v_.begin();
 
-        if (!_r(is_, r))
+        for (size_t i=0; i<len; i++, ++it)
         {
-            return false;
-        }
-
-        uint32_t rv = static_cast<uint32_t>(r & 0xffffffff);
+            if (!_ri(is_, static_cast<K&>(it->first ), changed)
+                ||
+                !_ri(is_, static_cast<V&>(it->second), changed))
+            {
+                return false;
+            }
 
-        set_changed(field, v != rv);
+            sorted = sorted && ((0 == i) || ((it - 1)->first < it->first));
+        }
 
-        v = rv;
+        if (!sorted)
+        {
+            v_.sort();
+        }
 
         return true;
     }
 
-    // VARINT unpacking
+    template<class K, class S>
+    bool _r(S &is_, set<K> &v_, ssize_t field=-1)
+    {
+        return _rf(is_, v_, field);
+    }
+
+    // Sets are merged in place with the keys read, as maps are
     //
-    bool _r(istream &is_, uint64_t &v, ssize_t field=-1)
+    template<class K, class S>
+    bool _ri(S &is_, set<K> &v_, bool &changed)
     {
-        if (is_.eof())
+        size_t len = 0;
+
+        if (!_rn(is_, len))
         {
             return false;
         }
 
-        uint8_t d[9];
-        uint8_t b = 0;
-        uint8_t c;
-        uint8_t m;
+        typename set<K>::iterator it = v_.begin();
 
-        if (!ASSERT_SREAD(is_, &d[0], sizeof(uint8_t)))
-        {
-            return false;
-        }
+        K k = K();
+        K p = K();
 
-        for (b=1; b<=8; b++)
+        for (size_t i=0; i<len; i++)
         {
-            m = (0xff << (8-b));
-            c = (0x01 << (8-b));
+            if (!_r(is_, static_cast<K&>(k)))
+            {
+                return false;
+            }
 
-            if ((d[0] & c) == 0)
+            if ((i > 0) && !(p < k))
             {
-                break;
+                changed = v_.insert(k).second || changed;
+
+                continue;
             }
-        }
 
-        if (b > 1)
-        {
-            if (!ASSERT_SREAD(is_, &d[1], b-1))
+            p = k;
+
+            while ((it != v_.end()) && (*it < k))
             {
-                return false;
+                v_.erase(it++);
+
+                changed = true;
             }
-        }
 
-        uint64_t rv = (b < 9) ? d[0] & ~m : 0;
+            if ((it == v_.end()) || (k < *it))
+            {
+                it = v_.insert(it, k);
 
-        for (uint8_t i=1; i<b; i++)
-        {
-            rv <<= 8;
-            rv |= static_cast<uint64_t>(d[i] & 0xff);
+                changed = true;
+            }
+
+            ++it;
         }
 
-        set_changed(field, v != rv);
+        if (it != v_.end())
+        {
+            v_.erase(it, v_.end());
 
-        v = rv;
+            changed = true;
+        }
 
         return true;
     }
 
-    bool _r(istream &is_, int8_t &v, ssize_t field=-1)
+    // Equality of two field values, for the HOBSTRUCT comparisons
+    //
+    template<class T>
+    static inline bool _eq(const T &a, const T &b)
     {
-        return _z<int8_t>(is_,v,field);
+        return a == b;
     }
 
-    bool _r(istream &is_, int16_t &v, ssize_t field=-1)
+#if defined(HOB_TR1_CONTAINERS) && (__cplusplus < 201103L)
+    // TR1 hashed maps have no equality: the pairs are looked up one by one
+    //
+    template<class K, class V, class H, class P, class A>
+    static bool _eq(const unordered_map<K,V,H,P,A> &a,
+                    const unordered_map<K,V,H,P,A> &b)
     {
-        return _z<int16_t>(is_,v,field);
-    }
+        if (a.size() != b.size())
+        {
+            return false;
+        }
 
-    bool _r(istream &is_, int32_t &v, ssize_t field=-1)
-    {
-        return _z<int32_t>(is_,v,field);
+        for (typename unordered_map<K,V,H,P,A>::const_iterator ci = a.begin();
+             ci != a.end();
+             ++ci)
+        {
+            typename unordered_map<K,V,H,P,A>::const_iterator o =
+                b.find(ci->first);
+
+            if ((o == b.end()) || !_eq(o->second, ci->second))
+            {
+                return false;
+            }
+        }
+
+        return true;
     }
+#endif // HOB_TR1_CONTAINERS && C++98
 
-    bool _r(istream &is_, int64_t &v, ssize_t field=-1)
+#if defined(HOB_TR1_CONTAINERS)
+    template<class K, class V, class S>
+    bool _r(S &is_, unordered_map<K,V> &v_, ssize_t field=-1)
     {
-        return _z<int64_t>(is_,v,field);
+        return _rf(is_, v_, field);
     }
 
-    bool _r(istream &is_, bool &v, ssize_t field=-1)
+    // Hashed maps are read anew, then swapped in: they have no order to
+    // merge along
+    //
+    template<class K, class V, class S>
+    bool _ri(S &is_, unordered_map<K,V> &v_, bool &changed)
     {
-        bool rv;
+        size_t len = 0;
 
-        if (!ASSERT_SREAD(is_, &rv, sizeof(v)))
+        if (!_rn(is_, len))
         {
             return false;
         }
 
-        set_changed(field, v != rv);
-
-        v = rv;
-
-        return true;
-    }
+        unordered_map<K,V> rv(len);
 
-    bool _r(istream &is_, float &v, ssize_t field=-1)
-    {
-        float rv;
+        K k = K();
 
-#if defined(FLOAT_TO_INTEGER_SERIALIZATION)
-        if (!_r(is_, *reinterpret_cast<uint32_t*>(&rv)))
-#else // !FLOAT_TO_INTEGER_SERIALIZATION
-        if (!ASSERT_SREAD(is_, &rv, sizeof(v)))
-#endif // !FLOAT_TO_INTEGER_SERIALIZATION
+        for (size_t i=0; i<len; i++)
         {
-            return false;
+            if (!_r(is_, static_cast<K&>(k))
+                ||
+                !_r(is_, static_cast<V&>(rv[k])))
+            {
+                return false;
+            }
         }
 
-        set_changed(field, v != rv);
+        changed = changed || !_eq(v_, rv);
 
-        v = rv;
+        v_.swap(rv);
 
         return true;
     }
 
-    bool _r(istream &is_, double &v, ssize_t field=-1)
+    template<class T, size_t N, class S>
+    bool _r(S &is_, array<T,N> &v, ssize_t field=-1)
     {
-        double rv;
+        return _rf(is_, v, field);
+    }
 
-#if defined(FLOAT_TO_INTEGER_SERIALIZATION)
-        if (!_r(is_, *reinterpret_cast<uint64_t*>(&rv)))
-#else // !FLOAT_TO_INTEGER_SERIALIZATION
-        if (!ASSERT_SREAD(is_, &rv, sizeof(v)))
-#endif // !FLOAT_TO_INTEGER_SERIALIZATION
-        {
-            return false;
-        }
+    template<class T, size_t N, class S>
+    bool _ri(S &is_, array<T,N> &v, bool &changed)
+    {
+        return (0 == N) || _rvi(is_, &v[0], N, changed);
+    }
+#endif // HOB_TR1_CONTAINERS
 
-        set_changed(field, v != rv);
+    template<class T, class S>
+    inline bool _r(S &is_, T &v, ssize_t field, As<DEFAULT>)
+    {
+        return _r(is_, v, field);
+    }
 
-        v = rv;
+    template<class T, class S>
+    bool _r(S &is_, T &v, ssize_t field, As<VARINT>)
+    {
+        uint64_t r = 0;
 
-        return true;
+        return _r(is_, r) && _rh(v, r, field);
     }
 
-    bool _r(istream &is_, long double &v, ssize_t field=-1)
+    template<class T, class S>
+    bool _r(S &is_, T &v, ssize_t field, As<ZIGZAG>)
     {
-        long double rv;
+        uint64_t r = 0;
 
-        if (!ASSERT_SREAD(is_, &rv, sizeof(v)))
-        {
-            return false;
-        }
+        return _r(is_, r) && _rh(v, ZIGZAG_DECODE(r), field);
+    }
 
-        set_changed(field, v != rv);
+    template<class T, class S>
+    bool _r(S &is_, T &v, ssize_t field, As<FIXED32>)
+    {
+        STATIC_CHECK(sizeof(T) <= sizeof(uint32_t), FIXED32_of_a_wider_type);
 
-        v = rv;
+        uint32_t r = 0;
 
-        return true;
+        return ASSERT_SREAD(is_, &r, sizeof(r)) && _rh(v, le(r), field);
     }
 
-    bool _r(istream &is_, string &v, ssize_t field=-1)
+    template<class T, class S>
+    bool _r(S &is_, T &v, ssize_t field, As<FIXED64>)
     {
-        uint64_t len;
+        uint64_t r = 0;
 
-        if (!_r(is_, len))
+        return ASSERT_SREAD(is_, &r, sizeof(r)) && _rh(v, le(r), field);
+    }
+
+    template<class T, class S>
+    bool _r(S &is_, vector<T> &v, ssize_t field, As<DELTA>)
+    {
+        size_t len = 0;
+
+        if (!_rn(is_, len, 0))
         {
             return false;
         }
 
-        vector<char> tmp(len);
+        vector<T> tmp(len);
 
-        if (!ASSERT_SREAD(is_, tmp.data(), len))
+        if ((len > 0) && !_rd(is_, &tmp[0], len))
         {
             return false;
         }
 
-        string rv;
+        set_changed(field, v != tmp);
 
-        rv.assign(tmp.data(),len);
-
-        set_changed(field, v != rv);
-
-        v = rv;
+        v = tmp;
 
         return true;
     }
 
-    bool _r(istream &is_, HOB &v, ssize_t field=-1)
+    template<class T, class S>
+    bool _rd(S &is_, T *v, size_t n) { return _rp(is_, v, n); }
+
+    template<class S>
+    bool _rd(S &is_, float  *v, size_t n) { return _rg(is_, v, n); }
+    template<class S>
+    bool _rd(S &is_, double *v, size_t n) { return _rg(is_, v, n); }
+
+    //
+    // Field skipping, used to index the fields of a frame (see Lazy)
+    //
+    // Nested HOBs are skipped by their payload size, strings and bitsets by
+    // their length, containers item by item; the other fields are decoded
+    // and dropped.
+    //
+    template<class T>
+    bool _k(MemorySource &is_, const T *t)
     {
-        if (!is_.eof())
-        {
-            HOB m;
+        return _kx(is_, t, t);
+    }
 
-            if (m << is_)
-            {
-                v = m;
+    template<class T>
+    bool _kx(MemorySource &is_, const T *t, const HOB *h)
+    {
+        (void)t;
+        (void)h;
 
-                if ( v << static_cast<istream&>(m) )
-                {
-                    set_changed(field, v);
+        View v(is_.data(), is_.size());
 
-                    return true;
-                }
-            }
-        }
+        is_.skip(v.consumed());
 
-        return false;
+        return (v.consumed() > 0);
     }
 
-    template<size_t N>
-    bool _r(istream &is_, bitset<N> &v, ssize_t field=-1)
+    template<class T>
+    bool _kx(MemorySource &is_, const T *t, const void *h)
     {
-        size_t len;
+        (void)t;
+        (void)h;
 
-        if (!_r(is_, len) || (len != ((N + 7) >> 3)))
-        {
-            return false;
-        }
+        T tmp = T();
 
-        uint8_t bits[len];
+        return _r(is_, tmp);
+    }
 
-        memset(bits, 0, len);
+    // Skips a length prefixed sequence of bytes
+    //
+    bool _kb(MemorySource &is_)
+    {
+        size_t len = 0;
 
-        if (!ASSERT_SREAD(is_, bits, len))
+        if (!_r(is_, len) || (len > is_.size()))
         {
             return false;
         }
 
-        bitset<N> rv;
-
-        for (size_t j=0; j<size_t(N); j++)
-        {
-            rv[j] = ((bits[j>>3]>>(j&7)) & 1);
-        }
-
-        set_changed(field, v != rv);
-
-        v = rv;
+        is_.skip(len);
 
         return true;
     }
 
+    bool _k(MemorySource &is_, const string *t) { (void)t; return _kb(is_); }
+
+    template<size_t N>
+    bool _k(MemorySource &is_, const bitset<N> *t) { (void)t; return _kb(is_); }
+
     template<class T>
-    bool _r(istream &is_, vector<T> &v, ssize_t field=-1)
+    bool _k(MemorySource &is_, const vector<T> *t)
     {
-        size_t len;
+        (void)t;
+
+        size_t len = 0;
 
         if (!_r(is_, len))
         {
             return false;
         }
 
-        if (len > 0)
+        for (size_t i=0; i<len; i++)
         {
-            vector<T> tmp(len);
-
-            for (size_t i=0; i<len; i++)
+            if (!_k(is_, static_cast<const T *>(NULL)))
             {
-                if (!_r(is_, static_cast<T&>(tmp[i])))
-                {
-                    return false;
-                }
+                return false;
             }
+        }
+
+        return true;
+    }
 
-            set_changed(field, v != tmp);
+    // Vectors with their own wire layout
 
-            v = tmp;
-        }
-        else
-        {
-            set_changed(field, !v.empty());
+    bool _k(MemorySource &is_, const vector<bool> *t)
+    {
+        (void)t;
 
-            v = vector<T>();
-        }
+        size_t count = 0;
 
-        return true;
+        return _r(is_, count) && _kb(is_);
     }
 
-    bool _r(istream &is_, vector<bool> &v, ssize_t field=-1)
+    template<class T>
+    bool _k(MemorySource &is_, const packed<T> *t) { return _kx(is_, t, t); }
+
+    template<class T>
+    bool _k(MemorySource &is_, const series<T> *t) { return _kx(is_, t, t); }
+
+#if defined(CONTIGUOUS_VECTORS)
+    template<class T>
+    bool _kc(MemorySource &is_)
     {
-        size_t count;
+        size_t len = 0;
 
-        if (!_r(is_, count))
+        if (!_r(is_, len) || (len > (is_.size() / sizeof(T))))
         {
             return false;
         }
 
-        if (count > 0)
-        {
-            size_t len;
+        is_.skip(len * sizeof(T));
 
-            if (!_r(is_, len) || (len != ((count + 7) >> 3)))
-            {
-                return false;
-            }
+        return true;
+    }
 
-            uint8_t bits[len];
+    bool _k(MemorySource &is_, const vector<uint8_t> *t) { (void)t; return _kc<uint8_t>(is_); }
+    bool _k(MemorySource &is_, const vector<int8_t > *t) { (void)t; return _kc<int8_t >(is_); }
+    bool _k(MemorySource &is_, const vector<float  > *t) { (void)t; return _kc<float  >(is_); }
+    bool _k(MemorySource &is_, const vector<double > *t) { (void)t; return _kc<double >(is_); }
+#endif // CONTIGUOUS_VECTORS
 
-            memset(bits, 0, len);
+    template<class T>
+    bool _k(MemorySource &is_, const optional<T> *t)
+    {
+        (void)t;
 
-            if (!ASSERT_SREAD(is_, bits, len))
-            {
-                return false;
-            }
+        bool has_field = false;
 
-            vector<bool> rv;
+        return _r(is_, has_field)
+               &&
+               (!has_field || _k(is_, static_cast<const T *>(NULL)));
+    }
 
-            for (size_t j=0; j<count; j++)
-            {
-                rv.push_back((bits[j>>3]>>(j&7)) & 1);
-            }
+    template<class K, class V>
+    bool _k(MemorySource &is_, const map<K,V> *t) { (void)t; return _km<K,V>(is_); }
 
-            set_changed(field, v != rv);
+    template<class K, class V>
+    bool _k(MemorySource &is_, const flat_map<K,V> *t) { (void)t; return _km<K,V>(is_); }
 
-            v = rv;
+#if defined(HOB_TR1_CONTAINERS)
+    template<class K, class V>
+    bool _k(MemorySource &is_, const unordered_map<K,V> *t) { (void)t; return _km<K,V>(is_); }
 
-            return true;
-        }
-        else
-        {
-            set_changed(field, !v.empty());
+    template<class T, size_t N>
+    bool _k(MemorySource &is_, const array<T,N> *t)
+    {
+        (void)t;
 
-            v = vector<bool>();
+        for (size_t i=0; i<N; i++)
+        {
+            if (!_k(is_, static_cast<const T *>(NULL)))
+            {
+                return false;
+            }
         }
 
         return true;
     }
+#endif // HOB_TR1_CONTAINERS
 
-    template<class T>
-    bool _r(istream &is_, optional<T> &v, ssize_t field=-1)
+    template<class K>
+    bool _k(MemorySource &is_, const set<K> *t)
     {
-        bool has_field;
+        (void)t;
 
-        if (!_r(is_, has_field))
+        return _k(is_, static_cast<const vector<K> *>(NULL));
+    }
+
+    template<class K, class V>
+    bool _km(MemorySource &is_)
+    {
+        size_t len = 0;
+
+        if (!_r(is_, len))
         {
             return false;
         }
 
-        if (has_field)
+        for (size_t i=0; i<len; i++)
         {
-            T tmp;
-
-            if (!_r(is_, static_cast<T&>(tmp)))
+            if (!_k(is_, static_cast<const K *>(NULL))
+                ||
+                !_k(is_, static_cast<const V *>(NULL)))
             {
                 return false;
             }
-
-            set_changed(field, v != tmp);
-
-            v = tmp;
-        }
-        else
-        {
-            set_changed(field, v.has_value());
-
-            v = optional<T>();
         }
 
         return true;
     }
 
-    template<class K, class V>
-    bool _r(istream &is_, map<K,V> &v_, ssize_t field=-1)
+    template<class T>
+    bool _k(MemorySource &is_, const T *t, As<DEFAULT>)
     {
-        size_t len;
-
-        if (!_r(is_, len))
-        {
-            return false;
-        }
-
-        if (len > 0)
-        {
-            map<K,V> tmp;
-
-            for (size_t i=0; i<len; i++)
-            {
-                K k;
-                V v;
+        return _k(is_, t);
+    }
 
-                if (!_r(is_, static_cast<K&>(k)))
-                {
-                    return false;
-                }
+    template<class T, Encoding E>
+    bool _k(MemorySource &is_, const T *t, As<E> h)
+    {
+        (void)t;
 
-                if (!_r(is_, static_cast<V&>(v)))
-                {
-                    return false;
-                }
+        T tmp = T();
 
-                tmp[k] = v;
-            }
+        return _r(is_, tmp, -1, h);
+    }
+
+    // Stores the hinted value bits w in v
+    //
+    template<class T>
+    inline bool _rh(T &v, const uint64_t &w, ssize_t field)
+    {
+        T rv = T();
 
-            set_changed(field, v_ != tmp);
+        unword(w, rv);
 
-            v_ = tmp;
-        }
-        else
-        {
-            set_changed(field, !v_.empty());
+        set_changed(field, v != rv);
 
-            v_ = map<K,V>();
-        }
+        v = rv;
 
         return true;
     }
@@ -1091,14 +5197,7 @@ protected:
     //
     static inline size_t _l(const uint64_t &v)
     {
-        return (v <= 0x000000000000007fllu) ? 1 :
-               (v <= 0x0000000000003fffllu) ? 2 :
-               (v <= 0x00000000001fffffllu) ? 3 :
-               (v <= 0x000000000fffffffllu) ? 4 :
-               (v <= 0x00000007ffffffffllu) ? 5 :
-               (v <= 0x000003ffffffffffllu) ? 6 :
-               (v <= 0x0001ffffffffffffllu) ? 7 :
-               (v <= 0x00ffffffffffffffllu) ? 8 : 9;
+        return varint_length(v);
     }
 
     static inline size_t _l(const int8_t &v)
@@ -1131,7 +5230,7 @@ protected:
     static inline size_t _l(const float &v)
     {
 #if defined(FLOAT_TO_INTEGER_SERIALIZATION)
-        return _l(*reinterpret_cast<const uint32_t*>(&v));
+        return _l(pun<uint32_t>(v));
 #else // !FLOAT_TO_INTEGER_SERIALIZATION
         return sizeof(v);
 #endif // !FLOAT_TO_INTEGER_SERIALIZATION
@@ -1140,7 +5239,7 @@ protected:
     static inline size_t _l(const double &v)
     {
 #if defined(FLOAT_TO_INTEGER_SERIALIZATION)
-        return _l(*reinterpret_cast<const uint64_t*>(&v));
+        return _l(pun<uint64_t>(v));
 #else // !FLOAT_TO_INTEGER_SERIALIZATION
         return _l(sizeof(v));
 #endif // !FLOAT_TO_INTEGER_SERIALIZATION
@@ -1185,6 +5284,19 @@ protected:
         return retval;
     }
 
+#if defined(CONTIGUOUS_VECTORS)
+    template<class T>
+    static size_t _lc(const vector<T> &v)
+    {
+        return _l(v.size()) + v.size() * sizeof(T);
+    }
+
+    static size_t _l(const vector<uint8_t> &v) { return _lc(v); }
+    static size_t _l(const vector<int8_t > &v) { return _lc(v); }
+    static size_t _l(const vector<float  > &v) { return _lc(v); }
+    static size_t _l(const vector<double > &v) { return _lc(v); }
+#endif // CONTIGUOUS_VECTORS
+
     static size_t _l(const vector<bool> &v, bool dump_size=true)
     {
         size_t sz = v.size();
@@ -1192,6 +5304,20 @@ protected:
         return ((dump_size) ? _l(sz) : 0) + _l((sz+7)>>3) + ((sz+7)>>3);
     } 
 
+    template<class T>
+    static size_t _l(const packed<T> &v)
+    {
+        uint8_t method = PACKED_FOR;
+
+        return _l(v.size()) + (v.empty() ? 0 : _lp(&v[0], v.size(), method));
+    }
+
+    template<class T>
+    static size_t _l(const series<T> &v)
+    {
+        return _l(v.size()) + (v.empty() ? 0 : _lg(&v[0], v.size()));
+    }
+
     template<class T>
     static size_t _l(const optional<T> &v)
     {
@@ -1206,12 +5332,52 @@ protected:
     }
 
     template<class K, class V>
-    static size_t _l(const map<K,V> &v)
+    static size_t _l(const map<K,V> &v) { return _lm(v); }
+
+    template<class K, class V>
+    static size_t _l(const flat_map<K,V> &v) { return _lm(v); }
+
+#if defined(HOB_TR1_CONTAINERS)
+    template<class K, class V>
+    static size_t _l(const unordered_map<K,V> &v) { return _lm(v); }
+
+    template<class T, size_t N>
+    static size_t _l(const array<T,N> &v)
+    {
+        size_t retval = 0;
+
+        for (size_t i=0; i<N; i++)
+        {
+            retval += _l(static_cast<const T &>(v[i]));
+        }
+
+        return retval;
+    }
+#endif // HOB_TR1_CONTAINERS
+
+    template<class K>
+    static size_t _l(const set<K> &v)
+    {
+        size_t retval = _l(v.size());
+
+        for (typename set<K>::const_iterator ci = v.begin(); ci != v.end(); ++ci)
+        {
+            retval += _l(static_cast<const K &>(*ci));
+        }
+
+        return retval;
+    }
+
+    template<class M>
+    static size_t _lm(const M &v)
     {
+        typedef typename M::key_type    K;
+        typedef typename M::mapped_type V;
+
         size_t len = v.size();
         size_t retval = _l(len);
 
-        for (typename map<K,V>::const_iterator ci = v.begin();
+        for (typename M::const_iterator ci = v.begin();
              (len > 0) && (ci != v.end());
              ++ci)
         {
@@ -1224,6 +5390,59 @@ protected:
         return retval;
     }
 
+    template<class T>
+    static inline size_t _l(const T &v, As<DEFAULT>)
+    {
+        return _l(v);
+    }
+
+    template<class T>
+    static inline size_t _l(const T &v, As<VARINT>)
+    {
+        return _l(word(v));
+    }
+
+    template<class T>
+    static inline size_t _l(const T &v, As<ZIGZAG>)
+    {
+        return _l(ZIGZAG_ENCODE(word(v)));
+    }
+
+    template<class T>
+    static inline size_t _l(const T &v, As<FIXED32>)
+    {
+        STATIC_CHECK(sizeof(T) <= sizeof(uint32_t), FIXED32_of_a_wider_type);
+
+        (void)v;
+
+        return sizeof(uint32_t);
+    }
+
+    template<class T>
+    static inline size_t _l(const T &v, As<FIXED64>)
+    {
+        (void)v;
+
+        return sizeof(uint64_t);
+    }
+
+    template<class T>
+    static size_t _l(const vector<T> &v, As<DELTA>)
+    {
+        return _l(v.size()) + (v.empty() ? 0 : _ld(&v[0], v.size()));
+    }
+
+    template<class T>
+    static size_t _ld(const T *v, size_t n)
+    {
+        uint8_t method = PACKED_FOR;
+
+        return _lp(v, n, method);
+    }
+
+    static size_t _ld(const float  *v, size_t n) { return _lg(v, n); }
+    static size_t _ld(const double *v, size_t n) { return _lg(v, n); }
+
 #if !defined(BINARY_ONLY)
     static void _t(ostream &o, const uint8_t &v, int indent = -1)
     {
@@ -1367,6 +5586,48 @@ protected:
     template<class T>
     static void _t(ostream &o, const vector<T> &v, int indent = -1)
     {
+        _t(o, v, indent, 'V');
+    }
+
+    template<class T>
+    static void _t(ostream &o, const packed<T> &v, int indent = -1)
+    {
+        _t(o, v, indent, 'P');
+    }
+
+    template<class T>
+    static void _t(ostream &o, const series<T> &v, int indent = -1)
+    {
+        _t(o, v, indent, 'G');
+    }
+
+    template<class T>
+    static void _t(ostream &o, const vector<T> &v, int indent, char tag)
+    {
+        _ti(o, v.begin(), v.size(), indent, tag);
+    }
+
+    template<class K>
+    static void _t(ostream &o, const set<K> &v, int indent = -1)
+    {
+        _ti(o, v.begin(), v.size(), indent, 'S');
+    }
+
+#if defined(HOB_TR1_CONTAINERS)
+    template<class T, size_t N>
+    static void _t(ostream &o, const array<T,N> &v, int indent = -1)
+    {
+        _ti(o, v.begin(), N, indent, 'A');
+    }
+#endif // HOB_TR1_CONTAINERS
+
+    // len items from it, tagged as told
+    //
+    template<class I>
+    static void _ti(ostream &o, I it, size_t len, int indent, char tag)
+    {
+        typedef typename iterator_traits<I>::value_type T;
+
         (void)indent;
 
         o << noshowpos << "{";
@@ -1376,9 +5637,7 @@ protected:
             o << endl;
         }
 
-        size_t len = v.size();
-
-        o << INDENT(1) << "\"V(" << len << ")\":[";
+        o << INDENT(1) << "\"" << tag << "(" << len << ")\":[";
 
         if (indent >= 0)
         {
@@ -1387,11 +5646,11 @@ protected:
 
         if (len > 0)
         {
-            for (size_t i=0; i<len; i++)
+            for (size_t i=0; i<len; i++, ++it)
             {
                 o << INDENT(2);
 
-                _t(o, static_cast<const T &>(v[i]),
+                _t(o, static_cast<const T &>(*it),
                       (indent >= 0) ? (indent+2) : -1);
 
                 if ((indent >=0) && (i < (len-1)))
@@ -1466,6 +5725,31 @@ protected:
     template<class K, class V>
     static void _t(ostream &o, const map<K,V> &v, int indent = -1)
     {
+        _tm(o, v, indent);
+    }
+
+    template<class K, class V>
+    static void _t(ostream &o, const flat_map<K,V> &v, int indent = -1)
+    {
+        _tm(o, v, indent);
+    }
+
+#if defined(HOB_TR1_CONTAINERS)
+    template<class K, class V>
+    static void _t(ostream &o, const unordered_map<K,V> &v, int indent = -1)
+    {
+        _tm(o, v, indent);
+    }
+#endif // HOB_TR1_CONTAINERS
+
+    // Maps, as iterated
+    //
+    template<class M>
+    static void _tm(ostream &o, const M &v, int indent)
+    {
+        typedef typename M::key_type    K;
+        typedef typename M::mapped_type V;
+
         (void)indent;
 
         o << noshowpos << "{";
@@ -1486,7 +5770,7 @@ protected:
 
         if (len > 0)
         {
-            for (typename map<K,V>::const_iterator ci = v.begin();
+            for (typename M::const_iterator ci = v.begin();
                 (len > 0) && (ci != v.end());
                 ++ci)
             {
@@ -1543,6 +5827,46 @@ protected:
 
         o << INDENT(0) << "}";
     }
+
+    template<class T>
+    static void _t(ostream &o, const T &v, int indent, As<DEFAULT>)
+    {
+        _t(o, v, indent);
+    }
+
+    // Hinted values are dumped as the unhinted ones, with the hint name
+    // appended to the type token: {"L/FIXED64":...}
+    //
+    template<class T, Encoding E>
+    static void _t(ostream &o, const T &v, int indent, As<E>)
+    {
+        stringstream ss;
+
+        _t(ss, v, indent);
+
+        string t = ss.str();
+        size_t p = t.find("\":");
+
+        o << t.substr(0, p) << "/" << encoding_name(E) << t.substr(p);
+    }
+
+    // Delta encoded vectors are dumped as the same encoded types
+    //
+    template<class T>
+    static void _t(ostream &o, const vector<T> &v, int indent, As<DELTA>)
+    {
+        _t(o, v, indent, 'P');
+    }
+
+    static void _t(ostream &o, const vector<float> &v, int indent, As<DELTA>)
+    {
+        _t(o, v, indent, 'G');
+    }
+
+    static void _t(ostream &o, const vector<double> &v, int indent, As<DELTA>)
+    {
+        _t(o, v, indent, 'G');
+    }
 #endif // !BINARY_ONLY
 
     static void _t(ostream &o, const void *v, size_t s)
@@ -1555,71 +5879,271 @@ protected:
                 << static_cast<int>(reinterpret_cast<const char*>(v)[i] & 0xff);
         }
 
-        o << dec << setw(0);
-    }
+        o << dec << setw(0);
+    }
+
+    virtual bool _r(HOB &ref) { (void)ref; return true; }
+
+    virtual bool _r(MemorySource &is_) { (void)is_; return true; }
+
+    virtual bool _r(istream &is_)
+    {
+        uint64_t id_ = UNDEFINED;
+        size_t   sz_ = 0;
+
+        if (NULL != _pl)
+        {
+            _pl->clear();
+        }
+
+        return read_header(is_, id_, sz_) && read_along(is_, id_, sz_);
+    }
+
+    // Frame header: the ID, then the payload size, if any
+    //
+    bool read_header(istream &is_, uint64_t &id_, size_t &sz_)
+    {
+        sz_ = 0;
+
+        return _r(is_, id_)
+               &&
+               (!has_payload(id_) || (_r(is_, sz_) && (sz_ <= limits().frame)));
+    }
+
+    // The payload is read along, the typed HOBs then decode it from
+    // memory: the stream is never sought back
+    //
+    bool read_along(istream &is_, const uint64_t &id_, size_t sz_)
+    {
+        if (sz_ > 0)
+        {
+            vector<uint8_t> &pl_ = buffer();
+
+            pl_.resize(sz_);
+
+            if (!deserialize(is_,&pl_[0],sz_))
+            {
+                pl_.clear();
+
+                return false;
+            }
+        }
+        else
+        if (NULL != _pl)
+        {
+            _pl->clear();
+        }
+
+        _id = id_;
+
+        return true;
+    }
+
+    // The payload is decoded straight from the stream buffer when whole
+    // there, from a copy otherwise
+    //
+    bool read_payload(istream &is_, size_t sz_)
+    {
+        reset_changes();
+
+        if (bare(is_))
+        {
+            streambuf *sb = is_.rdbuf();
+
+            const uint8_t *s = Window::begin(sb);
+
+            if (static_cast<size_t>(Window::end(sb) - s) >= sz_)
+            {
+                MemorySource ms(s, sz_);
+
+                bool rv = _r(ms);
+
+                Window::consume(sb, sz_);
+
+                return rv;
+            }
+        }
+
+        vector<uint8_t> &pl_ = buffer();
+
+        pl_.resize(sz_);
+
+        if ((sz_ > 0) && !deserialize(is_,&pl_[0],sz_))
+        {
+            pl_.clear();
+
+            return false;
+        }
+
+        MemorySource ms = source(*this);
+
+        bool rv = _r(ms);
+
+        pl_.clear();
+
+        return rv;
+    }
+
+    static bool skip_payload(istream &is_, size_t sz_)
+    {
+        streamsize n = static_cast<streamsize>(sz_);
+
+        return (0 == n) || (is_.ignore(n).gcount() == n);
+    }
+
+    // Payload read along with the ID by the last _r(istream&)
+    //
+    static MemorySource source(const HOB &ref)
+    {
+        if ((NULL == ref._pl) || ref._pl->empty())
+        {
+            return MemorySource(NULL, 0);
+        }
+
+        return MemorySource(&(*ref._pl)[0], ref._pl->size());
+    }
+
+    virtual bool _w(ostream &os) const { (void)os; return true; }
+
+    virtual bool _w(MemorySink &os) const { (void)os; return true; }
+
+    virtual bool _w(DigestSink &os) const { (void)os; return true; }
+
+    virtual size_t _l() const { return 0; }
+
+    // The kept frame, encoded again where touched, if any (CACHE_ENCODING)
+    //
+    virtual bool encoded(const uint8_t *&p, size_t &n) const
+    {
+        (void)p;
+        (void)n;
+
+        return false;
+    }
+
+    // Encodes the field f of value v into the frame being encoded, unless
+    // its bytes in the current frame are still good
+    //
+    template<size_t N, class T, class H>
+    static bool _we(Encoded<N, true> &c, size_t f, const T &v, H hint)
+    {
+        typedef typename Encoded<N, true>::Layout Layout;
+
+        const Layout &o = c.l[c.cur];
+        Layout       &e = c.l[c.cur ^ 1];
+        size_t        a = e.b.size();
+
+        e.at[f] = a;
+
+        if (c.valid && !c.dirty[f] && _kept(&v))
+        {
+            e.b.insert(e.b.end(), o.b.begin() + o.at[f],
+                                  o.b.begin() + o.at[f+1]);
+        }
+        else
+        {
+            c.nested |= !_kept(&v);
+
+            Sizes sizes;
+
+            size_t len = _l(v, hint);
+
+            sizes.replay();
+
+            e.b.resize(a + len);
+
+            MemorySink ms(&e.b[0] + a, len);
+
+            if (!_w(ms, v, hint))
+            {
+                return false;
+            }
+        }
+
+        e.at[f+1] = e.b.size();
 
-    virtual bool _r(HOB &ref) { (void)ref; return true; }
+        return true;
+    }
 
-    virtual bool _r(istream &is_)
+    // Encodes the field f of value v again in place, in the current frame,
+    // if touched and still of the same length there
+    //
+    template<size_t N, class T, class H>
+    static bool _wi(Encoded<N, true> &c, size_t f, const T &v, H hint)
     {
-        uint64_t id_;
+        typename Encoded<N, true>::Layout &o = c.l[c.cur];
+
+        if (!c.dirty[f] && _kept(&v))
+        {
+            return true;
+        }
+
+        Sizes sizes;
 
-        _ss.str(string());
-        _is = NULL;
-        _sp = 0;
-        _ep = 0;
+        size_t len = _l(v, hint);
 
-        if (!_r(is_, id_))
+        if (len != (o.at[f+1] - o.at[f]))
         {
             return false;
         }
 
-        size_t sz_ = 0;
+        sizes.replay();
 
-        if (has_payload(id_) && !_r(is_, sz_))
+        MemorySink ms(&o.b[0] + o.at[f], len);
+
+        if (!_w(ms, v, hint))
         {
             return false;
         }
 
-        bool success = true;
+        c.dirty.reset(f);
 
-        _is = &is_;
+        return true;
+    }
 
-        if ((sz_ > 0) && (static_cast<istream&>(*this).tellg() < 0))
-        {
-            success = false;
+    // Starts and ends the encoding of the frame of the given ID
+    //
+    template<size_t N>
+    static void _we(Encoded<N, true> &c)
+    {
+        typename Encoded<N, true>::Layout &e = c.l[c.cur ^ 1];
 
-            char *buffer = new char[sz_];
+        e.b.resize(Encoded<N, true>::HEAD);
 
-            if (NULL != buffer)
-            {
-                if (deserialize(is_,buffer,sz_))
-                {
-                    // if (ASSERT_SWRITE(_ss,buffer,sz_))
-                    if (_ss.write(buffer,sz_).good())
-                    {
-                        _is     = NULL;
-                        success = true;
-                    }
-                }
+        e.at[0] = e.b.size();
 
-                delete[] buffer;
-            }
-        }
+        c.nested = false;
+    }
+
+    template<size_t N>
+    static void _we(Encoded<N, true> &c, const UID &id_)
+    {
+        typename Encoded<N, true>::Layout &e = c.l[c.cur ^ 1];
 
-        if (success)
+        uint8_t d[Encoded<N, true>::HEAD];
+        size_t  sz = e.b.size() - Encoded<N, true>::HEAD;
+        size_t  n  = varint_pack(d, id_);
+
+        if (has_payload(id_))
         {
-            _sp = static_cast<istream&>(*this).tellg();
-            _ep = _sp + sz_;
-            _id = id_;
+            n += varint_pack(d + n, sz);
         }
 
-        return success;
-    }
+        e.begin = Encoded<N, true>::HEAD - n;
 
-    virtual bool _w(ostream &os) const { (void)os; return true; }
+        memcpy(&e.b[e.begin], d, n);
 
-    virtual size_t _l() const { return 0; }
+        c.cur  ^= 1;
+        c.valid = true;
+
+        c.dirty.reset();
+    }
+
+    // Fields whose bytes are kept as long as not touched: all but the HOBs,
+    // encoded again from their own kept frame, if any
+    //
+    static inline bool _kept(const void *) { return true;  }
+    static inline bool _kept(const HOB  *) { return false; }
 
     inline const uint64_t& get_id() const
     {
@@ -1650,10 +6174,7 @@ protected:
             //
             _np++;
 
-            for (size_t i = 0; in[i]; ++i)
-            {
-                _id = HSEED * _id + in[i];
-            }
+            _id = hash(_id, in);
         }
         else
         //
@@ -1673,6 +6194,183 @@ protected:
         }
     }
 
+    inline void set_id(const UID &id_)
+    {
+        _id = id_;
+        _np = -1;
+    }
+
+    // Field types laid out differently on the wire by the current profile,
+    // also when held by other containers
+    //
+    template<class T>
+    static inline CONSTEXPR bool is_tagged(const T *) { return false; }
+
+#if defined(CONTIGUOUS_VECTORS)
+    static inline CONSTEXPR bool is_tagged(const vector<uint8_t> *) { return true; }
+    static inline CONSTEXPR bool is_tagged(const vector<int8_t > *) { return true; }
+    static inline CONSTEXPR bool is_tagged(const vector<float  > *) { return true; }
+    static inline CONSTEXPR bool is_tagged(const vector<double > *) { return true; }
+#endif // CONTIGUOUS_VECTORS
+
+    template<class T>
+    static inline CONSTEXPR bool is_tagged(const vector<T> *)
+    {
+        return is_tagged(static_cast<const T *>(NULL));
+    }
+
+    template<class T>
+    static inline CONSTEXPR bool is_tagged(const optional<T> *)
+    {
+        return is_tagged(static_cast<const T *>(NULL));
+    }
+
+    template<class T>
+    static inline CONSTEXPR bool is_tagged(const set<T> *)
+    {
+        return is_tagged(static_cast<const T *>(NULL));
+    }
+
+    template<class K, class V>
+    static inline CONSTEXPR bool is_tagged(const map<K,V> *)
+    {
+        return is_tagged(static_cast<const K *>(NULL)) ||
+               is_tagged(static_cast<const V *>(NULL));
+    }
+
+    template<class K, class V>
+    static inline CONSTEXPR bool is_tagged(const flat_map<K,V> *)
+    {
+        return is_tagged(static_cast<const K *>(NULL)) ||
+               is_tagged(static_cast<const V *>(NULL));
+    }
+
+#if defined(HOB_TR1_CONTAINERS)
+    template<class K, class V>
+    static inline CONSTEXPR bool is_tagged(const unordered_map<K,V> *)
+    {
+        return is_tagged(static_cast<const K *>(NULL)) ||
+               is_tagged(static_cast<const V *>(NULL));
+    }
+
+    template<class T, size_t N>
+    static inline CONSTEXPR bool is_tagged(const array<T,N> *)
+    {
+        return is_tagged(static_cast<const T *>(NULL));
+    }
+#endif // HOB_TR1_CONTAINERS
+
+    static inline CONSTEXPR uint64_t hash(uint64_t h, const char *in)
+    {
+        return (0 != *in) ? hash(HSEED * h + *in, in + 1) : h;
+    }
+
+    // 64 bits hash of n bytes, a word at a time
+    //
+    static inline uint64_t digest(const uint8_t *p, size_t n, uint64_t h = 0)
+    {
+        const uint64_t k = 0x9e3779b97f4a7c15llu;
+
+        h ^= n * k;
+
+        for (; n >= sizeof(uint64_t); p += sizeof(uint64_t),
+                                      n -= sizeof(uint64_t))
+        {
+            uint64_t w;
+
+            memcpy(&w, p, sizeof(w));
+
+            h  = (h ^ le(w)) * k;
+            h ^= h >> 32;
+        }
+
+        if (n > 0)
+        {
+            uint64_t w = 0;
+
+            for (size_t i=0; i<n; i++)
+            {
+                w |= static_cast<uint64_t>(p[i]) << (i * 8);
+            }
+
+            h  = (h ^ w) * k;
+            h ^= h >> 32;
+        }
+
+        // Final avalanche (MurmurHash3 fmix64)
+
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdllu;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53llu;
+        h ^= h >> 33;
+
+        return h;
+    }
+
+    //
+    // HOB ID evaluation from the HOB schema, the same as update_id() does:
+    //
+    // - the HOB name or numeric ID, followed by
+    // - the name and type of each core field
+    // - the wire profile tag and the encoding hint of each core field
+    //
+    // Evaluated at compile time when constexpr is available.
+    //
+    class Hasher
+    {
+    public:
+        CONSTEXPR Hasher(const UID &id_) : _id(id_), _np(false) {}
+
+        CONSTEXPR Hasher(const char *id_) : _id(hash(0, id_)), _np(false) {}
+
+        // Core field name or type
+        //
+        CONSTEXPR Hasher field(const char *s) const
+        {
+            return Hasher(hash(_id, s), true);
+        }
+
+        // Extra field
+        //
+        CONSTEXPR Hasher extra() const
+        {
+            return Hasher(_id, true);
+        }
+
+        // Make the HOB ID depend on the wire profile of the field type, so
+        // that peers built with a different profile see it as an unknown
+        // HOB
+        //
+        template<class T>
+        CONSTEXPR Hasher tag(const T *t) const
+        {
+            return is_tagged(t) ? Hasher(hash(_id, "CONTIGUOUS_VECTORS"), _np)
+                                : *this;
+        }
+
+        template<Encoding E>
+        CONSTEXPR Hasher hint(As<E>) const
+        {
+            return (DEFAULT != E) ? Hasher(hash(_id, encoding_name(E)), _np)
+                                  : *this;
+        }
+
+        // HOBs with    parameters have an odd  ID
+        // HOBs without parameters have an even ID
+        //
+        CONSTEXPR UID id() const
+        {
+            return (_id << 1) | (_np ? 1 : 0);
+        }
+
+    private:
+        CONSTEXPR Hasher(const UID &id_, bool np_) : _id(id_), _np(np_) {}
+
+        UID  _id;
+        bool _np;
+    };
+
     static inline bool has_payload(uint64_t id)
     {
         // An odd ID means attached payload
@@ -1720,32 +6418,56 @@ protected:
         o << "}";
     }
 
-    virtual void flush_pending()
+private:
+    static const size_t UNSIZED = static_cast<size_t>(-1);
+
+    UID              _id;
+    vector<uint8_t> *_pl; // payload read along with the ID, on demand
+    ssize_t          _np;
+
+    template<class S>
+    bool write_frame(S &os, size_t sz) const
     {
-        istream & s_ = static_cast<istream&>(*this);
+        if (UNDEFINED == _id)
+        {
+            return true;
+        }
 
-        size_t cp = s_.tellg();
+        if (!_w(os, _id))
+        {
+            return false;
+        }
 
-        if (cp < _ep)
+        if (has_payload(_id))
         {
-            s_.ignore(_ep - cp);
+            if (!_w(os,sz) || !_w(os))
+            {
+                return false;
+            }
         }
+
+        return true;
     }
 
-private:
-    UID           _id;
-    stringstream  _ss;
-    istream      *_is;
-    size_t        _sp;
-    size_t        _ep;
-    ssize_t       _np;
+    // Payload buffer, allocated only by the HOBs actually reading from
+    // streams and reused across the frames they read
+    //
+    vector<uint8_t> &buffer()
+    {
+        if (NULL == _pl)
+        {
+            _pl = new vector<uint8_t>;
+        }
+
+        return *_pl;
+    }
 
     // ZIGZAG decoding
     //
-    template<class T>
-    bool _z(istream &is_, T &v, ssize_t field=-1)
+    template<class T, class S>
+    bool _z(S &is_, T &v, ssize_t field=-1)
     {
-        uint64_t r;
+        uint64_t r = 0;
 
         if (!_r(is_, r))
         {
@@ -1761,6 +6483,11 @@ private:
         return true;
     }
 
+    bool deserialize(MemorySource &is_, void *v, size_t s)
+    {
+        return is_.read(static_cast<char *>(v),s).good();
+    }
+
     bool deserialize(istream &is_, void *v, size_t s)
     {
         // Check whether **only** an internal logic error occurred ...
@@ -1774,13 +6501,79 @@ private:
 
         // Fail in case of any other error
         //
-        return is_.good() && is_.read(static_cast<char *>(v),s).good();
+        if (!bare(is_))
+        {
+            return is_.good() && is_.read(static_cast<char *>(v),s).good();
+        }
+
+        // Straight from the stream buffer, as istream::read() would do
+
+        streamsize n = static_cast<streamsize>(s);
+
+        if (is_.rdbuf()->sgetn(static_cast<char *>(v), n) != n)
+        {
+            is_.setstate(ios::eofbit | ios::failbit);
+
+            return false;
+        }
+
+        return true;
+    }
+
+    // Raw bytes writing, straight to the stream buffer when possible
+    //
+    static inline bool _ws(MemorySink &os, const void *v, const size_t s)
+    {
+        return os.write(reinterpret_cast<const char *>(v),s).good();
+    }
+
+    static inline bool _ws(DigestSink &os, const void *v, const size_t s)
+    {
+        return os.write(reinterpret_cast<const char *>(v),s).good();
+    }
+
+    static inline bool _ws(ostream &os, const void *v, const size_t s)
+    {
+        if (!bare(os))
+        {
+            return os.write(reinterpret_cast<const char *>(v),s).good();
+        }
+
+        streambuf *sb = os.rdbuf();
+
+        if (Window::room(sb) >= s)
+        {
+            Window::put(sb, v, s);
+
+            return true;
+        }
+
+        streamsize n = static_cast<streamsize>(s);
+
+        if (sb->sputn(reinterpret_cast<const char *>(v), n) != n)
+        {
+            os.setstate(ios::badbit);
+
+            return false;
+        }
+
+        return true;
     }
 
 #if defined(DEBUG_WRITE)
+    static bool _w(MemorySink &os, const void *v, const size_t s)
+    {
+        return _ws(os,v,s);
+    }
+
+    static bool _w(DigestSink &os, const void *v, const size_t s)
+    {
+        return _ws(os,v,s);
+    }
+
     static bool _w(ostream &os, const void *v, const size_t s)
     {
-        if (os.write(reinterpret_cast<const char *>(v),s).good())
+        if (_ws(os,v,s))
         {
 #if !defined(DUMP_ALL)
             if (dynamic_cast<ofstream*>(&os) != NULL)
@@ -1800,13 +6593,40 @@ private:
     }
 #endif // DEBUG_WRITE
 
-    static bool parse(istream &is, ostream &os, char t)
+    // raw  : kind of the vector whose items are being parsed, if any:
+    //        - 'V': vector<>, items packed as contiguous vector items
+    //               (CONTIGUOUS_VECTORS)
+    //        - 'P': packed<>, items collected as 64 bits words
+    //        - 'G': series<>, items bits collected as 64 bits words
+    //        applies to the array groups (t == ']'), to the group keyword
+    //        (t == '}') and to the keyword value (t == '"')
+    //
+    // items: set to the vector kind when the keyword introduces the array
+    //        of a vector
+    //
+    static bool parse(istream &is,
+                      ostream &os,
+                      char     t,
+                      char     raw   = 0,
+                      char    *items = NULL)
     {
+        Nesting in_(limits().groups);
+
+        if (!in_)
+        {
+            // Unwinds all the enclosing groups
+
+            is.setstate(ios::badbit);
+
+            return false;
+        }
+
         char c;
         bool group = ('}' == t);
         bool array = (']' == t);
         bool kword = ('"' == t);
         bool skip  = false;
+        char vitem = 0;
 
         string token;
 
@@ -1831,10 +6651,12 @@ private:
 
                 switch (c)
                 {
-                    case '{' : parse(is, os, '}'); break;
-                    case '[' : parse(is, os, ']'); break;
-                    case '"' : parse(is, os, '"'); break;
-                    default  :                     break;
+                    case '{' : parse(is, os, '}', array ? raw : 0); break;
+                    case '[' : parse_array(is, os, vitem);
+                               vitem = 0;                           break;
+                    case '"' : parse(is, os, '"', group ? raw : 0,
+                                                  &vitem          ); break;
+                    default  :                                      break;
                 }
             }
         }
@@ -1845,6 +6667,16 @@ private:
             {
                 if (':' == c)
                 {
+                    string hint;
+                    size_t hint_pos = token.find('/');
+
+                    if (string::npos != hint_pos)
+                    {
+                        hint = token.substr(hint_pos + 1);
+
+                        token.erase(hint_pos);
+                    }
+
                     string value;
                     bool   dump      = false;
                     bool   has_value = true;
@@ -1890,13 +6722,40 @@ private:
                         count_pos = strlen("V(");
                     }
                     else
-                    if (token.find("M(") == 0) // map<>
+                    if (token.find("M(") == 0) // map<> and the like
                     {
                         dump      = true;
                         has_value = false;
                         count_pos = strlen("M(");
                     }
                     else
+                    if (token.find("S(") == 0) // set<>
+                    {
+                        dump      = true;
+                        has_value = false;
+                        count_pos = strlen("S(");
+                    }
+                    else
+                    if (token.find("A(") == 0) // array<>, no items count
+                    {
+                        dump      = true;
+                        has_value = false;
+                    }
+                    else
+                    if (token.find("P(") == 0) // packed<>
+                    {
+                        dump      = true;
+                        has_value = false;
+                        count_pos = strlen("P(");
+                    }
+                    else
+                    if (token.find("G(") == 0) // series<>
+                    {
+                        dump      = true;
+                        has_value = false;
+                        count_pos = strlen("G(");
+                    }
+                    else
                     if (token.find("O(") == 0) // optional<>
                     {
                         dump      = true;
@@ -1957,9 +6816,53 @@ private:
 
                             uint64_t v_count = strtoull(count.c_str(),NULL,10);
 
-                            ASSERT_DUMP(os, v_count);
+                            ASSERT_DUMP(os, v_count);
+
+                            if ((NULL != items) &&
+                                ((token.find("V(") == 0) ||
+                                 (token.find("P(") == 0) ||
+                                 (token.find("G(") == 0)))
+                            {
+                                *items = token[0];
+                            }
+                        }
+
+                        if (has_value && !hint.empty())
+                        {
+                            // hinted value: packed as told by the hint
+
+                            uint64_t w = 0;
+
+                            if ("F" == token)
+                            {
+                                w = word(hex_to_val<float>(value));
+                            }
+                            else
+                            if ("D" == token)
+                            {
+                                w = word(hex_to_val<double>(value));
+                            }
+                            else
+                            if ("B" == token)
+                            {
+                                w = ("true" == value);
+                            }
+                            else
+                            if (value[0] == '+' || value[0] == '-')
+                            {
+                                w = static_cast<uint64_t>(strtoll(value.c_str(),NULL,10));
+                            }
+                            else
+                            {
+                                w = strtoull(value.c_str(),NULL,10);
+                            }
+
+                            if (!_wh(os, w, hint))
+                            {
+                                return false;
+                            }
                         }
-
+                        else
                         if (has_value)
                         {
                             if (("C" == token) || // [u]int8_t  (char)
@@ -1967,6 +6870,31 @@ private:
                                 ("I" == token) || // [u]int32_t (int)
                                 ("L" == token))   // [u]int64_t (long)
                             {
+                                if ('P' == raw)
+                                {
+                                    // packed<> item, as 64 bits word
+
+                                    uint64_t v_value = (value[0] == '+' || value[0] == '-')
+                                        ? static_cast<uint64_t>(strtoll(value.c_str(),NULL,10))
+                                        : strtoull(value.c_str(),NULL,10);
+
+                                    if (!_wf(os, v_value)) { return false; }
+                                }
+                                else
+#if defined(CONTIGUOUS_VECTORS)
+                                if (('V' == raw) && ("C" == token))
+                                {
+                                    // [u]int8_t contiguous vector item
+
+                                    uint8_t v_value = static_cast<uint8_t>(
+                                        (value[0] == '+' || value[0] == '-')
+                                        ? strtoll (value.c_str(),NULL,10)
+                                        : strtoull(value.c_str(),NULL,10));
+
+                                    if (!_wf(os, v_value)) { return false; }
+                                }
+                                else
+#endif // CONTIGUOUS_VECTORS
                                 if (value[0] == '+' || value[0] == '-')
                                 {
                                     // signed integer values
@@ -1985,6 +6913,40 @@ private:
                                 }
                             }
                             else
+                            if (('G' == raw) && ("F" == token)) // float series item
+                            {
+                                if (!_wf(os, word(hex_to_val<float>(value))))
+                                {
+                                    return false;
+                                }
+                            }
+                            else
+                            if (('G' == raw) && ("D" == token)) // double series item
+                            {
+                                if (!_wf(os, word(hex_to_val<double>(value))))
+                                {
+                                    return false;
+                                }
+                            }
+                            else
+#if defined(CONTIGUOUS_VECTORS)
+                            if (('V' == raw) && ("F" == token)) // float vector item
+                            {
+                                if (!_wf(os, hex_to_val<float>(value)))
+                                {
+                                    return false;
+                                }
+                            }
+                            else
+                            if (('V' == raw) && ("D" == token)) // double vector item
+                            {
+                                if (!_wf(os, hex_to_val<double>(value)))
+                                {
+                                    return false;
+                                }
+                            }
+                            else
+#endif // CONTIGUOUS_VECTORS
                             if ("F" == token) // float
                             {
                                 ASSERT_DUMP(os, hex_to_val<float>(value));
@@ -2044,7 +7006,42 @@ private:
             }
         }
 
-        return true;
+        return !is.bad();
+    }
+
+    // Parses the array of a vector of the given kind (0 if not a vector).
+    //
+    // The items of packed<> and series<> vectors are collected first, then
+    // packed all at once.
+    //
+    static bool parse_array(istream &is, ostream &os, char kind)
+    {
+        if (('P' != kind) && ('G' != kind))
+        {
+            return parse(is, os, ']', kind);
+        }
+
+        stringstream ws;
+
+        parse(is, ws, ']', kind);
+
+        string           b = ws.str();
+        vector<uint64_t> w(b.size() / sizeof(uint64_t));
+
+        for (size_t i=0; i<w.size(); i++)
+        {
+            memcpy(&w[i], &b[i * sizeof(uint64_t)], sizeof(uint64_t));
+
+            w[i] = le(w[i]);
+        }
+
+        if (w.empty())
+        {
+            return true;
+        }
+
+        return ('P' == kind) ? _wp(os, &w[0], w.size())
+                             : _wg(os, &w[0], w.size());
     }
 
     static inline uint8_t hex_to_int(const char &c)
@@ -2070,6 +7067,110 @@ private:
     }
 };
 
+#define ZIGZAG_CAST(T)                                                         \
+template<>                                                                     \
+struct HOB::Zigzag<T>                                                          \
+{                                                                              \
+    static inline T decode(const uint64_t &r)                                  \
+    {                                                                          \
+        return static_cast<T>(ZIGZAG_DECODE(r));                               \
+    }                                                                          \
+};
+
+ZIGZAG_CAST(int8_t )
+ZIGZAG_CAST(int16_t)
+ZIGZAG_CAST(int32_t)
+ZIGZAG_CAST(int64_t)
+
+//
+// Index of the N fields of a frame held in memory, behind the Lazy accessors
+// of the HOBSTRUCTs: the offsets of the fields, taken in a single pass on
+// first access, and the fields decoded so far. The fields are skipped and
+// decoded by a plain HOB held here, so Lazy does not derive from HOB.
+//
+template<size_t N>
+class HOB::LazyIndex
+{
+public:
+    LazyIndex(const View &v)
+        : _v (v)
+        , _s (NULL, 0)
+        , _i (false)
+        , _ok(false)
+    {
+    }
+
+    inline bool indexed() const { return _i; }
+
+    inline bool ok() const { return _ok; }
+
+    inline bool decoded(size_t f) const { return _d[f]; }
+
+    // Starts indexing the frame: whether it is a HOB of the given ID
+    //
+    bool begin(const UID &id)
+    {
+        _i = true;
+
+        for (size_t f=0; f<=N; f++)
+        {
+            _o[f] = _v.payload_size();
+        }
+
+        _s = MemorySource(_v.payload(), _v.payload_size());
+
+        return (_v.id() == id);
+    }
+
+    // Whether the frame holds all the mandatory fields
+    //
+    bool end(bool ok)
+    {
+        _ok = ok;
+
+        return _ok;
+    }
+
+    // Marks the field f at the current offset and skips it
+    //
+    template<class T, class H>
+    bool skip(size_t f, const T *t, H h)
+    {
+        if (_s.eof())
+        {
+            return false;
+        }
+
+        _o[f] = _s.data() - _v.payload();
+
+        return _h._k(_s, t, h);
+    }
+
+    // Decodes the field f into v, once: a field missing in the frame keeps
+    // its value
+    //
+    template<class T, class H>
+    void read(size_t f, T &v, H h)
+    {
+        size_t o = _ok ? _o[f] : _v.payload_size();
+
+        MemorySource is_(_v.payload() + o, _v.payload_size() - o);
+
+        _d[f] = true;
+
+        (void)_h._r(is_, v, -1, h);
+    }
+
+private:
+    View         _v;
+    MemorySource _s;
+    bool         _i;
+    bool         _ok;
+    size_t       _o[N + 1];
+    bitset<N>    _d;
+    HOB          _h;
+};
+
 inline bool operator<<(ostream  &o, HOB      &m) { return m >> o; }
 inline bool operator>>(istream  &i, HOB      &m) { return m << i; }
 inline bool operator>>(HOB      &i, HOB      &m) { return m << i; }
@@ -2099,18 +7200,61 @@ inline bool operator>>(HOB::Src &i, HOB::Snk &o) { return HOB::parse(i,o); }
 
 #define SCAN_FIELDS_INNER_I() SCAN_FIELDS_INNER
 
+//
+// Fields are declared as (type, name [, default [, encoding hint]])
+//
+#define FIELD_HINT(...)          HOB::As<HOB::SECOND(__VA_ARGS__, DEFAULT, ~)>()
+
 #define DECLARE_ENUM(t, n, ...)  _ ## n,
 #define DECLARE_FIELD(t, n, ...) t n;
-#define INIT_FIELD(t, n, ...)    IF(HAS_ARGS(__VA_ARGS__) )(n = __VA_ARGS__;)
-#define READ_FIELD(t, n, ...)    && HOB::_r(is_, n, _ ## n)
-#define WRITE_FIELD(t, n, ...)   && HOB::_w(os, n)
-#define FIELD_SIZE(t, n, ...)    + HOB::_l(n)
-#define COMPARE_FIELD(t, n, ...) && (n == ref.n)
+#define INIT_FIELD(t, n, ...)    IF(HAS_ARGS(__VA_ARGS__) )(n = FIRST(__VA_ARGS__);)
+#define READ_FIELD(t, n, ...)    && HOB::_r(is_, n, _ ## n,                    \
+                                            FIELD_HINT(__VA_ARGS__),           \
+                                            _hob_track())
+#define WRITE_FIELD(t, n, ...)   && HOB::_w(os, n, FIELD_HINT(__VA_ARGS__))
+#define FIELD_SIZE(t, n, ...)    + HOB::_l(n, FIELD_HINT(__VA_ARGS__))
+#define COMPARE_FIELD(t, n, ...) && HOB::_eq(n, ref.n)
 #define CLONE_FIELD(t, n, ...)   n = ref.n;
-#define UPDATE_NP(t, n, ...)     update_id("");
-#define UPDATE_ID(t, n, ...)     HUPDATE(STR(name_)); \
-                                 HUPDATE(STR(t    )); \
-                                 HUPDATE(STR(n    ));
+#define ENCODE_FIELD(t, n, ...)  && HOB::_we(_hob_c, _ ## n, n,                \
+                                            FIELD_HINT(__VA_ARGS__))
+#define PATCH_FIELD(t, n, ...)   && HOB::_wi(_hob_c, _ ## n, n,                \
+                                            FIELD_HINT(__VA_ARGS__))
+#define DELTA_READ(t, n, ...)    && (!_hob_d[_ ## n]                           \
+                                     || (true READ_FIELD(t, n, __VA_ARGS__)))
+#define DELTA_WRITE(t, n, ...)   && (!_hob_d[_ ## n]                           \
+                                     || (true WRITE_FIELD(t, n, __VA_ARGS__)))
+#define DELTA_SIZE(t, n, ...)    + (_hob_d[_ ## n]                             \
+                                     ? (0 FIELD_SIZE(t, n, __VA_ARGS__)) : 0)
+#define SETTER_FIELD(t, n, ...)                                                \
+        void set_ ## n(const t &_hob_v)                                        \
+        {                                                                      \
+            n = _hob_v;                                                        \
+                                                                               \
+            touch(_ ## n);                                                     \
+        }
+#define HASH_EXTRA(t, n, ...)    .extra()
+#define LAZY_DECLARE(t, n, ...)  t n ## _;
+#define LAZY_INIT(t, n, ...)     IF(HAS_ARGS(__VA_ARGS__) )(n ## _ = FIRST(__VA_ARGS__);)
+#define LAZY_INDEX(t, n, ...)    && _lz_frame.skip(_ ## n,                     \
+                                     static_cast<const t *>(NULL),             \
+                                     FIELD_HINT(__VA_ARGS__))
+#define LAZY_FIELD(t, n, ...)                                                  \
+        const t &n()                                                           \
+        {                                                                      \
+            if (!_lz_frame.decoded(_ ## n))                                    \
+            {                                                                  \
+                (void)_lz_index();                                             \
+                                                                               \
+                _lz_frame.read(_ ## n, n ## _, FIELD_HINT(__VA_ARGS__));       \
+            }                                                                  \
+                                                                               \
+            return n ## _;                                                     \
+        }
+#define HASH_FIELD(t, n, ...)    .field(STR(name_))                            \
+                                 .field(STR(t    ))                            \
+                                 .field(STR(n    ))                            \
+                                 .tag(static_cast<const t *>(NULL))            \
+                                 .hint(FIELD_HINT(__VA_ARGS__))
 
 #if !defined(BINARY_ONLY)
 #define WTEXT_FIELD(t, n, ...)                                                 \
@@ -2129,7 +7273,8 @@ inline bool operator>>(HOB::Src &i, HOB::Snk &o) { return HOB::parse(i,o); }
               << "\"v\": ";                                                    \
         }                                                                      \
                                                                                \
-        _t(o, static_cast<const t&>(n), (indent >= 0) ? (indent+3): -1);       \
+        _t(o, static_cast<const t&>(n), (indent >= 0) ? (indent+3): -1,       \
+              FIELD_HINT(__VA_ARGS__));                                        \
                                                                                \
         if (indent >=0)                                                        \
         {                                                                      \
@@ -2247,6 +7392,36 @@ inline bool operator>>(HOB::Src &i, HOB::Snk &o) { return HOB::parse(i,o); }
             __ ## n ## __changed__fields__[f] = v;                             \
         }                                                                      \
 
+// Change tracking mode of a HOBSTRUCT, given before it:
+//
+//    TRACK_CHANGES(Name, TRACK_READS)
+//
+//    HOBSTRUCT(Name, "name", ...)
+//
+#define TRACK_CHANGES(name_, mode_)                                            \
+class name_;                                                                   \
+                                                                               \
+template<>                                                                     \
+struct HOB::Tracked<name_>                                                     \
+{                                                                              \
+    static const HOB::Tracking mode = HOB::mode_;                              \
+};
+
+// Encoded frame kept by a HOBSTRUCT, given before it:
+//
+//    CACHE_ENCODING(Name)
+//
+//    HOBSTRUCT(Name, "name", ...)
+//
+#define CACHE_ENCODING(name_)                                                  \
+class name_;                                                                   \
+                                                                               \
+template<>                                                                     \
+struct HOB::Cached<name_>                                                      \
+{                                                                              \
+    static const bool value = true;                                            \
+};
+
 #define HOBSTRUCT(name_, value_, ...)                                          \
 class name_ : public HOB                                                       \
 {                                                                              \
@@ -2258,21 +7433,91 @@ public:                                                                        \
         _FIELDS_COUNT_                                                         \
     };                                                                         \
                                                                                \
+    /* On demand access to the fields of a frame held in memory: the frame */ \
+    /* is indexed on first access, each field is decoded on its own first  */ \
+    /* access. Fields missing in the frame keep their default value.       */ \
+                                                                               \
+    class Lazy                                                                 \
+    {                                                                          \
+    public:                                                                    \
+        Lazy(const HOB::View &v)                                               \
+            : _lz_frame(v)                                                     \
+        {                                                                      \
+            SCAN_FIELDS(LAZY_INIT, FIRST(__VA_ARGS__))                         \
+            SCAN_FIELDS(LAZY_INIT, REMAIN(__VA_ARGS__))                        \
+        }                                                                      \
+                                                                               \
+        /* Whether the frame is a name_ with all the mandatory fields  */      \
+                                                                               \
+        bool frame_ok()                                                        \
+        {                                                                      \
+            return _lz_index();                                                \
+        }                                                                      \
+                                                                               \
+        SCAN_FIELDS(LAZY_FIELD, FIRST(__VA_ARGS__))                            \
+        SCAN_FIELDS(LAZY_FIELD, REMAIN(__VA_ARGS__))                           \
+                                                                               \
+    private:                                                                   \
+        HOB::LazyIndex<_FIELDS_COUNT_> _lz_frame;                              \
+                                                                               \
+        SCAN_FIELDS(LAZY_DECLARE, FIRST(__VA_ARGS__))                          \
+        SCAN_FIELDS(LAZY_DECLARE, REMAIN(__VA_ARGS__))                         \
+                                                                               \
+        bool _lz_index()                                                       \
+        {                                                                      \
+            if (_lz_frame.indexed())                                           \
+            {                                                                  \
+                return _lz_frame.ok();                                         \
+            }                                                                  \
+                                                                               \
+            if (_lz_frame.end(_lz_frame.begin(name_::ID())                     \
+                              SCAN_FIELDS(LAZY_INDEX, FIRST(__VA_ARGS__))))    \
+            {                                                                  \
+                (void)(true SCAN_FIELDS(LAZY_INDEX, REMAIN(__VA_ARGS__)));     \
+            }                                                                  \
+                                                                               \
+            return _lz_frame.ok();                                             \
+        }                                                                      \
+    };                                                                         \
+                                                                               \
     SCAN_FIELDS(DECLARE_FIELD, FIRST(__VA_ARGS__))                             \
     SCAN_FIELDS(DECLARE_FIELD, REMAIN(__VA_ARGS__))                            \
                                                                                \
-    name_() : HOB(value_)                                                      \
+    name_()                                                                    \
     {                                                                          \
+        HOB::set_id(ID());                                                     \
+                                                                               \
         SCAN_FIELDS(INIT_FIELD, FIRST(__VA_ARGS__))                            \
         SCAN_FIELDS(INIT_FIELD, REMAIN(__VA_ARGS__))                           \
+    }                                                                          \
+                                                                               \
+    static HOB::UID ID()                                                       \
+    {                                                                          \
+        /* ID is evaluated on mandatory fields only, once per HOB type */      \
+        /* Extra fields only tell whether the HOB has parameters       */      \
+                                                                               \
+        static CONSTEXPR HOB::UID id_ = HOB::Hasher(value_)                    \
+            SCAN_FIELDS(HASH_FIELD, FIRST(__VA_ARGS__))                        \
+            SCAN_FIELDS(HASH_EXTRA, REMAIN(__VA_ARGS__))                       \
+            .id();                                                             \
+                                                                               \
+        return id_;                                                            \
+    }                                                                          \
                                                                                \
-        /* ID is evaluated on mandatory fields only */                         \
-        SCAN_FIELDS(UPDATE_ID, FIRST(__VA_ARGS__))                             \
+    /* ID of the delta frames (see HOB::DeltaWriter) */                        \
                                                                                \
-        /* Extra fields update parameters count */                             \
-        SCAN_FIELDS(UPDATE_NP, REMAIN(__VA_ARGS__))                            \
+    static HOB::UID DELTA_ID()                                                 \
+    {                                                                          \
+        /* Same chain of ID(), which can't be called in a constexpr    */      \
+                                                                               \
+        static CONSTEXPR HOB::UID id_ = HOB::Hasher(HOB::Hasher(value_)        \
+            SCAN_FIELDS(HASH_FIELD, FIRST(__VA_ARGS__))                        \
+            SCAN_FIELDS(HASH_EXTRA, REMAIN(__VA_ARGS__))                       \
+            .id())                                                             \
+            .field("DELTA")                                                    \
+            .id();                                                             \
                                                                                \
-        update_id(static_cast<const char *>(NULL)); /* finalize HOB ID */      \
+        return id_;                                                            \
     }                                                                          \
                                                                                \
     name_(const HOB & ref): HOB(ref)                                           \
@@ -2293,6 +7538,8 @@ public:                                                                        \
     {                                                                          \
         *static_cast<HOB *>(this) = static_cast<const HOB &>(ref);             \
                                                                                \
+        __ ## name_ ## __encoded__.touch(_FIELDS_COUNT_);                      \
+                                                                               \
         return *this;                                                          \
     }                                                                          \
                                                                                \
@@ -2303,9 +7550,98 @@ public:                                                                        \
         SCAN_FIELDS(CLONE_FIELD, FIRST(__VA_ARGS__))                           \
         SCAN_FIELDS(CLONE_FIELD, REMAIN(__VA_ARGS__))                          \
                                                                                \
+        __ ## name_ ## __encoded__.touch(_FIELDS_COUNT_);                      \
+                                                                               \
         return *this;                                                          \
     }                                                                          \
                                                                                \
+    /* Setters: the field value, touched */                                    \
+                                                                               \
+    SCAN_FIELDS(SETTER_FIELD, FIRST(__VA_ARGS__))                              \
+    SCAN_FIELDS(SETTER_FIELD, REMAIN(__VA_ARGS__))                             \
+                                                                               \
+    /* The field (every field, by default) changed in place: marked */         \
+    /* changed, encoded again in the kept frame                     */         \
+                                                                               \
+    void touch(const Fields &f = _FIELDS_COUNT_)                               \
+    {                                                                          \
+        __ ## name_ ## __encoded__.touch(f);                                   \
+                                                                               \
+        for (ssize_t i=0; i<_FIELDS_COUNT_; i++)                               \
+        {                                                                      \
+            if ((i == f) || (_FIELDS_COUNT_ == f))                             \
+            {                                                                  \
+                set_changed(i, true);                                          \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    /* The fields changed, as a bitset */                                      \
+                                                                               \
+    bitset<_FIELDS_COUNT_> changes() const                                     \
+    {                                                                          \
+        bitset<_FIELDS_COUNT_> _hob_c;                                         \
+                                                                               \
+        for (ssize_t i=0; i<_FIELDS_COUNT_; i++)                               \
+        {                                                                      \
+            _hob_c[i] = is_changed(static_cast<Fields>(i));                    \
+        }                                                                      \
+                                                                               \
+        return _hob_c;                                                         \
+    }                                                                          \
+                                                                               \
+    /* Delta frames of the fields in _hob_d (see HOB::DeltaWriter) */          \
+                                                                               \
+    size_t delta_size(uint64_t                      _hob_seq,                  \
+                      const bitset<_FIELDS_COUNT_> &_hob_d) const              \
+    {                                                                          \
+        size_t _hob_sz = delta_payload(_hob_seq, _hob_d);                      \
+                                                                               \
+        return HOB::_l(DELTA_ID()) + HOB::_l(_hob_sz) + _hob_sz;               \
+    }                                                                          \
+                                                                               \
+    template<class S>                                                          \
+    bool write_delta(S                            &os,                         \
+                     uint64_t                      _hob_seq,                   \
+                     const bitset<_FIELDS_COUNT_> &_hob_d) const               \
+    {                                                                          \
+        HOB::Sizes _hob_sizes;                                                 \
+                                                                               \
+        size_t _hob_sz = delta_payload(_hob_seq, _hob_d);                      \
+                                                                               \
+        _hob_sizes.replay();                                                   \
+                                                                               \
+        return (HOB::_w(os, DELTA_ID())                                        \
+                &&                                                             \
+                HOB::_w(os, _hob_sz)                                           \
+                &&                                                             \
+                HOB::_w(os, _hob_seq)                                          \
+                &&                                                             \
+                HOB::_w(os, _hob_d)                                            \
+                SCAN_FIELDS(DELTA_WRITE, FIRST(__VA_ARGS__))                   \
+                SCAN_FIELDS(DELTA_WRITE, REMAIN(__VA_ARGS__)));                \
+    }                                                                          \
+                                                                               \
+    /* The fields in _hob_d, read from the delta frame payload in is_ */       \
+                                                                               \
+    bool read_delta(HOB::MemorySource            &is_,                         \
+                    const bitset<_FIELDS_COUNT_> &_hob_d)                      \
+    {                                                                          \
+        reset_changes();                                                       \
+                                                                               \
+        for (size_t i=0; i<_hob_d.size(); i++)                                 \
+        {                                                                      \
+            if (_hob_d[i])                                                     \
+            {                                                                  \
+                __ ## name_ ## __encoded__.touch(i);                           \
+            }                                                                  \
+        }                                                                      \
+                                                                               \
+        return (true                                                           \
+                SCAN_FIELDS(DELTA_READ, FIRST(__VA_ARGS__))                    \
+                SCAN_FIELDS(DELTA_READ, REMAIN(__VA_ARGS__)));                 \
+    }                                                                          \
+                                                                               \
     bool operator==(const name_ &ref) const                                    \
     {                                                                          \
         bool rv;                                                               \
@@ -2359,40 +7695,61 @@ protected:                                                                     \
     {                                                                          \
         reset_changes();                                                       \
                                                                                \
-        ref.rewind();                                                          \
-                                                                               \
-        if (!_r(static_cast<istream&>(ref)))                                   \
-        {                                                                      \
-            return false;                                                      \
-        }                                                                      \
+        /* The ID already matches, the payload stays with ref */               \
                                                                                \
-        *this = ref;                                                           \
+        HOB::MemorySource is_ = HOB::source(ref);                              \
                                                                                \
-        return true;                                                           \
+        return read_fields(is_);                                               \
     }                                                                          \
                                                                                \
     bool _r(istream &is_)                                                      \
+    {                                                                          \
+        return read_fields(is_);                                               \
+    }                                                                          \
+                                                                               \
+    bool _r(HOB::MemorySource &is_)                                            \
+    {                                                                          \
+        return read_fields(is_);                                               \
+    }                                                                          \
+                                                                               \
+    template<class S>                                                          \
+    bool read_fields(S &is_)                                                   \
     {                                                                          \
         (void)is_;                                                             \
                                                                                \
+        __ ## name_ ## __encoded__.touch(_FIELDS_COUNT_);                      \
+                                                                               \
         /* Read mandatory fields : fail on error */                            \
                                                                                \
         if (true SCAN_FIELDS(READ_FIELD, FIRST(__VA_ARGS__)))                  \
         {                                                                      \
             /* Read optional fields : ignore errors */                         \
                                                                                \
-            if ((true SCAN_FIELDS(READ_FIELD, REMAIN(__VA_ARGS__))) || true)   \
-            {                                                                  \
-                HOB::flush_pending();                                          \
+            (void)(true SCAN_FIELDS(READ_FIELD, REMAIN(__VA_ARGS__)));         \
                                                                                \
-                return true;                                                   \
-            }                                                                  \
+            return true;                                                       \
         }                                                                      \
                                                                                \
         return false;                                                          \
     }                                                                          \
                                                                                \
     bool _w(ostream &os) const                                                 \
+    {                                                                          \
+        return write_fields(os);                                               \
+    }                                                                          \
+                                                                               \
+    bool _w(HOB::MemorySink &os) const                                         \
+    {                                                                          \
+        return write_fields(os);                                               \
+    }                                                                          \
+                                                                               \
+    bool _w(HOB::DigestSink &os) const                                         \
+    {                                                                          \
+        return write_fields(os);                                               \
+    }                                                                          \
+                                                                               \
+    template<class S>                                                          \
+    bool write_fields(S &os) const                                             \
     {                                                                          \
         (void)os;                                                              \
                                                                                \
@@ -2408,22 +7765,72 @@ protected:                                                                     \
                 SCAN_FIELDS(FIELD_SIZE, REMAIN(__VA_ARGS__)));                 \
     }                                                                          \
                                                                                \
-    virtual bool rewind()                                                      \
+    bool encoded(const uint8_t *&_hob_p, size_t &_hob_n) const                 \
     {                                                                          \
-        return HOB::rewind();                                                  \
+        return encode_fields(__ ## name_ ## __encoded__, _hob_p, _hob_n);      \
     }                                                                          \
                                                                                \
-    virtual void set_changed(ssize_t f, bool v)                                \
+    /* Parameters named apart from the fields, that the macros refer to */     \
+                                                                               \
+    template<size_t N>                                                         \
+    bool encode_fields(HOB::Encoded<N, false> &_hob_c,                         \
+                       const uint8_t         *&_hob_p,                         \
+                       size_t                 &_hob_n) const                   \
     {                                                                          \
-        (void)f;                                                               \
-        (void)v;                                                               \
+        (void)_hob_c;                                                          \
+        (void)_hob_p;                                                          \
+        (void)_hob_n;                                                          \
+                                                                               \
+        return false;                                                          \
+    }                                                                          \
+                                                                               \
+    template<size_t N>                                                         \
+    bool encode_fields(HOB::Encoded<N, true> &_hob_c,                          \
+                       const uint8_t        *&_hob_p,                          \
+                       size_t                &_hob_n) const                    \
+    {                                                                          \
+        /* Touched fields of the same length: encoded again in place */        \
+        /* Otherwise the whole frame, copying the untouched fields    */        \
+                                                                               \
+        if (!_hob_c.clean()                                                    \
+            &&                                                                 \
+            !(_hob_c.valid                                                     \
+              SCAN_FIELDS(PATCH_FIELD, FIRST(__VA_ARGS__))                     \
+              SCAN_FIELDS(PATCH_FIELD, REMAIN(__VA_ARGS__))))                  \
+        {                                                                      \
+            HOB::_we(_hob_c);                                                  \
+                                                                               \
+            if (!(true                                                         \
+                  SCAN_FIELDS(ENCODE_FIELD, FIRST(__VA_ARGS__))                \
+                  SCAN_FIELDS(ENCODE_FIELD, REMAIN(__VA_ARGS__))))             \
+            {                                                                  \
+                _hob_c.valid = false;                                          \
                                                                                \
-        if (f < 0)                                                             \
+                return false;                                                  \
+            }                                                                  \
+                                                                               \
+            HOB::_we(_hob_c, get_id());                                        \
+        }                                                                      \
+                                                                               \
+        const typename HOB::Encoded<N, true>::Layout &_hob_e = _hob_c.frame(); \
+                                                                               \
+        _hob_p = &_hob_e.b[_hob_e.begin];                                      \
+        _hob_n = _hob_e.b.size() - _hob_e.begin;                               \
+                                                                               \
+        return true;                                                           \
+    }                                                                          \
+                                                                               \
+    virtual void set_changed(ssize_t _hob_f, bool _hob_v)                      \
+    {                                                                          \
+        (void)_hob_f;                                                          \
+        (void)_hob_v;                                                          \
+                                                                               \
+        if (_hob_f < 0)                                                        \
         {                                                                      \
             return;                                                            \
         }                                                                      \
                                                                                \
-        IF(HAS_ARGS(__VA_ARGS__))(SET_CHANGED(name_,f,v))                      \
+        IF(HAS_ARGS(__VA_ARGS__))(SET_CHANGED(name_,_hob_f,_hob_v))            \
     }                                                                          \
                                                                                \
     virtual void _s(ostream &o, int indent) const                              \
@@ -2433,12 +7840,25 @@ protected:                                                                     \
         ASCII_DUMP(name_,value_,__VA_ARGS__)                                   \
     }                                                                          \
                                                                                \
-    virtual void flush_pending()                                               \
+private:                                                                       \
+    size_t delta_payload(uint64_t                      _hob_seq,               \
+                         const bitset<_FIELDS_COUNT_> &_hob_d) const           \
     {                                                                          \
+        (void)_hob_d;                                                          \
+                                                                               \
+        return (HOB::_l(_hob_seq)                                              \
+                +                                                              \
+                HOB::_l(_hob_d)                                                \
+                SCAN_FIELDS(DELTA_SIZE, FIRST(__VA_ARGS__))                    \
+                SCAN_FIELDS(DELTA_SIZE, REMAIN(__VA_ARGS__)));                 \
     }                                                                          \
                                                                                \
-private:                                                                       \
+    typedef HOB::Track<HOB::Tracked<name_>::mode> _hob_track;                  \
+                                                                               \
     CHANGED_FIELDS(name_, __VA_ARGS__)                                         \
+                                                                               \
+    mutable HOB::Encoded<_FIELDS_COUNT_, HOB::Cached<name_>::value>            \
+        __ ## name_ ## __encoded__;                                            \
 };
 
 #endif // __HOB_HPP__
@@ -1,10 +1,22 @@
 #!/bin/bash
 
+checks() {
+    for c in check_varint check_packed check_series check_construct check_serialize check_view check_lazy check_file check_frame check_frame_cxx11 check_decode check_containers check_bits check_limits check_hash check_cache check_delta check_fixed32 check_contiguous check_contiguous_vectors
+    do
+        ./$c || { echo "$c failed"; return 1; }
+    done
+}
+
 on_file() {
     ./test_message_on_file -w out.dat
     ./test_message_on_file -r out.dat
 }
 
+cxx11_on_file() {
+    ./test_message_on_file_cxx11 -w out_cxx11.dat
+    ./test_message_on_file -r out_cxx11.dat
+}
+
 on_iostream() {
     ./test_message_on_iostream
 }
@@ -49,7 +61,25 @@ from_json_file() {
     ./test_message_on_file -i dump.json
 }
 
+contiguous_on_file() {
+    ./test_contiguous_on_file -w out_contiguous.dat
+    ./test_contiguous_on_file -r out_contiguous.dat
+}
+
+contiguous_from_text() {
+    ./test_contiguous_on_file -w /dev/null
+    ./test_contiguous_on_file -w /dev/null -d text | ./test_contiguous_on_file -i -
+}
+
+contiguous_from_json() {
+    ./test_contiguous_on_file -w /dev/null
+    ./test_contiguous_on_file -w /dev/null -d json | ./test_contiguous_on_file -i -
+}
+
+checks                   || exit 1
+
 on_file                  > message_on_file.txt
+cxx11_on_file            > message_cxx11_on_file.txt
 on_iostream              > message_on_iostream.txt
 on_separate_stringstream > message_on_separate_stringstream.txt
 from_cat                 > message_from_cat.txt
@@ -60,4 +90,10 @@ from_json                > message_from_json.txt
 from_text_file           > message_from_text_file.txt
 from_json_file           > message_from_json_file.txt
 
-md5sum message_*
\ No newline at end of file
+md5sum message_*
+
+contiguous_on_file       > contiguous_on_file.txt
+contiguous_from_text     > contiguous_from_text.txt
+contiguous_from_json     > contiguous_from_json.txt
+
+md5sum contiguous_*
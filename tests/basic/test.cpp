@@ -534,6 +534,8 @@ int main(int argc, char *argv[])
         {
             NumericMessage m;
 
+            size_t i;
+
             m.bytes.push_back(0);
             m.bytes.push_back(1);
             m.bytes.push_back(-125);
@@ -573,6 +575,42 @@ int main(int argc, char *argv[])
 
             m.opt_struct = s;
 
+            for (i=0; i<130; i++)
+            {
+                m.ids.push_back(1000 + 7 * i);
+            }
+
+            for (i=0; i<20; i++)
+            {
+                m.counters.push_back(static_cast<int16_t>(i / 3) - 3);
+            }
+
+            for (i=0; i<40; i++)
+            {
+                m.states.push_back((i < 30) ? 1 : 2);
+            }
+
+            for (i=0; i<24; i++)
+            {
+                m.samples.push_back(20.0 + static_cast<double>(i % 5) * 0.25);
+            }
+
+            for (i=0; i<8; i++)
+            {
+                m.readings.push_back((i < 4) ? 1.5f : -3.75f);
+            }
+
+            m.stamp  = 0x0123456789abcdefllu;
+            m.offset = -123456;
+            m.shift  = 0xfffffffe;
+            m.ratio  = 0.75;
+
+            for (i=0; i<10; i++)
+            {
+                m.history.push_back(500 + static_cast<uint32_t>(i) * 2);
+                m.trace.push_back(1.0 + static_cast<double>(i) / 8.0);
+            }
+
             m >> ofs;
 
             LOG(m);
@@ -0,0 +1,53 @@
+#if !defined(__BENCH_H__)
+#define __BENCH_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <inttypes.h>
+#include "hob.hpp"
+
+// Monotonic enough wall clock, in nanoseconds
+//
+static inline double bench_now()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return static_cast<double>(tv.tv_sec) * 1e9
+           +
+           static_cast<double>(tv.tv_usec) * 1e3;
+}
+
+// Deterministic pseudo random numbers (xorshift64*), so that every run
+// measures the same data
+//
+static inline uint64_t bench_random()
+{
+    static uint64_t s = 0x9e3779b97f4a7c15llu;
+
+    s ^= s >> 12;
+    s ^= s << 25;
+    s ^= s >> 27;
+
+    return s * 2685821657736338717llu;
+}
+
+#define BENCH_REPORT(what_, elapsed_, count_)                                  \
+        printf("%-40s: %10.2f ns/op\n",                                        \
+               what_,                                                          \
+               (elapsed_) / static_cast<double>(count_))
+
+// Guards that the timed calls succeed, so that a failure is not timed as
+// a result. Correctness is checked by the programs under tests/checks.
+//
+#define BENCH_CHECK(cond_)                                                     \
+        if (!(cond_))                                                          \
+        {                                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                       \
+                    __FILE__, __LINE__, #cond_);                               \
+            exit(1);                                                           \
+        }
+
+#endif // __BENCH_H__
@@ -0,0 +1,145 @@
+/******************************************************************************
+//
+// Bit containers micro benchmark
+//
+// Encodes and decodes a 256 bits bitset<> and a 1M bits vector<bool>, from
+// and to memory, against a reference packing the bits one at a time into a
+// byte buffer as the bits codec used to. The wire bytes and the round trips
+// are checked by tests/checks/bits.cpp.
+//
+// Usage:
+//
+//    ./bench_bits [count]
+//
+******************************************************************************/
+#include "bench.h"
+
+typedef bitset<256> Flags;
+
+HOBSTRUCT(Mask, "MASK",
+    (Flags, flags)
+)
+
+HOBSTRUCT(Bitmap, "BITMAP",
+    (vector<bool>, bits)
+)
+
+// The bits one at a time, LSB first
+//
+template<class C>
+static void pack(const C &v, size_t n, vector<uint8_t> &b)
+{
+    b.assign((n + 7) >> 3, 0);
+
+    for (size_t j=0; j<n; j++)
+    {
+        b[j>>3] |= (v[j] << (j&7));
+    }
+}
+
+template<class C>
+static void unpack(const vector<uint8_t> &b, size_t n, C &v)
+{
+    for (size_t j=0; j<n; j++)
+    {
+        v[j] = ((b[j>>3] >> (j&7)) & 1);
+    }
+}
+
+template<class T, class C>
+static void run(const char *what, T &t, C &v, size_t n, size_t count)
+{
+    for (size_t j=0; j<n; j++)
+    {
+        v[j] = (bench_random() & 1);
+    }
+
+    vector<uint8_t> f;
+    vector<uint8_t> b;
+    double          e;
+    char            m[64];
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        pack(v, n, b);
+    }
+
+    e = bench_now() - e;
+
+    snprintf(m, sizeof(m), "%s, a bit at a time pack", what);
+
+    BENCH_REPORT(m, e, count);
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        f.clear();
+
+        BENCH_CHECK(t.serialize_to(f) > 0);
+    }
+
+    e = bench_now() - e;
+
+    snprintf(m, sizeof(m), "%s, serialize_to()", what);
+
+    BENCH_REPORT(m, e, count);
+
+    T d;
+    C u(v);
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        unpack(b, n, u);
+    }
+
+    e = bench_now() - e;
+
+    snprintf(m, sizeof(m), "%s, a bit at a time unpack", what);
+
+    BENCH_REPORT(m, e, count);
+
+    // Keeps the unpacked bits alive
+
+    BENCH_CHECK(u == v);
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        BENCH_CHECK(d << HOB::View(&f[0], f.size()));
+    }
+
+    e = bench_now() - e;
+
+    snprintf(m, sizeof(m), "%s, HOB::View", what);
+
+    BENCH_REPORT(m, e, count);
+
+    printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100;
+
+    {
+        Mask s;
+
+        run("bitset<256>", s, s.flags, s.flags.size(), count * 10000);
+    }
+
+    {
+        Bitmap s;
+
+        s.bits.resize(1 << 20);
+
+        run("vector<bool>(1M)", s, s.bits, s.bits.size(), count);
+    }
+
+    return 0;
+}
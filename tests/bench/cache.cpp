@@ -0,0 +1,170 @@
+/******************************************************************************
+//
+// Kept encoded frames micro benchmark
+//
+// Sends the same configuration HOB over and over to an ostream, encoding it
+// each time, then from the frame kept by CACHE_ENCODING, untouched and with
+// one field set per send, directly and within an enclosing HOB. The frames
+// sent are checked against the ones encoded from scratch by
+// tests/checks/cache.cpp.
+//
+// Usage:
+//
+//    ./bench_cache [count]
+//
+******************************************************************************/
+#include <sstream>
+#include "bench.h"
+
+typedef map<uint8_t, string> Labels;
+
+#define CONFIG_FIELDS                                                          \
+    (string          , name    )                                               \
+    (string          , host    )                                               \
+    (uint32_t        , port    )                                               \
+    (uint32_t        , timeout )                                               \
+    (uint32_t        , retries )                                               \
+    (bool            , enabled )                                               \
+    (double          , rate    )                                               \
+    (double          , ratio   )                                               \
+    (vector<string>  , peers   )                                               \
+    (vector<uint32_t>, ids     )                                               \
+    (vector<double>  , weights )                                               \
+    (Labels          , labels  )                                               \
+    (string          , owner   )                                               \
+    (string          , region  )                                               \
+    (uint64_t        , version )                                               \
+    (uint64_t        , created )                                               \
+    (int32_t         , offset  )                                               \
+    (uint8_t         , level   )                                               \
+    (string          , comment )                                               \
+    (uint64_t        , stamp   )
+
+HOBSTRUCT(Config, "CONFIG", CONFIG_FIELDS)
+
+CACHE_ENCODING(CachedConfig)
+
+HOBSTRUCT(CachedConfig, "CONFIG", CONFIG_FIELDS)
+
+CACHE_ENCODING(Deployment)
+
+HOBSTRUCT(Deployment, "DEPLOYMENT",
+    (CachedConfig, config)
+    (string      , site  )
+    (uint64_t    , stamp )
+)
+
+template<class C>
+static void fill(C &c)
+{
+    c.name    = "a service name well past the short string size";
+    c.host    = "a host name well past the short string size";
+    c.owner   = "an owner name well past the short string size";
+    c.region  = "a region name well past the short string size";
+    c.comment = "a comment well past the short string size";
+    c.port    = 8080;
+    c.timeout = 30000;
+    c.retries = 5;
+    c.enabled = true;
+    c.rate    = 0.25;
+    c.ratio   = 0.75;
+    c.version = 42;
+    c.created = 1234567890;
+    c.offset  = -7;
+    c.level   = 3;
+    c.stamp   = 0;
+
+    c.peers.assign(8, string("a peer name well past the short string size"));
+    c.ids.resize(64);
+    c.weights.resize(32);
+
+    for (size_t i=0; i<c.ids.size(); i++)
+    {
+        c.ids[i] = static_cast<uint32_t>(i * 977);
+    }
+
+    for (size_t i=0; i<c.weights.size(); i++)
+    {
+        c.weights[i] = static_cast<double>(i) * 0.5;
+    }
+
+    for (uint8_t i=0; i<8; i++)
+    {
+        c.labels[i] = "a label well past the short string size";
+    }
+
+    c.touch();
+}
+
+// Sends h count times, calling f before each send
+//
+template<class H, class F>
+static void run(const char *what, H &h, F f, size_t count)
+{
+    stringstream ss;
+    double       e;
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        f(h, i);
+
+        ss.seekp(0);
+
+        BENCH_CHECK(h >> ss);
+    }
+
+    e = bench_now() - e;
+
+    BENCH_REPORT(what, e, count);
+}
+
+template<class H>
+static void as_is(H &h, size_t i)
+{
+    (void)h;
+    (void)i;
+}
+
+template<class H>
+static void set_stamp(H &h, size_t i)
+{
+    h.set_stamp(i);
+}
+
+static void set_config_stamp(Deployment &d, size_t i)
+{
+    d.config.set_stamp(i);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    Config       c;
+    CachedConfig k;
+
+    fill(c);
+    fill(k);
+
+    printf("Config, %zu bytes frame\n\n", static_cast<size_t>(c));
+
+    run("encoded each time"                , c, as_is<Config>           , count);
+    run("kept, untouched"                  , k, as_is<CachedConfig>     , count);
+    run("kept, 1 field set"                , k, set_stamp<CachedConfig> , count);
+
+    // Within an enclosing HOB, kept too
+
+    Deployment d;
+
+    d.config = k;
+    d.site   = "a site name well past the short string size";
+
+    printf("\nDeployment, %zu bytes frame\n\n", static_cast<size_t>(d));
+
+    run("kept, untouched"                  , d, as_is<Deployment>       , count);
+    run("kept, nested field set"           , d, set_config_stamp        , count);
+
+    return 0;
+}
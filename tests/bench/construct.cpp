@@ -0,0 +1,150 @@
+/******************************************************************************
+//
+// HOB construction micro benchmark
+//
+// Compares the construction of a HOBSTRUCT, whose ID is evaluated once per
+// type, against a reference HOB hashing its schema in every constructor,
+// reports the HOB objects footprint and times the construction and the
+// decoding of vectors of HOBSTRUCTs. The IDs are checked by
+// tests/checks/construct.cpp.
+//
+// Usage:
+//
+//    ./bench_construct [count]
+//
+******************************************************************************/
+#include <sstream>
+#include <vector>
+#include "bench.h"
+
+HOBSTRUCT(MyStruct, "MY_STRUCT",
+    (uint32_t, anEnum  , 1    )
+    (uint8_t , aChar   , 4    )
+    (float   , aFloat  , 3.14f),
+    (bool    , optional, true )
+)
+
+//
+// Reference implementation: the HOB ID is hashed on every construction
+//
+class RefStruct: public HOB
+{
+public:
+    RefStruct() : HOB("MY_STRUCT"), anEnum(1), aChar(4), aFloat(3.14f), optional(true)
+    {
+        update_id("name_"); update_id("uint32_t"); update_id("anEnum");
+        update_id("name_"); update_id("uint8_t" ); update_id("aChar" );
+        update_id("name_"); update_id("float"   ); update_id("aFloat");
+        update_id("");
+
+        update_id(static_cast<const char *>(NULL));
+    }
+
+    uint32_t anEnum;
+    uint8_t  aChar;
+    float    aFloat;
+    bool     optional;
+};
+
+// HOB ID accessor
+//
+template<class T>
+class Probe: public T
+{
+public:
+    const HOB::UID &id() const { return this->get_id(); }
+};
+
+class Codec: public HOB
+{
+public:
+    template<class T>
+    static bool write(ostream &os, const T &v)
+    {
+        return HOB::_w(os, v);
+    }
+
+    template<class T>
+    bool read(istream &is, T &v)
+    {
+        return HOB::_r(is, v);
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    printf("\nfootprint\n\n");
+
+    printf("  %-38s: %10zu bytes\n", "sizeof(HOB)"     , sizeof(HOB)     );
+    printf("  %-38s: %10zu bytes\n", "sizeof(MyStruct)", sizeof(MyStruct));
+
+    printf("\nconstruction\n\n");
+
+    double   t;
+    uint64_t sum;
+
+    t   = bench_now();
+    sum = 0;
+
+    for (size_t i=0; i<count; i++)
+    {
+        Probe<RefStruct> r;
+
+        sum += r.id();
+    }
+
+    BENCH_REPORT("  reference, hashing the schema", bench_now() - t, count);
+
+    BENCH_CHECK(sum == count * Probe<RefStruct>().id());
+
+    t   = bench_now();
+    sum = 0;
+
+    for (size_t i=0; i<count; i++)
+    {
+        Probe<MyStruct> m;
+
+        sum += m.id();
+    }
+
+    BENCH_REPORT("  HOBSTRUCT, ID once per type", bench_now() - t, count);
+
+    BENCH_CHECK(sum == count * MyStruct::ID());
+
+    size_t items = (count < 10000) ? count : 10000;
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i+=items)
+    {
+        vector<MyStruct> v(items);
+
+        BENCH_CHECK(v.size() == items);
+    }
+
+    BENCH_REPORT("  vector<MyStruct>, per item", bench_now() - t, count);
+
+    vector<MyStruct> values(items);
+    vector<MyStruct> decoded;
+    stringstream     ss;
+    Codec            codec;
+
+    for (size_t i=0; i<items; i++)
+    {
+        values[i].anEnum = static_cast<uint32_t>(bench_random());
+    }
+
+    BENCH_CHECK(Codec::write(ss, values));
+
+    printf("\nvector<MyStruct> decoding, %zu items\n\n", items);
+
+    t = bench_now();
+
+    BENCH_CHECK(codec.read(ss, decoded));
+
+    BENCH_REPORT("  vector<MyStruct> read", bench_now() - t, items);
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+/******************************************************************************
+//
+// Associative containers micro benchmark
+//
+// Decodes maps of many pairs as map<>, flat_map<> and unordered_map<>, both
+// into empty objects (every pair inserted) and into long lived ones (every
+// pair read in place). The round trips are checked by
+// tests/checks/containers.cpp.
+//
+// Usage:
+//
+//    ./bench_containers [count] [pairs]
+//
+******************************************************************************/
+#include "bench.h"
+
+typedef map<uint32_t, uint64_t>           Ordered;
+typedef HOB::flat_map<uint32_t, uint64_t> Flat;
+typedef unordered_map<uint32_t, uint64_t> Hashed;
+
+HOBSTRUCT(OrderedIndex, "INDEX",
+    (Ordered, pairs)
+)
+
+HOBSTRUCT(FlatIndex, "INDEX",
+    (Flat, pairs)
+)
+
+HOBSTRUCT(HashedIndex, "INDEX",
+    (Hashed, pairs)
+)
+
+// Encodes the pairs of a T, decodes them count times in a fresh and in a
+// long lived T
+//
+template<class T>
+static void run(const char *what, size_t count, size_t pairs)
+{
+    T t;
+
+    for (size_t i=0; i<pairs; i++)
+    {
+        t.pairs[static_cast<uint32_t>(i * 7)] = bench_random();
+    }
+
+    vector<uint8_t> f;
+
+    BENCH_CHECK(t.serialize_to(f) > 0);
+
+    T      d;
+    double e;
+    char   m[64];
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        T n;
+
+        BENCH_CHECK(n << HOB::View(&f[0], f.size()));
+    }
+
+    e = bench_now() - e;
+
+    snprintf(m, sizeof(m), "%s, into an empty one", what);
+
+    BENCH_REPORT(m, e / static_cast<double>(pairs), count);
+
+    BENCH_CHECK(d << HOB::View(&f[0], f.size()));
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        BENCH_CHECK(d << HOB::View(&f[0], f.size()));
+    }
+
+    e = bench_now() - e;
+
+    snprintf(m, sizeof(m), "%s, in place", what);
+
+    BENCH_REPORT(m, e / static_cast<double>(pairs), count);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 2000;
+    size_t pairs = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1000;
+
+    printf("%zu pairs maps, per pair\n\n", pairs);
+
+    run<OrderedIndex>("map<>"          , count, pairs);
+    run<FlatIndex   >("flat_map<>"     , count, pairs);
+    run<HashedIndex >("unordered_map<>", count, pairs);
+
+    return 0;
+}
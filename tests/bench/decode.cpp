@@ -0,0 +1,260 @@
+/******************************************************************************
+//
+// Steady state decoding micro benchmark
+//
+// Decodes the same kind of HOB over and over into one long lived object, from
+// memory (HOB::View) and from an istream (read_from()), counting the heap
+// allocations done per decode, in each change tracking mode. The decoded
+// values and the changes detected are checked by tests/checks/decode.cpp.
+//
+// Usage:
+//
+//    ./bench_decode [count]
+//
+******************************************************************************/
+#include <new>
+#include <sstream>
+#include "bench.h"
+
+static size_t allocations = 0;
+
+// Heap allocations counter
+
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(size_t sz) throw(std::bad_alloc)
+{
+    allocations++;
+
+    void *p = malloc((sz > 0) ? sz : 1);
+
+    if (NULL == p)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void *p) throw()
+{
+    free(p);
+}
+
+HOBSTRUCT(Leaf, "LEAF",
+    (uint32_t, id   , 0   )
+    (float   , value, 0.0f)
+)
+
+HOBSTRUCT(Branch, "BRANCH",
+    (Leaf          , first )
+    (optional<Leaf>, spare )
+    (vector<Leaf>  , leaves)
+)
+
+HOBSTRUCT(Tree, "TREE",
+    (Branch  , branch)
+    (uint64_t, stamp )
+)
+
+typedef map<uint8_t, string> Labels;
+
+#define RECORD_FIELDS                                                          \
+    (string          , name   )                                                \
+    (vector<string>  , tags   )                                                \
+    (vector<uint32_t>, ids    )                                                \
+    (vector<double>  , values )                                                \
+    (vector<int8_t>  , bytes  )                                                \
+    (Labels          , labels )                                                \
+    (optional<string>, comment)                                                \
+    (uint64_t        , stamp  )
+
+HOBSTRUCT(Record, "RECORD", RECORD_FIELDS)
+
+// The same fields, tracked the other ways
+
+TRACK_CHANGES(ReadRecord, TRACK_READS)
+
+HOBSTRUCT(ReadRecord, "RECORD", RECORD_FIELDS)
+
+TRACK_CHANGES(UntrackedRecord, TRACK_NONE)
+
+HOBSTRUCT(UntrackedRecord, "RECORD", RECORD_FIELDS)
+
+// Large containers
+
+typedef map<uint32_t, double> Points;
+
+#define SERIES_FIELDS                                                          \
+    (vector<double>, samples)                                                  \
+    (Points        , points )
+
+HOBSTRUCT(Series, "SERIES", SERIES_FIELDS)
+
+TRACK_CHANGES(ReadSeries, TRACK_READS)
+
+HOBSTRUCT(ReadSeries, "SERIES", SERIES_FIELDS)
+
+TRACK_CHANGES(UntrackedSeries, TRACK_NONE)
+
+HOBSTRUCT(UntrackedSeries, "SERIES", SERIES_FIELDS)
+
+template<class R>
+static void fill_series(R &r, size_t k)
+{
+    r.samples.resize(16384);
+
+    for (size_t i=0; i<r.samples.size(); i++)
+    {
+        r.samples[i] = static_cast<double>(i) * 0.25;
+    }
+
+    r.samples.back() += static_cast<double>(k);
+
+    r.points.clear();
+
+    for (uint32_t i=0; i<1024; i++)
+    {
+        r.points[i * 7] = static_cast<double>(i) * 0.5;
+    }
+
+    r.points[7 * 1023] += static_cast<double>(k);
+}
+
+static void fill(Series          &r, size_t k) { fill_series(r, k); }
+static void fill(ReadSeries      &r, size_t k) { fill_series(r, k); }
+static void fill(UntrackedSeries &r, size_t k) { fill_series(r, k); }
+
+static void fill(Tree &t, size_t k)
+{
+    t.stamp              = k;
+    t.branch.first.id    = static_cast<uint32_t>(k);
+    t.branch.first.value = 0.5f;
+    t.branch.spare       = Leaf();
+    t.branch.leaves.resize(16);
+
+    for (size_t i=0; i<t.branch.leaves.size(); i++)
+    {
+        t.branch.leaves[i].id    = static_cast<uint32_t>(k + i);
+        t.branch.leaves[i].value = static_cast<float>(i) * 0.25f;
+    }
+}
+
+template<class R>
+static void fill(R &r, size_t k)
+{
+    r.name    = (0 == k) ? "a name well past the short string size"
+                         : "another name past the short string size";
+    r.comment = string("a comment well past the short string size");
+    r.stamp   = k;
+
+    r.tags.assign(8, string("a tag well past the short string size"));
+    r.tags[k] = "just another tag past the short string size";
+
+    r.labels.clear();
+
+    r.ids.resize(300);
+    r.values.resize(64);
+    r.bytes.assign(48, static_cast<int8_t>(k));
+
+    for (size_t i=0; i<r.ids.size(); i++)
+    {
+        r.ids[i] = static_cast<uint32_t>((i * 977) + k);
+    }
+
+    for (size_t i=0; i<r.values.size(); i++)
+    {
+        r.values[i] = static_cast<double>(i + k) * 0.5;
+    }
+
+    for (uint8_t i=0; i<16; i++)
+    {
+        r.labels[i * 3] = (0 == k) ? "a label well past the short string size"
+                                   : "another label past the short string size";
+    }
+}
+
+// Decodes two alternating frames over and over into the same object
+//
+template<class T>
+static void run(const char *what, size_t count)
+{
+    T                        t;
+    vector<vector<uint8_t> > frames(2);
+
+    for (size_t i=0; i<frames.size(); i++)
+    {
+        fill(t, i);
+
+        BENCH_CHECK(t.serialize_to(frames[i]) > 0);
+    }
+
+    T      d;
+    double e;
+    size_t a;
+
+    printf("%s, %zu bytes frame\n\n", what, frames[0].size());
+
+    // Warm up: the first decodes size the fields
+
+    for (size_t i=0; i<frames.size(); i++)
+    {
+        BENCH_CHECK(d << HOB::View(&frames[i][0], frames[i].size()));
+    }
+
+    a = allocations;
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        const vector<uint8_t> &f = frames[i & 1];
+
+        BENCH_CHECK(d << HOB::View(&f[0], f.size()));
+    }
+
+    e = bench_now() - e;
+
+    BENCH_REPORT("  HOB::View", e, count);
+
+    printf("%-40s: %10.2f\n", "  allocations per decode",
+           static_cast<double>(allocations - a) / static_cast<double>(count));
+
+    stringstream ss;
+
+    for (size_t i=0; i<count; i++)
+    {
+        const vector<uint8_t> &f = frames[i & 1];
+
+        ss.write(reinterpret_cast<const char *>(&f[0]), f.size());
+    }
+
+    a = allocations;
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        BENCH_CHECK(d.read_from(ss) > 0);
+    }
+
+    e = bench_now() - e;
+
+    BENCH_REPORT("  istream, read_from()", e, count);
+
+    printf("%-40s: %10.2f\n\n", "  allocations per decode",
+           static_cast<double>(allocations - a) / static_cast<double>(count));
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    run<Tree           >("Tree"                , count);
+    run<Record         >("Record, TRACK_VALUES", count);
+    run<ReadRecord     >("Record, TRACK_READS" , count);
+    run<UntrackedRecord>("Record, TRACK_NONE"  , count);
+    run<Series         >("Series, TRACK_VALUES", count / 100);
+    run<ReadSeries     >("Series, TRACK_READS" , count / 100);
+    run<UntrackedSeries>("Series, TRACK_NONE"  , count / 100);
+
+    return 0;
+}
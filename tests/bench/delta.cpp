@@ -0,0 +1,159 @@
+/******************************************************************************
+//
+// Delta frames micro benchmark
+//
+// Replicates a 20 fields state, two of them set per tick, sending it whole
+// each tick, then as delta frames of the fields changed (a snapshot every
+// 100 frames), encoded only and applied to a replica. The replica, lost
+// frames and resync are checked by tests/checks/delta.cpp.
+//
+// Usage:
+//
+//    ./bench_delta [count]
+//
+******************************************************************************/
+#include "bench.h"
+
+typedef map<uint8_t, string> Labels;
+
+HOBSTRUCT(State, "STATE",
+    (string          , name    )
+    (string          , owner   )
+    (uint32_t        , id      )
+    (uint32_t        , kind    )
+    (double          , x       )
+    (double          , y       )
+    (double          , z       )
+    (double          , heading )
+    (double          , speed   )
+    (float           , battery )
+    (bool            , armed   )
+    (uint8_t         , mode    )
+    (vector<uint32_t>, route   )
+    (vector<double>  , limits  )
+    (Labels          , labels  )
+    (string          , comment )
+    (uint64_t        , created )
+    (int32_t         , offset  )
+    (uint32_t        , errors  )
+    (uint64_t        , stamp   )
+)
+
+static void fill(State &s)
+{
+    s.name    = "a vehicle name well past the short string size";
+    s.owner   = "an owner name well past the short string size";
+    s.comment = "a comment well past the short string size";
+    s.id      = 7;
+    s.kind    = 3;
+    s.z       = 120.0;
+    s.heading = 90.0;
+    s.speed   = 12.5;
+    s.battery = 0.8f;
+    s.armed   = true;
+    s.mode    = 2;
+    s.created = 1234567890;
+    s.offset  = -7;
+
+    s.route.resize(32);
+    s.limits.assign(16, 100.0);
+
+    for (size_t i=0; i<s.route.size(); i++)
+    {
+        s.route[i] = static_cast<uint32_t>(i * 977);
+    }
+
+    for (uint8_t i=0; i<8; i++)
+    {
+        s.labels[i] = "a label well past the short string size";
+    }
+}
+
+// One tick: the position moves
+//
+static void tick(State &s, size_t i)
+{
+    s.set_x(static_cast<double>(i) * 0.5);
+    s.set_stamp(i);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    State           s;
+    vector<uint8_t> f;
+    double          e;
+    size_t          bytes;
+
+    fill(s);
+
+    // Whole state each tick
+
+    bytes = 0;
+    e     = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        tick(s, i);
+
+        f.clear();
+
+        bytes += s.serialize_to(f);
+    }
+
+    e = bench_now() - e;
+
+    BENCH_REPORT("whole frames, encode", e, count);
+
+    printf("%-40s: %10.2f\n", "  bytes per tick",
+           static_cast<double>(bytes) / static_cast<double>(count));
+
+    // Delta frames, a snapshot every 100
+
+    HOB::DeltaWriter w(100);
+
+    bytes = 0;
+    e     = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        tick(s, i);
+
+        f.clear();
+
+        bytes += w.write(s, f);
+    }
+
+    e = bench_now() - e;
+
+    BENCH_REPORT("delta frames, encode", e, count);
+
+    printf("%-40s: %10.2f\n", "  bytes per tick",
+           static_cast<double>(bytes) / static_cast<double>(count));
+
+    // The replica follows
+
+    HOB::DeltaReader r;
+    State            d;
+
+    w.resync();
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        tick(s, i);
+
+        f.clear();
+
+        BENCH_CHECK(w.write(s, f) > 0);
+        BENCH_CHECK(r.read(d, HOB::View(&f[0], f.size())));
+    }
+
+    e = bench_now() - e;
+
+    BENCH_REPORT("delta frames, encode and apply", e, count);
+
+    return 0;
+}
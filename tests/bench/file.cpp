@@ -0,0 +1,121 @@
+/******************************************************************************
+//
+// Log file reading micro benchmark
+//
+// Writes a log of HOBs to a file, then reads it back through an ifstream the
+// usual way (generic HOB first, then the typed one) and in a single pass
+// (HOB::read_one_of(), read_from()). The decoded values are checked by
+// tests/checks/file.cpp.
+//
+// Usage:
+//
+//    ./bench_file [count] [path]
+//
+******************************************************************************/
+#include <stdio.h>
+#include <fstream>
+#include "bench.h"
+
+HOBSTRUCT(Sample, "SAMPLE",
+    (uint64_t, stamp  )
+    (uint32_t, channel)
+    (double  , value  )
+    (string  , unit   )
+)
+
+HOBSTRUCT(Event, "EVENT",
+    (uint64_t, stamp)
+    (string  , text )
+)
+
+int main(int argc, char *argv[])
+{
+    size_t      count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+    const char *path  = (argc > 2) ? argv[2] : "bench_file.dat";
+
+    Sample s;
+    Event  e;
+    double t;
+
+    s.unit = "degC";
+    e.text = "threshold crossed";
+
+    {
+        ofstream os(path, ios::binary);
+
+        t = bench_now();
+
+        for (size_t i=0; i<count; i++)
+        {
+            s.stamp   = i;
+            s.channel = static_cast<uint32_t>(i % 16);
+            s.value   = static_cast<double>(i % 1000) * 0.125;
+
+            BENCH_CHECK(s >> os);
+
+            if (0 == (i % 10))
+            {
+                e.stamp = i;
+
+                BENCH_CHECK(e >> os);
+            }
+        }
+
+        BENCH_REPORT("ofstream, write", bench_now() - t, count);
+    }
+
+    {
+        ifstream is(path, ios::binary);
+        HOB      h;
+
+        t = bench_now();
+
+        while (h << is)
+        {
+            if (!(s << h))
+            {
+                BENCH_CHECK(e << h);
+            }
+        }
+
+        BENCH_REPORT("ifstream, generic then typed HOB", bench_now() - t, count);
+    }
+
+    {
+        ifstream is(path, ios::binary);
+        HOB     *hobs[] = { &s, &e };
+        ssize_t  i;
+
+        t = bench_now();
+
+        while ((i = HOB::read_one_of(is, hobs)) >= 0)
+        {
+            BENCH_CHECK(i < 2);
+        }
+
+        BENCH_REPORT("ifstream, HOB::read_one_of()", bench_now() - t, count);
+    }
+
+    {
+        ifstream is(path, ios::binary);
+        size_t   n = 0;
+        int      r;
+
+        t = bench_now();
+
+        // Events are skipped
+
+        while ((r = s.read_from(is)) >= 0)
+        {
+            n += static_cast<size_t>(r);
+        }
+
+        BENCH_CHECK(n == count);
+
+        BENCH_REPORT("ifstream, read_from()", bench_now() - t, count);
+    }
+
+    remove(path);
+
+    return 0;
+}
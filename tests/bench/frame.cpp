@@ -0,0 +1,236 @@
+/******************************************************************************
+//
+// HOB::Frame micro benchmark
+//
+// Reads a stream of HOBs into owned frames on the main thread, queues them
+// and decodes them on worker threads. The decoded values and the frames
+// semantics are checked by tests/checks/frame.cpp.
+//
+// Also compares the copy of a generic HOB (deep copy of the payload) against
+// the copy of a frame (reference count update only).
+//
+// Usage:
+//
+//    ./bench_frame [count] [workers]
+//
+******************************************************************************/
+#include <pthread.h>
+#include <sstream>
+#include <vector>
+#include "bench.h"
+
+HOBSTRUCT(Sample, "SAMPLE",
+    (uint64_t        , stamp  )
+    (uint32_t        , channel)
+    (vector<double>  , values )
+    (string          , unit   )
+)
+
+// Frames are handed to the workers in chunks, through a mutex protected queue
+//
+class Queue
+{
+public:
+    Queue()
+        : _closed(false)
+    {
+        pthread_mutex_init(&_m, NULL);
+        pthread_cond_init (&_c, NULL);
+    }
+
+    ~Queue()
+    {
+        pthread_cond_destroy (&_c);
+        pthread_mutex_destroy(&_m);
+    }
+
+    void push(const vector<HOB::Frame> &chunk)
+    {
+        pthread_mutex_lock(&_m);
+
+        _q.push_back(chunk);
+
+        pthread_cond_signal(&_c);
+        pthread_mutex_unlock(&_m);
+    }
+
+    void close()
+    {
+        pthread_mutex_lock(&_m);
+
+        _closed = true;
+
+        pthread_cond_broadcast(&_c);
+        pthread_mutex_unlock(&_m);
+    }
+
+    bool pop(vector<HOB::Frame> &chunk)
+    {
+        pthread_mutex_lock(&_m);
+
+        while (_q.empty() && !_closed)
+        {
+            pthread_cond_wait(&_c, &_m);
+        }
+
+        bool rv = !_q.empty();
+
+        if (rv)
+        {
+            chunk.swap(_q.back());
+
+            _q.pop_back();
+        }
+
+        pthread_mutex_unlock(&_m);
+
+        return rv;
+    }
+
+private:
+    pthread_mutex_t             _m;
+    pthread_cond_t              _c;
+    vector<vector<HOB::Frame> > _q;
+    bool                        _closed;
+};
+
+struct Worker
+{
+    Queue    *queue;
+    size_t    decoded;
+    bool      ok;
+};
+
+static void *work(void *arg)
+{
+    Worker            &w = *static_cast<Worker *>(arg);
+    Sample             s;
+    vector<HOB::Frame> chunk;
+
+    while (w.queue->pop(chunk))
+    {
+        for (size_t i=0; i<chunk.size(); i++)
+        {
+            w.ok = (s << chunk[i]) && w.ok;
+
+            w.decoded++;
+        }
+
+        chunk.clear();
+    }
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count   = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t workers = (argc > 2) ? strtoul(argv[2], NULL, 10) : 4;
+
+    stringstream ss;
+    Sample       s;
+    double       t;
+
+    s.unit = "degC";
+
+    for (size_t i=0; i<count; i++)
+    {
+        s.stamp   = i;
+        s.channel = static_cast<uint32_t>(i % 16);
+        s.values.assign(8, static_cast<double>(i % 1000) * 0.5);
+
+        BENCH_CHECK(s >> ss);
+    }
+
+    string wire = ss.str();
+
+    {
+        HOB::Frame f;
+
+        stringstream is(wire);
+
+        BENCH_CHECK(f << is);
+
+        HOB h;
+
+        stringstream ih(wire);
+
+        BENCH_CHECK(h << ih);
+
+        size_t n = (count < 100000) ? count : 100000;
+
+        t = bench_now();
+
+        for (size_t i=0; i<n; i++)
+        {
+            HOB c(h);
+
+            BENCH_CHECK(c == h);
+        }
+
+        BENCH_REPORT("generic HOB copy", bench_now() - t, n);
+
+        t = bench_now();
+
+        for (size_t i=0; i<n; i++)
+        {
+            HOB::Frame c(f);
+
+            BENCH_CHECK(c.payload() == f.payload());
+        }
+
+        BENCH_REPORT("HOB::Frame copy", bench_now() - t, n);
+    }
+
+    {
+        Queue             queue;
+        vector<Worker>    w(workers);
+        vector<pthread_t> th(workers);
+
+        t = bench_now();
+
+        for (size_t i=0; i<workers; i++)
+        {
+            w[i].queue   = &queue;
+            w[i].decoded = 0;
+            w[i].ok      = true;
+
+            BENCH_CHECK(0 == pthread_create(&th[i], NULL, work, &w[i]));
+        }
+
+        stringstream       is(wire);
+        HOB::Frame         f;
+        vector<HOB::Frame> chunk;
+
+        while (f << is)
+        {
+            chunk.push_back(f);
+
+            if (chunk.size() == 256)
+            {
+                queue.push(chunk);
+
+                chunk.clear();
+            }
+        }
+
+        queue.push(chunk);
+        queue.close();
+
+        size_t decoded = 0;
+
+        for (size_t i=0; i<workers; i++)
+        {
+            BENCH_CHECK(0 == pthread_join(th[i], NULL));
+            BENCH_CHECK(w[i].ok);
+
+            decoded += w[i].decoded;
+        }
+
+        BENCH_REPORT("read, queue, decode on workers", bench_now() - t, count);
+
+        BENCH_CHECK(decoded == count);
+    }
+
+    return 0;
+}
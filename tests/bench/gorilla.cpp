@@ -0,0 +1,148 @@
+/******************************************************************************
+//
+// Floating point series micro benchmark
+//
+// Compares the wire size and the speed of the XOR codec (series<T>) against
+// the VARINT encoded (vector<T>) and the raw, fixed width, encodings on
+// realistic sample series. The decoded values are checked by
+// tests/checks/series.cpp.
+//
+// Usage:
+//
+//    ./bench_gorilla [count]
+//
+******************************************************************************/
+#include <math.h>
+#include <string.h>
+#include <sstream>
+#include <vector>
+#include "bench.h"
+
+class Codec: public HOB
+{
+public:
+    template<class T>
+    static bool write(ostream &os, const T &v)
+    {
+        return HOB::_w(os, v);
+    }
+
+    template<class T>
+    bool read(istream &is, T &v)
+    {
+        return HOB::_r(is, v);
+    }
+};
+
+//
+// Series
+//
+static double bench_uniform()
+{
+    return static_cast<double>(bench_random() % 1000000) / 1000000.0;
+}
+
+// Temperature probe: slow daily cycle, 0.01 degrees resolution
+//
+static double temperature(size_t i)
+{
+    double t = 20.0 + 5.0 * sin(static_cast<double>(i) / 1440.0 * 6.2832);
+
+    return floor(t * 100.0 + 0.5) / 100.0;
+}
+
+// Gauge sampled faster than it changes
+//
+static double gauge(size_t i)
+{
+    return static_cast<double>((i / 60) % 100) * 0.5;
+}
+
+// Random walk, full precision
+//
+static double random_walk(size_t i)
+{
+    static double v = 100.0;
+
+    (void)i;
+
+    v += bench_uniform() - 0.5;
+
+    return v;
+}
+
+template<class T>
+static void run(const char *name, double (*gen)(size_t), size_t count)
+{
+    vector<T> values(count);
+
+    for (size_t i=0; i<count; i++)
+    {
+        values[i] = static_cast<T>(gen(i));
+    }
+
+    HOB::series<T> g_values(values);
+
+    stringstream v_ss;
+    stringstream g_ss;
+    Codec        codec;
+
+    printf("\n%s\n\n", name);
+
+    double t;
+
+    t = bench_now();
+
+    vector<char> raw(count * sizeof(T));
+
+    memcpy(&raw[0], &values[0], raw.size());
+
+    BENCH_REPORT("  raw copy", bench_now() - t, count);
+
+    t = bench_now();
+
+    BENCH_CHECK(Codec::write(v_ss, values));
+
+    BENCH_REPORT("  vector<T> write", bench_now() - t, count);
+
+    t = bench_now();
+
+    BENCH_CHECK(Codec::write(g_ss, g_values));
+
+    BENCH_REPORT("  series<T> write", bench_now() - t, count);
+
+    vector<T>      v_decoded;
+    HOB::series<T> g_decoded;
+
+    t = bench_now();
+
+    BENCH_CHECK(codec.read(v_ss, v_decoded));
+
+    BENCH_REPORT("  vector<T> read", bench_now() - t, count);
+
+    t = bench_now();
+
+    BENCH_CHECK(codec.read(g_ss, g_decoded));
+
+    BENCH_REPORT("  series<T> read", bench_now() - t, count);
+
+    printf("  %.3f bytes/value (raw), "
+           "%.3f bytes/value (vector<T>), "
+           "%.3f bytes/value (series<T>)\n",
+           static_cast<double>(sizeof(T)),
+           static_cast<double>(v_ss.str().size()) / static_cast<double>(count),
+           static_cast<double>(g_ss.str().size()) / static_cast<double>(count));
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    run<double>("temperature, double", temperature, count);
+    run<float >("temperature, float" , temperature, count);
+    run<double>("gauge, double"      , gauge      , count);
+    run<double>("random walk, double", random_walk, count);
+    run<float >("random walk, float" , random_walk, count);
+
+    return 0;
+}
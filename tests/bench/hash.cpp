@@ -0,0 +1,173 @@
+/******************************************************************************
+//
+// Content hash micro benchmark
+//
+// Hashes a record of strings, vectors, maps and a nested HOB, against its
+// serialization and its field by field comparison, then dedups a stream of
+// records through an unordered_map keyed by HOB::HashedKey<>. The hashes
+// and the dedup are checked by tests/checks/hash.cpp.
+//
+// Usage:
+//
+//    ./bench_hash [count]
+//
+******************************************************************************/
+#include "bench.h"
+
+typedef map<uint8_t, string>            Labels;
+typedef unordered_map<uint32_t, double> Weights;
+
+HOBSTRUCT(Origin, "ORIGIN",
+    (string  , host)
+    (uint32_t, pid )
+)
+
+HOBSTRUCT(Record, "RECORD",
+    (Origin          , origin )
+    (string          , name   )
+    (vector<string>  , tags   )
+    (vector<uint32_t>, ids    )
+    (vector<double>  , values )
+    (Labels          , labels )
+    (Weights         , weights)
+    (uint64_t        , stamp  )
+)
+
+typedef HOB::HashedKey<Record> Key;
+
+static void fill(Record &r, size_t k)
+{
+    r.origin.host = "a host name well past the short string size";
+    r.origin.pid  = 1234;
+    r.name        = "a name well past the short string size";
+    r.stamp       = k;
+
+    r.tags.assign(8, string("a tag well past the short string size"));
+    r.ids.resize(300);
+    r.values.resize(64);
+
+    for (size_t i=0; i<r.ids.size(); i++)
+    {
+        r.ids[i] = static_cast<uint32_t>(i * 977);
+    }
+
+    for (size_t i=0; i<r.values.size(); i++)
+    {
+        r.values[i] = static_cast<double>(i) * 0.5;
+    }
+
+    for (uint8_t i=0; i<16; i++)
+    {
+        r.labels[i * 3] = "a label well past the short string size";
+    }
+
+    for (uint32_t i=0; i<16; i++)
+    {
+        r.weights[i * 5] = static_cast<double>(i);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    Record a;
+    Record b;
+
+    fill(a, 0);
+    fill(b, 0);
+
+    vector<uint8_t> f;
+
+    BENCH_CHECK(a.serialize_to(f) > 0);
+
+    printf("Record, %zu bytes frame\n\n", f.size());
+
+    double   e;
+    uint64_t x = 0;
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        x += a.content_hash(i);
+    }
+
+    e = bench_now() - e;
+
+    BENCH_REPORT("content_hash()", e, count);
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        f.clear();
+
+        BENCH_CHECK(a.serialize_to(f) > 0);
+    }
+
+    e = bench_now() - e;
+
+    BENCH_REPORT("serialize_to()", e, count);
+
+    // Records different in their last field only
+
+    b.stamp = 1;
+
+    Key ka(a);
+    Key kb(b);
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        BENCH_CHECK(!(a == b));
+    }
+
+    e = bench_now() - e;
+
+    BENCH_REPORT("operator==(), different records", e, count);
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        BENCH_CHECK(!(ka == kb));
+    }
+
+    e = bench_now() - e;
+
+    BENCH_REPORT("HashedKey::operator==(), different", e, count);
+
+    // Dedup of a stream of records, 1 out of 16 new
+
+    unordered_map<Key, size_t, HOB::ContentHash> seen;
+
+    size_t n = count / 10;
+    size_t d = 0;
+
+    e = bench_now();
+
+    for (size_t i=0; i<n; i++)
+    {
+        a.stamp = bench_random() & 0xf;
+
+        if (0 == (i & 0xf))
+        {
+            a.stamp = i;
+        }
+
+        if (1 == ++seen[Key(a)])
+        {
+            d++;
+        }
+    }
+
+    e = bench_now() - e;
+
+    BENCH_REPORT("dedup, HashedKey<> and content_hash()", e, n);
+
+    printf("\n%zu distinct records out of %zu (%" PRIx64 ")\n", d, n, x);
+
+    return 0;
+}
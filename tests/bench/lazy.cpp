@@ -0,0 +1,144 @@
+/******************************************************************************
+//
+// HOBSTRUCT::Lazy micro benchmark
+//
+// Compares the access to a single field of a frame held in memory through
+// the lazy accessors against the full decoding of the frame. The values of
+// the accessors are checked by tests/checks/lazy.cpp.
+//
+// Usage:
+//
+//    ./bench_lazy [count]
+//
+******************************************************************************/
+#include <vector>
+#include "bench.h"
+#include "../hobs.h"
+
+static void fill(NumericMessage &m)
+{
+    m.valid = true;
+    m.bytes.assign(32, -3);
+    m.levels.assign(16, 0.5);
+    m.opt_param = string("optional");
+    m.numbers.assign(8, 2.5f);
+    m.names.assign(4, string("name"));
+
+    for (size_t i=0; i<16; i++)
+    {
+        MyStruct s;
+
+        s.anEnum = static_cast<uint32_t>(i);
+        s.aChar  = static_cast<uint8_t>('A' + i);
+
+        m.structs.push_back(s);
+    }
+
+    m.opt_struct = m.structs[3];
+
+    for (size_t i=0; i<256; i++)
+    {
+        m.ids.push_back(1000 + 3 * static_cast<uint32_t>(i));
+        m.samples.push_back(20.0 + static_cast<double>(i % 7) * 0.25);
+        m.history.push_back(static_cast<uint32_t>(bench_random() & 0xffff));
+    }
+
+    m.counters.assign(64, -2);
+    m.states.assign(64, 1);
+    m.readings.assign(32, 1.5f);
+    m.trace.assign(32, 0.125);
+    m.stamp  = 0x0123456789abcdefllu;
+    m.offset = -7;
+    m.level  = 12;
+    m.shift  = 5;
+    m.ratio  = 0.75;
+}
+
+static void fill(ComplexStruct &m)
+{
+    for (size_t i=0; i<m.bits.size(); i++)
+    {
+        m.bits.set(i, (i % 3) == 0);
+    }
+
+    m.var_bits.assign(100, true);
+    m.iperbits.assign(5, FlagsT(5));
+    m.root.aMap[1] = "one";
+    m.root.aMap[2] = "two";
+    m.root.dat.aFloat = 2.5f;
+}
+
+static void fill(AnotherStruct &m)
+{
+    m.smin = -300;
+    m.lmax = 1234567890123ll;
+    m.bar  = 2.5;
+    m.aMap[0] = "zero";
+    m.aMap[1] = "one";
+    m.dat.aChar = 'Z';
+}
+
+// Last field of the frame, the worst case for the first lazy access
+
+static uint64_t last(NumericMessage::Lazy &l) { return l.trace().size();    }
+static uint64_t last(ComplexStruct::Lazy  &l) { return l.iperbits().size(); }
+static uint64_t last(AnotherStruct::Lazy  &l) { return l.aMap().size();     }
+
+static uint64_t last(const NumericMessage &m) { return m.trace.size();    }
+static uint64_t last(const ComplexStruct  &m) { return m.iperbits.size(); }
+static uint64_t last(const AnotherStruct  &m) { return m.aMap.size();     }
+
+template<class T>
+static void run(const char *name, size_t count)
+{
+    T m;
+
+    fill(m);
+
+    vector<uint8_t> frame;
+
+    BENCH_CHECK(m.serialize_to(frame) > 0);
+
+    printf("\n%s, %zu bytes frame\n\n", name, frame.size());
+
+    uint64_t sum = 0;
+    double   t;
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        T         d;
+        HOB::View v(&frame[0], frame.size());
+
+        BENCH_CHECK(d << v);
+
+        sum += last(d);
+    }
+
+    BENCH_REPORT("  HOB::View, full decode", bench_now() - t, count);
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        typename T::Lazy l(HOB::View(&frame[0], frame.size()));
+
+        sum -= last(l);
+    }
+
+    BENCH_REPORT("  Lazy, last field only", bench_now() - t, count);
+
+    BENCH_CHECK(0 == sum);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+
+    run<AnotherStruct >("AnotherStruct" , count);
+    run<NumericMessage>("NumericMessage", count);
+    run<ComplexStruct >("ComplexStruct" , count);
+
+    return 0;
+}
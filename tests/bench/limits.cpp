@@ -0,0 +1,155 @@
+/******************************************************************************
+//
+// Decoding limits micro benchmark
+//
+// Times the rejection of frames claiming huge containers and strings in a
+// few bytes, and of text groups nested too deep. The limits, the absence of
+// heap allocations and the well formed frames are checked by
+// tests/checks/limits.cpp.
+//
+// Usage:
+//
+//    ./bench_limits [count]
+//
+******************************************************************************/
+#include <sstream>
+#include "bench.h"
+
+HOBSTRUCT(Buffer, "BUFFER",
+    (vector<uint32_t>, items)
+    (string          , name )
+)
+
+// A single count, to forge the payloads of the Buffers with
+
+HOBSTRUCT(Count, "COUNT",
+    (uint64_t, count)
+)
+
+// The payload bytes of a frame
+//
+static void payload(const vector<uint8_t> &f, vector<uint8_t> &p)
+{
+    HOB::View v(&f[0], f.size());
+
+    BENCH_CHECK(v.consumed() == f.size());
+
+    p.insert(p.end(), v.payload(), v.payload() + v.payload_size());
+}
+
+// The count as written on the wire
+//
+static void count(uint64_t n, vector<uint8_t> &p)
+{
+    Count c;
+    vector<uint8_t> f;
+
+    c.count = n;
+
+    BENCH_CHECK(c.serialize_to(f) > 0);
+
+    payload(f, p);
+}
+
+// A Buffer frame of the given (short) payload
+//
+static void forge(const vector<uint8_t> &p, vector<uint8_t> &f)
+{
+    Buffer          b;
+    vector<uint8_t> e;
+
+    BENCH_CHECK(b.serialize_to(e) > 0);
+
+    HOB::View v(&e[0], e.size());
+
+    BENCH_CHECK(p.size() < 0x80);
+
+    // The ID as is, the single byte payload size replaced
+
+    f.assign(e.begin(), e.begin() + (v.consumed() - v.payload_size() - 1));
+    f.push_back(static_cast<uint8_t>(p.size()));
+    f.insert(f.end(), p.begin(), p.end());
+}
+
+// Decodes a forged frame count times
+//
+static void reject(const char *what, const vector<uint8_t> &f, size_t count)
+{
+    Buffer d;
+    double e;
+    char   m[64];
+
+    e = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        BENCH_CHECK(!(d << HOB::View(&f[0], f.size())));
+    }
+
+    e = bench_now() - e;
+
+    snprintf(m, sizeof(m), "%s, HOB::View", what);
+
+    BENCH_REPORT(m, e, count);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t n = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    vector<uint8_t> p;
+    vector<uint8_t> f;
+
+    // 2^40 items, 2^40 chars, in a few bytes
+
+    count(1llu << 40, p);
+    count(7, p);
+
+    forge(p, f);
+
+    reject("2^40 items vector", f, n);
+
+    p.clear();
+
+    count(0, p);
+    count(1llu << 40, p);
+
+    p.push_back('a');
+
+    forge(p, f);
+
+    reject("2^40 chars string", f, n);
+
+    // Within the limits, but past the bytes left in the frame
+
+    p.clear();
+
+    count(1000, p);
+    count(7, p);
+
+    forge(p, f);
+
+    reject("1000 items, 1 byte left", f, n);
+
+    // Text groups nested too deep
+
+    {
+        string t(100000, '[');
+
+        stringstream txt(t);
+        stringstream raw;
+        HOB::Src     src(txt);
+        HOB::Snk     snk(raw);
+        double       e;
+
+        e = bench_now();
+
+        BENCH_CHECK(!(src >> snk));
+
+        e = bench_now() - e;
+
+        BENCH_REPORT("100000 nested text groups", e, 1);
+    }
+
+    return 0;
+}
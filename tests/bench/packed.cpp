@@ -0,0 +1,104 @@
+/******************************************************************************
+//
+// Packed integer vectors micro benchmark
+//
+// Compares the wire size and the decoding speed of plain VARINT vectors
+// (vector<T>) against the adaptive packed codecs (packed<T>) on typical
+// data sets. The decoded values are checked by tests/checks/packed.cpp.
+//
+// Usage:
+//
+//    ./bench_packed [count]
+//
+******************************************************************************/
+#include <sstream>
+#include <vector>
+#include "bench.h"
+
+class Codec: public HOB
+{
+public:
+    template<class T>
+    static bool write(ostream &os, const T &v)
+    {
+        return HOB::_w(os, v);
+    }
+
+    template<class T>
+    bool read(istream &is, T &v)
+    {
+        return HOB::_r(is, v);
+    }
+};
+
+//
+// Data sets
+//
+static uint64_t sorted_ids(size_t i)     { return 100000 + i * 3 + (bench_random() % 3); }
+static uint64_t slow_counters(size_t i)  { return 5000000 + i / 16; }
+static uint64_t status_runs(size_t i)    { return (i / 1000) % 4; }
+static uint64_t random_values(size_t i)  { (void)i; return bench_random() & 0xfffff; }
+
+template<class T>
+static void run(const char *name, uint64_t (*gen)(size_t), size_t count)
+{
+    vector<T> values(count);
+
+    for (size_t i=0; i<count; i++)
+    {
+        values[i] = static_cast<T>(gen(i));
+    }
+
+    HOB::packed<T> p_values(values);
+
+    stringstream v_ss;
+    stringstream p_ss;
+    Codec        codec;
+
+    printf("\n%s\n\n", name);
+
+    double t;
+
+    t = bench_now();
+
+    BENCH_CHECK(Codec::write(v_ss, values));
+
+    BENCH_REPORT("  vector<T> write", bench_now() - t, count);
+
+    t = bench_now();
+
+    BENCH_CHECK(Codec::write(p_ss, p_values));
+
+    BENCH_REPORT("  packed<T> write", bench_now() - t, count);
+
+    vector<T>      v_decoded;
+    HOB::packed<T> p_decoded;
+
+    t = bench_now();
+
+    BENCH_CHECK(codec.read(v_ss, v_decoded));
+
+    BENCH_REPORT("  vector<T> read", bench_now() - t, count);
+
+    t = bench_now();
+
+    BENCH_CHECK(codec.read(p_ss, p_decoded));
+
+    BENCH_REPORT("  packed<T> read", bench_now() - t, count);
+
+    printf("  %.3f bytes/value (vector<T>), %.3f bytes/value (packed<T>)\n",
+           static_cast<double>(v_ss.str().size()) / static_cast<double>(count),
+           static_cast<double>(p_ss.str().size()) / static_cast<double>(count));
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    run<uint32_t>("sorted ids, uint32_t"     , sorted_ids   , count);
+    run<uint64_t>("slow counters, uint64_t"  , slow_counters, count);
+    run<uint8_t >("status runs, uint8_t"     , status_runs  , count);
+    run<int32_t >("random 20 bits, int32_t"  , random_values, count);
+
+    return 0;
+}
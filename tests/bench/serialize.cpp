@@ -0,0 +1,211 @@
+/******************************************************************************
+//
+// HOB serialization micro benchmark
+//
+// Compares the serialization of a HOB through std::ostream (stringstream and
+// HOB::Buffer) against the direct to memory serialize_to(), into new and
+// reused destinations. Then times a 5 levels tree of nested HOBs, whose
+// payload sizes are evaluated once per serialization. The bytes written are
+// checked by tests/checks/serialize.cpp.
+//
+// Usage:
+//
+//    ./bench_serialize [count]
+//
+******************************************************************************/
+#include <sstream>
+#include <vector>
+#include "bench.h"
+
+HOBSTRUCT(Item, "ITEM",
+    (uint32_t, id   , 0 )
+    (string  , name ,   )
+    (double  , value, 0.)
+)
+
+HOBSTRUCT(Frame, "FRAME",
+    (uint64_t    , stamp, 0)
+    (vector<Item>, items,  )
+    (string      , note ,  )
+)
+
+HOBSTRUCT(Leaf, "LEAF",
+    (uint32_t        , id    , 0)
+    (vector<uint32_t>, values,  )
+)
+
+HOBSTRUCT(Twig, "TWIG",
+    (uint32_t    , id    , 0)
+    (vector<Leaf>, leaves,  )
+)
+
+HOBSTRUCT(Branch, "BRANCH",
+    (uint32_t    , id   , 0)
+    (vector<Twig>, twigs,  )
+)
+
+HOBSTRUCT(Bough, "BOUGH",
+    (uint32_t      , id      , 0)
+    (vector<Branch>, branches,  )
+)
+
+HOBSTRUCT(Tree, "TREE",
+    (uint32_t     , id    , 0)
+    (vector<Bough>, boughs,  )
+)
+
+static void bench_tree(size_t count)
+{
+    Tree t;
+
+    for (size_t a=0; a<4; a++)
+    {
+        Bough bo;
+
+        for (size_t b=0; b<4; b++)
+        {
+            Branch br;
+
+            for (size_t c=0; c<4; c++)
+            {
+                Twig tw;
+
+                for (size_t d=0; d<4; d++)
+                {
+                    Leaf l;
+
+                    for (size_t e=0; e<32; e++)
+                    {
+                        l.values.push_back(static_cast<uint32_t>(bench_random()));
+                    }
+
+                    tw.leaves.push_back(l);
+                }
+
+                br.twigs.push_back(tw);
+            }
+
+            bo.branches.push_back(br);
+        }
+
+        t.boughs.push_back(bo);
+    }
+
+    size_t len = t;
+
+    printf("\n%zu bytes tree\n\n", len);
+
+    vector<uint8_t> dst(len);
+
+    double s = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        BENCH_CHECK(t.serialize_to(&dst[0], dst.size()) == len);
+    }
+
+    BENCH_REPORT("  tree serialize_to(uint8_t*, size_t)", bench_now() - s, count);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+
+    Frame f;
+
+    f.stamp = 0x0123456789abcdefllu;
+    f.note  = "serialization benchmark";
+
+    for (size_t i=0; i<16; i++)
+    {
+        Item it;
+
+        it.id    = static_cast<uint32_t>(bench_random());
+        it.name  = "item";
+        it.value = static_cast<double>(i) * 0.5;
+
+        f.items.push_back(it);
+    }
+
+    size_t len = f;
+
+    printf("\n%zu bytes frame\n\n", len);
+
+    double t;
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        stringstream ss;
+
+        BENCH_CHECK(f >> ss);
+    }
+
+    BENCH_REPORT("  operator>>(stringstream)", bench_now() - t, count);
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        HOB::Buffer b;
+
+        BENCH_CHECK(f >> b);
+    }
+
+    BENCH_REPORT("  operator>>(HOB::Buffer)", bench_now() - t, count);
+
+    vector<uint8_t> dst(len);
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        BENCH_CHECK(f.serialize_to(&dst[0], dst.size()) == len);
+    }
+
+    BENCH_REPORT("  serialize_to(uint8_t*, size_t)", bench_now() - t, count);
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        vector<uint8_t> v;
+
+        BENCH_CHECK(f.serialize_to(v) == len);
+    }
+
+    BENCH_REPORT("  serialize_to(vector<uint8_t>)", bench_now() - t, count);
+
+    // Reused destinations
+
+    vector<uint8_t> v;
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        v.clear();
+
+        BENCH_CHECK(f.serialize_to(v) == len);
+    }
+
+    BENCH_REPORT("  serialize_to(vector<uint8_t>), reused", bench_now() - t, count);
+
+    HOB::Buffer hb;
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        hb.clear();
+
+        BENCH_CHECK(f.serialize_to(hb) == len);
+    }
+
+    BENCH_REPORT("  serialize_to(HOB::Buffer), reused", bench_now() - t, count);
+
+    bench_tree(count / 100);
+
+    return 0;
+}
@@ -0,0 +1,371 @@
+/******************************************************************************
+//
+// VARINT codec micro benchmark
+//
+// Compares the HOB VARINT codec core against the reference byte per byte
+// implementation, both on memory buffers and through the iostream path.
+// The wire bytes are checked by tests/checks/varint.cpp.
+//
+// Usage:
+//
+//    ./bench_varint [count]
+//
+******************************************************************************/
+#include <string.h>
+#include <sstream>
+#include <vector>
+#include "bench.h"
+
+class Codec: public HOB
+{
+public:
+    static uint8_t pack(uint8_t *d, const uint64_t &v)
+    {
+        return varint_pack(d, v);
+    }
+
+    static uint8_t unpack(const uint8_t *d, uint64_t &v)
+    {
+        uint8_t b = varint_prefix_length(d[0]);
+
+        v = varint_unpack(d, b);
+
+        return b;
+    }
+
+    static bool write(ostream &os, const uint64_t &v)
+    {
+        return HOB::_w(os, v);
+    }
+
+    bool read(istream &is, uint64_t &v)
+    {
+        return HOB::_r(is, v);
+    }
+
+    template<class T>
+    static bool write(ostream &os, const vector<T> &v)
+    {
+        return HOB::_w(os, v);
+    }
+
+    // Per item vector read
+    //
+    template<class T>
+    bool read_items(istream &is, vector<T> &v)
+    {
+        size_t len = 0;
+
+        if (!HOB::_r(is, len))
+        {
+            return false;
+        }
+
+        v.resize(len);
+
+        return (0 == len) || HOB::_rv<T>(is, &v[0], len);
+    }
+
+    // Bulk vector read
+    //
+    template<class T>
+    bool read_bulk(istream &is, vector<T> &v)
+    {
+        return HOB::_r(is, v);
+    }
+};
+
+//
+// Reference implementation: ternary chain length, per byte shift loops
+//
+static uint8_t ref_pack(uint8_t *d, const uint64_t &v)
+{
+    uint8_t b = (v <= 0x000000000000007fllu) ? 1 :
+                (v <= 0x0000000000003fffllu) ? 2 :
+                (v <= 0x00000000001fffffllu) ? 3 :
+                (v <= 0x000000000fffffffllu) ? 4 :
+                (v <= 0x00000007ffffffffllu) ? 5 :
+                (v <= 0x000003ffffffffffllu) ? 6 :
+                (v <= 0x0001ffffffffffffllu) ? 7 :
+                (v <= 0x00ffffffffffffffllu) ? 8 : 9;
+
+    uint8_t  m = 0xff;
+    uint32_t c = 0xfffffe00;
+
+    for (uint8_t i=0; i<b; i++)
+    {
+        d[b-i-1] = static_cast<uint8_t>( ( v >> (8*i) ) & 0xff );
+
+        c >>= 1;
+        m >>= 1;
+    }
+
+    d[0] &= static_cast<uint8_t>(m & 0xff);
+    d[0] |= static_cast<uint8_t>(c & 0xff);
+
+    return b;
+}
+
+static uint8_t ref_unpack(const uint8_t *d, uint64_t &v)
+{
+    uint8_t b;
+    uint8_t c;
+    uint8_t m = 0;
+
+    for (b=1; b<=8; b++)
+    {
+        m = (0xff << (8-b));
+        c = (0x01 << (8-b));
+
+        if ((d[0] & c) == 0)
+        {
+            break;
+        }
+    }
+
+    uint64_t rv = (b < 9) ? d[0] & ~m : 0;
+
+    for (uint8_t i=1; i<b; i++)
+    {
+        rv <<= 8;
+        rv |= static_cast<uint64_t>(d[i] & 0xff);
+    }
+
+    v = rv;
+
+    return b;
+}
+
+static bool ref_write(ostream &os, const uint64_t &v)
+{
+    uint8_t d[9];
+
+    uint8_t b = ref_pack(d, v);
+
+    return os.write(reinterpret_cast<const char *>(d), b).good();
+}
+
+static bool ref_read(istream &is, uint64_t &v)
+{
+    uint8_t d[9];
+
+    if (!is.read(reinterpret_cast<char *>(d), 1).good())
+    {
+        return false;
+    }
+
+    uint8_t b = 1;
+
+    for (uint8_t m = 0x80; (m != 0) && (d[0] & m); m >>= 1)
+    {
+        b++;
+    }
+
+    if ((b > 1) && !is.read(reinterpret_cast<char *>(&d[1]), b-1).good())
+    {
+        return false;
+    }
+
+    ref_unpack(d, v);
+
+    return true;
+}
+
+//
+// Value distributions
+//
+static uint64_t small_values()  { return bench_random() & 0x7f; }
+static uint64_t medium_values() { return bench_random() & 0x1fffff; }
+static uint64_t mixed_values()  { return bench_random() >> (bench_random() % 64); }
+static uint64_t double_values()
+{
+    double d = static_cast<double>(bench_random() % 100000) / 100.0;
+    uint64_t v;
+
+    memcpy(&v, &d, sizeof(v));
+
+    return v;
+}
+
+static void run(const char *name, uint64_t (*gen)(), size_t count)
+{
+    vector<uint64_t> values(count);
+    vector<uint64_t> decoded(count);
+    vector<uint8_t>  ref_buf(count * 9 + 8);
+    vector<uint8_t>  new_buf(count * 9 + 8);
+
+    for (size_t i=0; i<count; i++)
+    {
+        values[i] = gen();
+    }
+
+    printf("\n%s\n\n", name);
+
+    size_t ref_len = 0;
+    size_t new_len = 0;
+    double t;
+    char   what[64];
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        ref_len += ref_pack(&ref_buf[ref_len], values[i]);
+    }
+
+    snprintf(what, sizeof(what), "  reference pack");
+    BENCH_REPORT(what, bench_now() - t, count);
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        new_len += Codec::pack(&new_buf[new_len], values[i]);
+    }
+
+    snprintf(what, sizeof(what), "  codec pack");
+    BENCH_REPORT(what, bench_now() - t, count);
+
+    size_t p;
+
+    t = bench_now();
+
+    p = 0;
+
+    for (size_t i=0; i<count; i++)
+    {
+        p += ref_unpack(&ref_buf[p], decoded[i]);
+    }
+
+    snprintf(what, sizeof(what), "  reference unpack");
+    BENCH_REPORT(what, bench_now() - t, count);
+
+    decoded.assign(count, 0);
+
+    t = bench_now();
+
+    p = 0;
+
+    for (size_t i=0; i<count; i++)
+    {
+        p += Codec::unpack(&new_buf[p], decoded[i]);
+    }
+
+    snprintf(what, sizeof(what), "  codec unpack");
+    BENCH_REPORT(what, bench_now() - t, count);
+
+    stringstream ref_ss;
+    stringstream new_ss;
+    Codec        codec;
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        BENCH_CHECK(ref_write(ref_ss, values[i]));
+    }
+
+    snprintf(what, sizeof(what), "  reference iostream write");
+    BENCH_REPORT(what, bench_now() - t, count);
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        BENCH_CHECK(Codec::write(new_ss, values[i]));
+    }
+
+    snprintf(what, sizeof(what), "  HOB::_w(ostream&, uint64_t)");
+    BENCH_REPORT(what, bench_now() - t, count);
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        BENCH_CHECK(ref_read(ref_ss, decoded[i]));
+    }
+
+    snprintf(what, sizeof(what), "  reference iostream read");
+    BENCH_REPORT(what, bench_now() - t, count);
+
+    decoded.assign(count, 0);
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        BENCH_CHECK(codec.read(new_ss, decoded[i]));
+    }
+
+    snprintf(what, sizeof(what), "  HOB::_r(istream&, uint64_t)");
+    BENCH_REPORT(what, bench_now() - t, count);
+
+    printf("  %.2f bytes/value\n",
+           static_cast<double>(new_len) / static_cast<double>(count));
+}
+
+template<class T>
+static void run_vector(const char *name, uint64_t (*gen)(), size_t count)
+{
+    vector<T> values(count);
+    vector<T> decoded;
+    Codec     codec;
+
+    for (size_t i=0; i<count; i++)
+    {
+        values[i] = static_cast<T>(gen());
+    }
+
+    stringstream ss;
+
+    BENCH_CHECK(Codec::write(ss, values));
+
+    printf("\n%s\n\n", name);
+
+    double t;
+
+    t = bench_now();
+
+    BENCH_CHECK(codec.read_items(ss, decoded));
+
+    BENCH_REPORT("  per item vector read", bench_now() - t, count);
+
+    ss.seekg(0);
+    decoded.clear();
+
+    t = bench_now();
+
+    BENCH_CHECK(codec.read_bulk(ss, decoded));
+
+    BENCH_REPORT("  bulk vector read", bench_now() - t, count);
+
+}
+
+static uint64_t signed_values()
+{
+    return static_cast<uint64_t>(
+               static_cast<int64_t>(bench_random() % 2001) - 1000);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+
+    run("1 byte values (7 bits)"       , small_values , count);
+    run("up to 3 bytes values (21 bits)", medium_values, count);
+    run("mixed lengths values"         , mixed_values , count);
+    run("double bit patterns"          , double_values, count);
+
+    run_vector<uint32_t>("vector<uint32_t>, 7 bits values",
+                         small_values, count);
+    run_vector<uint32_t>("vector<uint32_t>, up to 21 bits values",
+                         medium_values, count);
+    run_vector<uint64_t>("vector<uint64_t>, mixed lengths values",
+                         mixed_values, count);
+    run_vector<int16_t >("vector<int16_t>, -1000 .. 1000 values",
+                         signed_values, count);
+    run_vector<int8_t  >("vector<int8_t>, -128 .. 127 values",
+                         bench_random, count);
+
+    return 0;
+}
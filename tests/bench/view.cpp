@@ -0,0 +1,131 @@
+/******************************************************************************
+//
+// HOB::View micro benchmark
+//
+// Compares the decoding of HOBs from an istream (generic HOB first, then the
+// typed one) against the decoding straight from memory through HOB::View.
+// The decoded values and the truncated frames are checked by
+// tests/checks/view.cpp.
+//
+// Usage:
+//
+//    ./bench_view [count]
+//
+******************************************************************************/
+#include <sstream>
+#include <vector>
+#include "bench.h"
+#include "../hobs.h"
+
+static void fill(NumericMessage &m)
+{
+    m.bytes.assign(32, -3);
+    m.levels.assign(16, 0.5);
+    m.opt_param = string("optional");
+    m.numbers.assign(8, 2.5f);
+    m.names.assign(4, string("name"));
+
+    for (size_t i=0; i<16; i++)
+    {
+        MyStruct s;
+
+        s.anEnum = static_cast<uint32_t>(i);
+        s.aChar  = static_cast<uint8_t>('A' + i);
+
+        m.structs.push_back(s);
+    }
+
+    m.opt_struct = m.structs[3];
+
+    for (size_t i=0; i<256; i++)
+    {
+        m.ids.push_back(1000 + 3 * static_cast<uint32_t>(i));
+        m.samples.push_back(20.0 + static_cast<double>(i % 7) * 0.25);
+        m.history.push_back(static_cast<uint32_t>(bench_random() & 0xffff));
+    }
+
+    m.counters.assign(64, -2);
+    m.states.assign(64, 1);
+    m.readings.assign(32, 1.5f);
+    m.trace.assign(32, 0.125);
+    m.stamp = 0x0123456789abcdefllu;
+}
+
+static void fill(ComplexStruct &m)
+{
+    for (size_t i=0; i<m.bits.size(); i++)
+    {
+        m.bits.set(i, (i % 3) == 0);
+    }
+
+    m.var_bits.assign(100, true);
+    m.iperbits.assign(5, FlagsT(5));
+    m.root.aMap[1] = "one";
+    m.root.aMap[2] = "two";
+    m.root.dat.aFloat = 2.5f;
+}
+
+static void fill(AnotherStruct &m)
+{
+    m.aMap[0] = "zero";
+    m.aMap[1] = "one";
+    m.dat.aChar = 'Z';
+}
+
+template<class T>
+static void run(const char *name, size_t count)
+{
+    T m;
+
+    fill(m);
+
+    vector<uint8_t> frame;
+
+    BENCH_CHECK(m.serialize_to(frame) > 0);
+
+    stringstream ss;
+
+    BENCH_CHECK(m >> ss);
+
+    printf("\n%s, %zu bytes frame\n\n", name, frame.size());
+
+    double t;
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        T   d;
+        HOB h;
+
+        ss.clear();
+        ss.seekg(0);
+
+        BENCH_CHECK((h << ss) && (d << h));
+    }
+
+    BENCH_REPORT("  istream, generic then typed HOB", bench_now() - t, count);
+
+    t = bench_now();
+
+    for (size_t i=0; i<count; i++)
+    {
+        T         d;
+        HOB::View v(&frame[0], frame.size());
+
+        BENCH_CHECK((d << v) && (v.consumed() == frame.size()));
+    }
+
+    BENCH_REPORT("  HOB::View", bench_now() - t, count);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+
+    run<AnotherStruct >("AnotherStruct" , count);
+    run<NumericMessage>("NumericMessage", count);
+    run<ComplexStruct >("ComplexStruct" , count);
+
+    return 0;
+}
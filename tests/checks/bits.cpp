@@ -0,0 +1,200 @@
+/******************************************************************************
+//
+// Bit containers checks
+//
+// Checks that bitset<> and vector<bool> put on the wire the bits packed one
+// at a time, LSB first, after their VARINT byte count (and bits count), for
+// sizes around the storage word, the 1 and 2 bytes counts and past 2040
+// bits, that they round trip, and that the fields following them, also
+// after an empty vector<bool>, are decoded where they are.
+//
+// Usage:
+//
+//    ./check_bits
+//
+******************************************************************************/
+#include "check.h"
+
+class Codec: public HOB
+{
+public:
+    static void write(vector<uint8_t> &b, const uint64_t &v)
+    {
+        uint8_t d[9];
+
+        b.insert(b.end(), d, d + varint_pack(d, v));
+    }
+};
+
+#define MASK(n_)                                                               \
+    HOBSTRUCT(Mask ## n_, "MASK",                                              \
+        (bitset<n_>, flags)                                                    \
+        (uint32_t  , after)                                                    \
+    )
+
+MASK(1)
+MASK(8)
+MASK(63)
+MASK(64)
+MASK(65)
+MASK(256)
+MASK(1016)
+MASK(1024)
+MASK(2040)
+MASK(2048)
+MASK(4096)
+MASK(10000)
+
+HOBSTRUCT(Bitmap, "BITMAP",
+    (vector<bool>, bits )
+    (uint32_t    , after)
+)
+
+// The bits one at a time, LSB first
+//
+template<class C>
+static void pack(const C &v, size_t n, vector<uint8_t> &b)
+{
+    size_t o = b.size();
+
+    b.resize(o + ((n + 7) >> 3), 0);
+
+    for (size_t j=0; j<n; j++)
+    {
+        b[o + (j>>3)] |= static_cast<uint8_t>(v[j] << (j&7));
+    }
+}
+
+template<class T>
+static vector<uint8_t> payload(const T &t)
+{
+    vector<uint8_t> f;
+
+    CHECK(t.serialize_to(f) > 0);
+
+    HOB::View v(&f[0], f.size());
+
+    CHECK(v.consumed() == f.size());
+
+    return vector<uint8_t>(v.payload(), v.payload() + v.payload_size());
+}
+
+template<class T>
+static void check_round_trip(const T &t, T &d)
+{
+    vector<uint8_t> f;
+
+    CHECK(t.serialize_to(f) > 0);
+    CHECK(d << HOB::View(&f[0], f.size()));
+    CHECK(d == t);
+
+    typename T::Lazy l(HOB::View(&f[0], f.size()));
+
+    CHECK(l.frame_ok());
+    CHECK(l.after() == t.after);
+}
+
+template<class T>
+static void check_mask(size_t count_bytes)
+{
+    T t;
+    T d;
+
+    size_t n = t.flags.size();
+
+    for (size_t r=0; r<4; r++)
+    {
+        for (size_t j=0; j<n; j++)
+        {
+            t.flags[j] = (r < 2) ? (r == 1) : (check_random() & 1);
+        }
+
+        t.after = 0x12345 + static_cast<uint32_t>(r);
+
+        vector<uint8_t> b;
+
+        Codec::write(b, (n + 7) >> 3);
+
+        CHECK(b.size() == count_bytes);
+
+        pack(t.flags, n, b);
+
+        Codec::write(b, t.after);
+
+        CHECK(payload(t) == b);
+
+        check_round_trip(t, d);
+    }
+}
+
+static void check_bitmap(size_t n)
+{
+    Bitmap t;
+    Bitmap d;
+
+    t.bits.resize(n);
+
+    for (size_t j=0; j<n; j++)
+    {
+        t.bits[j] = (check_random() & 1);
+    }
+
+    t.after = 0x12345;
+
+    vector<uint8_t> b;
+
+    Codec::write(b, n);
+    Codec::write(b, (n + 7) >> 3);
+
+    pack(t.bits, n, b);
+
+    Codec::write(b, t.after);
+
+    CHECK(payload(t) == b);
+
+    // Into a shorter, a longer and an equal vector<bool>
+
+    d.bits.assign(300, true);
+
+    check_round_trip(t, d);
+
+    d.bits.clear();
+
+    check_round_trip(t, d);
+    check_round_trip(t, d);
+}
+
+int main()
+{
+    check_mask<Mask1    >(1);
+    check_mask<Mask8    >(1);
+    check_mask<Mask63   >(1);
+    check_mask<Mask64   >(1);
+    check_mask<Mask65   >(1);
+    check_mask<Mask256  >(1);
+    check_mask<Mask1016 >(1);
+    check_mask<Mask1024 >(2);
+    check_mask<Mask2040 >(2);
+    check_mask<Mask2048 >(2);
+    check_mask<Mask4096 >(2);
+    check_mask<Mask10000>(2);
+
+    // Sizes that are not a multiple of the storage word, and empty
+
+    for (size_t n=0; n<200; n+=13)
+    {
+        check_bitmap(n);
+    }
+
+    static const size_t sizes[] =
+    {
+        0, 1, 63, 64, 65, 127, 128, 129, 1016, 1024, 2040, 2048, 10000, 1 << 20
+    };
+
+    for (size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+    {
+        check_bitmap(sizes[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,365 @@
+/******************************************************************************
+//
+// Kept encoded frames checks
+//
+// Checks that a HOBSTRUCT keeping its frame (CACHE_ENCODING) sends the very
+// frame encoded from scratch of the same fields: untouched, after fields set
+// through their setters to values of the same and of other lengths, changed
+// in place then touched, decoded into, copied, nested in an enclosing HOB
+// keeping its own frame, and of fields named as the parameters of the
+// generated members.
+//
+// Usage:
+//
+//    ./check_cache
+//
+******************************************************************************/
+#include <string.h>
+#include <sstream>
+#include "check.h"
+
+typedef map<uint8_t, string> Labels;
+
+#define CONFIG_FIELDS                                                          \
+    (string          , name    )                                               \
+    (string          , host    )                                               \
+    (uint32_t        , port    )                                               \
+    (bool            , enabled )                                               \
+    (double          , rate    )                                               \
+    (vector<string>  , peers   )                                               \
+    (vector<uint32_t>, ids     )                                               \
+    (Labels          , labels  )                                               \
+    (optional<string>, comment )                                               \
+    (uint64_t        , stamp   )
+
+HOBSTRUCT(Config, "CONFIG", CONFIG_FIELDS)
+
+CACHE_ENCODING(CachedConfig)
+
+HOBSTRUCT(CachedConfig, "CONFIG", CONFIG_FIELDS)
+
+HOBSTRUCT(PlainDeployment, "DEPLOYMENT",
+    (Config  , config)
+    (string  , site  )
+    (uint64_t, stamp )
+)
+
+CACHE_ENCODING(Deployment)
+
+HOBSTRUCT(Deployment, "DEPLOYMENT",
+    (CachedConfig, config)
+    (string      , site  )
+    (uint64_t    , stamp )
+)
+
+// Fields named as the parameters of the generated members
+
+#define NAMES_FIELDS                                                           \
+    (uint32_t, c)                                                              \
+    (uint32_t, p)                                                              \
+    (uint32_t, n)                                                              \
+    (string  , v)                                                              \
+    (uint32_t, e)
+
+HOBSTRUCT(Names, "NAMES", NAMES_FIELDS)
+
+CACHE_ENCODING(CachedNames)
+
+HOBSTRUCT(CachedNames, "NAMES", NAMES_FIELDS)
+
+template<class C>
+static void fill(C &c)
+{
+    c.name    = "a service name well past the short string size";
+    c.host    = "a host name well past the short string size";
+    c.port    = 8080;
+    c.enabled = true;
+    c.rate    = 0.25;
+    c.comment = string("a comment well past the short string size");
+    c.stamp   = 0;
+
+    c.peers.assign(8, string("a peer name well past the short string size"));
+    c.ids.resize(64);
+
+    for (size_t i=0; i<c.ids.size(); i++)
+    {
+        c.ids[i] = static_cast<uint32_t>(i * 977);
+    }
+
+    for (uint8_t i=0; i<8; i++)
+    {
+        c.labels[i] = "a label well past the short string size";
+    }
+
+    c.touch();
+}
+
+// The frame sent by h, to an ostream and to memory, against the one of the
+// same fields encoded from scratch
+//
+template<class H, class C>
+static void check_same(const H &h, const C &c)
+{
+    stringstream a;
+    stringstream b;
+
+    CHECK(h >> a);
+    CHECK(c >> b);
+    CHECK(a.str() == b.str());
+    CHECK(static_cast<size_t>(h) == b.str().size());
+
+    vector<uint8_t> f;
+
+    CHECK(h.serialize_to(f) == b.str().size());
+    CHECK(string(f.begin(), f.end()) == b.str());
+}
+
+// Sets the field i of the plain one to a value drawn from r, then the same
+// field of the kept one through its setter
+//
+static void set_field(size_t i, uint64_t r, CachedConfig &k, Config &c)
+{
+    string   s(static_cast<size_t>(r % 200), static_cast<char>('a' + r % 26));
+    uint32_t u = static_cast<uint32_t>(r);
+
+    switch (i % 10)
+    {
+        case 0:
+            c.name = s;
+            k.set_name(c.name);
+            break;
+        case 1:
+            c.host = s;
+            k.set_host(c.host);
+            break;
+        case 2:
+            c.port = u;
+            k.set_port(c.port);
+            break;
+        case 3:
+            c.enabled = (r & 1);
+            k.set_enabled(c.enabled);
+            break;
+        case 4:
+            c.rate = static_cast<double>(u) * 0.5;
+            k.set_rate(c.rate);
+            break;
+        case 5:
+            c.peers.resize(r % 10, s);
+            k.set_peers(c.peers);
+            break;
+        case 6:
+            c.ids.assign(r % 300, u);
+            k.set_ids(c.ids);
+            break;
+        case 7:
+            c.labels[static_cast<uint8_t>(r)] = s;
+            k.set_labels(c.labels);
+            break;
+        case 8:
+            if (r & 1)
+            {
+                c.comment = s;
+            }
+            else
+            {
+                c.comment.reset();
+            }
+            k.set_comment(c.comment);
+            break;
+        default:
+            c.stamp = r;
+            k.set_stamp(c.stamp);
+            break;
+    }
+}
+
+static void check_setters()
+{
+    Config       c;
+    CachedConfig k;
+
+    fill(c);
+    fill(k);
+
+    check_same(k, c);
+    check_same(k, c);
+
+    for (size_t i=0; i<1000; i++)
+    {
+        set_field(i, check_random(), k, c);
+
+        check_same(k, c);
+
+        // A few fields set between two sends
+
+        if (0 == (i % 7))
+        {
+            set_field(i + 3, check_random(), k, c);
+            set_field(i + 5, check_random(), k, c);
+
+            check_same(k, c);
+        }
+    }
+}
+
+static void check_touched()
+{
+    Config       c;
+    CachedConfig k;
+
+    fill(c);
+    fill(k);
+
+    check_same(k, c);
+
+    // Changed in place, of the same length and of another one, then touched
+
+    k.ids[7] = c.ids[7] = 1;
+    k.labels[2] = c.labels[2] = "another label";
+
+    k.touch(CachedConfig::_ids);
+    k.touch(CachedConfig::_labels);
+
+    check_same(k, c);
+
+    k.port = c.port = 9090;
+    k.host = c.host = "h";
+
+    k.touch();
+
+    check_same(k, c);
+
+    // Decoded into: encoded again
+
+    stringstream ss;
+
+    c.rate = 0.5;
+    c.peers.clear();
+
+    CHECK(c >> ss);
+    CHECK(k.read_from(ss) > 0);
+
+    check_same(k, c);
+
+    // Copied and assigned
+
+    CachedConfig n(k);
+
+    check_same(n, c);
+
+    // Over a kept frame of other fields
+
+    Config       o;
+    CachedConfig m;
+
+    fill(o);
+    fill(m);
+
+    check_same(m, o);
+
+    m = k;
+
+    check_same(m, c);
+}
+
+// The payload sent by h against the one of the same fields encoded from
+// scratch, for HOBs of other UIDs
+//
+template<class H, class C>
+static void check_same_payload(const H &h, const C &c)
+{
+    vector<uint8_t> a;
+    vector<uint8_t> b;
+
+    CHECK(h.serialize_to(a) > 0);
+    CHECK(c.serialize_to(b) > 0);
+
+    HOB::View va(&a[0], a.size());
+    HOB::View vb(&b[0], b.size());
+
+    CHECK(va.consumed() == a.size());
+    CHECK(va.payload_size() == vb.payload_size());
+    CHECK(0 == memcmp(va.payload(), vb.payload(), va.payload_size()));
+}
+
+// The nested fields have other types, hence the UIDs differ
+//
+static void check_nested()
+{
+    PlainDeployment p;
+    Deployment      d;
+
+    fill(p.config);
+    fill(d.config);
+
+    p.site  = d.site  = "a site name well past the short string size";
+    p.stamp = d.stamp = 0;
+
+    d.touch();
+
+    check_same_payload(d, p);
+    check_same_payload(d, p);
+
+    for (size_t i=0; i<100; i++)
+    {
+        uint64_t r = check_random();
+
+        if (i & 1)
+        {
+            set_field(i, r, d.config, p.config);
+        }
+        else
+        {
+            d.set_stamp(r);
+            p.stamp = r;
+        }
+
+        check_same_payload(d, p);
+        check_same(d.config, p.config);
+    }
+
+    Deployment n(d);
+
+    check_same(d, n);
+}
+
+static void check_names()
+{
+    Names       r;
+    CachedNames k;
+
+    k.set_c(8);
+    k.set_p(9);
+    k.set_n(10);
+    k.set_v("eleven");
+    k.set_e(12);
+
+    CHECK((8 == k.c) && (9 == k.p) && (10 == k.n) && (12 == k.e));
+    CHECK("eleven" == k.v);
+
+    for (uint32_t i=0; i<3; i++)
+    {
+        vector<uint8_t> f;
+
+        CHECK(k.serialize_to(f) > 0);
+        CHECK(r << HOB::View(&f[0], f.size()));
+        CHECK((k.c == r.c) && (k.p == r.p) && (k.n == r.n) && (k.e == r.e));
+        CHECK(k.v == r.v);
+
+        check_same(k, r);
+
+        k.set_n(k.n + 100);
+        k.set_v(k.v + "s");
+    }
+}
+
+int main()
+{
+    check_setters();
+    check_touched();
+    check_nested();
+    check_names();
+
+    return 0;
+}
@@ -0,0 +1,34 @@
+#if !defined(__CHECK_H__)
+#define __CHECK_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "hob.hpp"
+
+// Deterministic pseudo random numbers (xorshift64*), so that every run
+// checks the same data
+//
+static inline uint64_t check_random()
+{
+    static uint64_t s = 0x9e3779b97f4a7c15llu;
+
+    s ^= s >> 12;
+    s ^= s << 25;
+    s ^= s >> 27;
+
+    return s * 2685821657736338717llu;
+}
+
+// Correctness checks stop at the first failure, with a non zero exit code
+// so that tests.sh and ctest report it
+//
+#define CHECK(cond_)                                                           \
+        if (!(cond_))                                                          \
+        {                                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n",                       \
+                    __FILE__, __LINE__, #cond_);                               \
+            exit(1);                                                           \
+        }
+
+#endif // __CHECK_H__
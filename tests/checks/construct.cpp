@@ -0,0 +1,132 @@
+/******************************************************************************
+//
+// HOB construction checks
+//
+// Checks that the HOBSTRUCT ID, evaluated once per type, matches a reference
+// HOB hashing its schema in every constructor, that it depends on the schema,
+// and that vectors of HOBSTRUCTs decode the very same items.
+//
+// Usage:
+//
+//    ./check_construct
+//
+******************************************************************************/
+#include <sstream>
+#include <vector>
+#include "check.h"
+
+HOBSTRUCT(MyStruct, "MY_STRUCT",
+    (uint32_t, anEnum  , 1    )
+    (uint8_t , aChar   , 4    )
+    (float   , aFloat  , 3.14f),
+    (bool    , optional, true )
+)
+
+HOBSTRUCT(RenamedField, "MY_STRUCT",
+    (uint32_t, anEnum  , 1    )
+    (uint8_t , aByte   , 4    )
+    (float   , aFloat  , 3.14f),
+    (bool    , optional, true )
+)
+
+HOBSTRUCT(RenamedStruct, "MY_OTHER_STRUCT",
+    (uint32_t, anEnum  , 1    )
+    (uint8_t , aChar   , 4    )
+    (float   , aFloat  , 3.14f),
+    (bool    , optional, true )
+)
+
+//
+// Reference implementation: the HOB ID is hashed on every construction
+//
+class RefStruct: public HOB
+{
+public:
+    RefStruct() : HOB("MY_STRUCT"), anEnum(1), aChar(4), aFloat(3.14f), optional(true)
+    {
+        update_id("name_"); update_id("uint32_t"); update_id("anEnum");
+        update_id("name_"); update_id("uint8_t" ); update_id("aChar" );
+        update_id("name_"); update_id("float"   ); update_id("aFloat");
+        update_id("");
+
+        update_id(static_cast<const char *>(NULL));
+    }
+
+    uint32_t anEnum;
+    uint8_t  aChar;
+    float    aFloat;
+    bool     optional;
+};
+
+// HOB ID accessor
+//
+template<class T>
+class Probe: public T
+{
+public:
+    const HOB::UID &id() const { return this->get_id(); }
+};
+
+class Codec: public HOB
+{
+public:
+    template<class T>
+    static bool write(ostream &os, const T &v)
+    {
+        return HOB::_w(os, v);
+    }
+
+    template<class T>
+    bool read(istream &is, T &v)
+    {
+        return HOB::_r(is, v);
+    }
+};
+
+static void check_ids()
+{
+    CHECK(Probe<RefStruct>().id() == Probe<MyStruct>().id());
+    CHECK(Probe<MyStruct>().id() == MyStruct::ID());
+
+    CHECK(RenamedField::ID()  != MyStruct::ID());
+    CHECK(RenamedStruct::ID() != MyStruct::ID());
+
+    Probe<MyStruct> m;
+    Probe<MyStruct> c(m);
+
+    CHECK(c.id() == MyStruct::ID());
+
+    CHECK(m.anEnum == 1);
+    CHECK(m.aChar  == 4);
+    CHECK(m.aFloat == 3.14f);
+    CHECK(m.optional);
+}
+
+static void check_vector(size_t items)
+{
+    vector<MyStruct> values(items);
+    vector<MyStruct> decoded;
+    stringstream     ss;
+    Codec            codec;
+
+    for (size_t i=0; i<items; i++)
+    {
+        values[i].anEnum = static_cast<uint32_t>(check_random());
+        values[i].aChar  = static_cast<uint8_t >(check_random());
+    }
+
+    CHECK(Codec::write(ss, values));
+    CHECK(codec.read(ss, decoded));
+    CHECK(decoded == values);
+}
+
+int main()
+{
+    check_ids();
+
+    check_vector(0);
+    check_vector(1);
+    check_vector(10000);
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+/******************************************************************************
+//
+// Associative and fixed size containers checks
+//
+// Checks the round trip of maps as map<>, flat_map<> and unordered_map<>,
+// into empty objects and into long lived ones whose keys are merged, that
+// the three of them put the very same pairs on the wire, then the round trip
+// of sets, fixed size arrays and flat maps written out of order.
+//
+// Usage:
+//
+//    ./check_containers
+//
+******************************************************************************/
+#include "check.h"
+
+typedef map<uint32_t, uint64_t>           Ordered;
+typedef HOB::flat_map<uint32_t, uint64_t> Flat;
+typedef unordered_map<uint32_t, uint64_t> Hashed;
+typedef array<uint32_t, 4>                Quad;
+
+HOBSTRUCT(OrderedIndex, "INDEX",
+    (Ordered, pairs)
+)
+
+HOBSTRUCT(FlatIndex, "INDEX",
+    (Flat, pairs)
+)
+
+HOBSTRUCT(HashedIndex, "INDEX",
+    (Hashed, pairs)
+)
+
+HOBSTRUCT(Shape, "SHAPE",
+    (set<string>, tags  )
+    (Quad       , bounds)
+    (uint8_t    , kind  )
+)
+
+// Payload of the pairs of a T, keys from first to last, step apart
+//
+template<class T>
+static vector<uint8_t> payload(size_t first, size_t last, size_t step,
+                               T &t)
+{
+    t.pairs.clear();
+
+    for (size_t i=first; i<last; i+=step)
+    {
+        t.pairs[static_cast<uint32_t>(i)] = i * 1000003llu;
+    }
+
+    vector<uint8_t> f;
+
+    CHECK(t.serialize_to(f) > 0);
+
+    HOB::View v(&f[0], f.size());
+
+    return vector<uint8_t>(v.payload(), v.payload() + v.payload_size());
+}
+
+template<class T>
+static void check_maps(size_t pairs)
+{
+    T t;
+
+    for (size_t i=0; i<pairs; i++)
+    {
+        t.pairs[static_cast<uint32_t>(i * 7)] = check_random();
+    }
+
+    vector<uint8_t> f;
+
+    CHECK(t.serialize_to(f) > 0);
+
+    T n;
+
+    CHECK(n << HOB::View(&f[0], f.size()));
+    CHECK(n.pairs.size() == pairs);
+    CHECK(n == t);
+
+    // Same pairs again: nothing changed
+
+    CHECK(n << HOB::View(&f[0], f.size()));
+    CHECK(!n);
+    CHECK(n == t);
+
+    // Keys added and dropped at both ends and in the middle, values changed
+
+    T u;
+
+    for (size_t i=0; i<pairs; i++)
+    {
+        if ((i % 5) != 2)
+        {
+            u.pairs[static_cast<uint32_t>(i * 7 + ((i % 3) ? 0 : 1))] = i;
+        }
+    }
+
+    u.pairs[0xffffffff] = 1;
+
+    f.clear();
+
+    CHECK(u.serialize_to(f) > 0);
+    CHECK(n << HOB::View(&f[0], f.size()));
+    CHECK(n);
+    CHECK(n == u);
+    CHECK(!(n == t));
+
+    // All of them dropped
+
+    T e;
+
+    f.clear();
+
+    CHECK(e.serialize_to(f) > 0);
+    CHECK(n << HOB::View(&f[0], f.size()));
+    CHECK(n.pairs.empty());
+}
+
+static void check_wire()
+{
+    OrderedIndex o;
+    FlatIndex    f;
+    HashedIndex  h;
+
+    for (size_t s=1; s<10; s+=4)
+    {
+        vector<uint8_t> op = payload(0, 1000, s, o);
+
+        CHECK(payload(0, 1000, s, f) == op);
+        CHECK(payload(0, 1000, s, h) == op);
+    }
+}
+
+static void check_shape()
+{
+    // Fixed size arrays have no items count on the wire
+
+    Shape s;
+
+    s.bounds[0] = 1;
+    s.bounds[3] = 4;
+    s.kind      = 2;
+
+    s.tags.insert("b");
+    s.tags.insert("a");
+
+    vector<uint8_t> f;
+
+    CHECK(s.serialize_to(f) > 0);
+
+    Shape d;
+
+    CHECK(d << HOB::View(&f[0], f.size()));
+    CHECK((d == s) && d);
+
+    s.tags.erase("a");
+    s.tags.insert("c");
+
+    f.clear();
+
+    CHECK(s.serialize_to(f) > 0);
+    CHECK(d << HOB::View(&f[0], f.size()));
+    CHECK((d == s) && (d & Shape::_tags) && !(d & Shape::_bounds));
+}
+
+static void check_flat()
+{
+    // Flat maps written out of order are sorted when read, the last of the
+    // pairs with the same key wins
+
+    FlatIndex u;
+
+    u.pairs.push_back(make_pair(9u, 1llu));
+    u.pairs.push_back(make_pair(3u, 2llu));
+    u.pairs.push_back(make_pair(9u, 3llu));
+
+    vector<uint8_t> f;
+
+    CHECK(u.serialize_to(f) > 0);
+
+    FlatIndex d;
+
+    CHECK(d << HOB::View(&f[0], f.size()));
+    CHECK(d.pairs.size() == 2);
+    CHECK(d.pairs.begin()->first == 3);
+    CHECK(d.pairs[9] == 3);
+    CHECK(d.pairs.find(9) != d.pairs.end());
+    CHECK(d.pairs.count(4) == 0);
+}
+
+int main()
+{
+    check_maps<OrderedIndex>(1000);
+    check_maps<FlatIndex   >(1000);
+    check_maps<HashedIndex >(1000);
+
+    check_wire();
+    check_shape();
+    check_flat();
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+/******************************************************************************
+//
+// Wire profile checks
+//
+// Checks that the ID of a HOBSTRUCT depends on the wire profile of its field
+// types (CONTIGUOUS_VECTORS), also when the vectors laid out contiguously
+// are held by other containers, so that peers built with the other profile
+// see it as an unknown HOB. Built once per profile.
+//
+// Usage:
+//
+//    ./check_contiguous
+//    ./check_contiguous_vectors
+//
+******************************************************************************/
+#include "check.h"
+
+#if defined(CONTIGUOUS_VECTORS)
+static const bool tagged = true;
+#else // !CONTIGUOUS_VECTORS
+static const bool tagged = false;
+#endif // !CONTIGUOUS_VECTORS
+
+typedef map<string, vector<float> >             FloatsByName;
+typedef HOB::flat_map<uint32_t, vector<double> > DoublesById;
+typedef unordered_map<uint32_t, vector<int8_t> > BytesById;
+typedef map<vector<uint8_t>, uint32_t>           IdsByBytes;
+typedef array<vector<uint8_t>, 2>                BytesPair;
+typedef map<uint32_t, uint64_t>                  Counters;
+
+HOBSTRUCT(Doubles, "FIELD",
+    (vector<double>, items)
+)
+
+HOBSTRUCT(OptionalDoubles, "FIELD",
+    (optional<vector<double> >, items)
+)
+
+HOBSTRUCT(VectorOfBytes, "FIELD",
+    (vector<vector<uint8_t> >, items)
+)
+
+HOBSTRUCT(SetOfBytes, "FIELD",
+    (set<vector<int8_t> >, items)
+)
+
+HOBSTRUCT(MapOfFloats, "FIELD",
+    (FloatsByName, items)
+)
+
+HOBSTRUCT(FlatMapOfDoubles, "FIELD",
+    (DoublesById, items)
+)
+
+HOBSTRUCT(HashedMapOfBytes, "FIELD",
+    (BytesById, items)
+)
+
+HOBSTRUCT(MapByBytes, "FIELD",
+    (IdsByBytes, items)
+)
+
+HOBSTRUCT(ArrayOfBytes, "FIELD",
+    (BytesPair, items)
+)
+
+HOBSTRUCT(OptionalVectorOfBytes, "FIELD",
+    (optional<vector<vector<uint8_t> > >, items)
+)
+
+// Not laid out contiguously in any profile
+
+HOBSTRUCT(VectorOfIds, "FIELD",
+    (vector<vector<uint32_t> >, items)
+)
+
+HOBSTRUCT(MapOfIds, "FIELD",
+    (Counters, items)
+)
+
+//
+// Reference implementation: the ID of a single field HOB, without the wire
+// profile
+//
+class Ref: public HOB
+{
+public:
+    Ref(const char *type) : HOB("FIELD")
+    {
+        update_id("name_"); update_id(type); update_id("items");
+
+        update_id(static_cast<const char *>(NULL));
+    }
+
+    const UID &id() const { return get_id(); }
+};
+
+template<class T>
+static void check_id(const char *type, bool t)
+{
+    CHECK((Ref(type).id() != T::ID()) == t);
+
+    // Frames round trip in either profile
+
+    T               v;
+    vector<uint8_t> b;
+
+    CHECK(v.serialize_to(b) > 0);
+    CHECK(v << HOB::View(&b[0], b.size()));
+}
+
+int main()
+{
+    check_id<Doubles              >("vector<double>"                      , tagged);
+    check_id<OptionalDoubles      >("optional<vector<double> >"           , tagged);
+    check_id<VectorOfBytes        >("vector<vector<uint8_t> >"            , tagged);
+    check_id<SetOfBytes           >("set<vector<int8_t> >"                , tagged);
+    check_id<MapOfFloats          >("FloatsByName"                        , tagged);
+    check_id<FlatMapOfDoubles     >("DoublesById"                         , tagged);
+    check_id<HashedMapOfBytes     >("BytesById"                           , tagged);
+    check_id<MapByBytes           >("IdsByBytes"                          , tagged);
+    check_id<ArrayOfBytes         >("BytesPair"                           , tagged);
+    check_id<OptionalVectorOfBytes>("optional<vector<vector<uint8_t> > >" , tagged);
+
+    check_id<VectorOfIds          >("vector<vector<uint32_t> >"           , false );
+    check_id<MapOfIds             >("Counters"                            , false );
+
+    return 0;
+}
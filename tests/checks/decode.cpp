@@ -0,0 +1,438 @@
+/******************************************************************************
+//
+// Steady state decoding checks
+//
+// Decodes the same kind of HOB over and over into one long lived object, from
+// memory (HOB::View) and from an istream (read_from()), and checks the
+// decoded values and that no heap allocation is done once the fields are
+// sized, and the changes detected in each change tracking mode. Nested HOB
+// fields are decoded in place: frames whose nested HOBs have another UID
+// must be rejected.
+//
+// Usage:
+//
+//    ./check_decode
+//
+******************************************************************************/
+#include <new>
+#include <string.h>
+#include <sstream>
+#include "check.h"
+
+static size_t allocations = 0;
+
+// Heap allocations counter
+
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(size_t sz) throw(std::bad_alloc)
+{
+    allocations++;
+
+    void *p = malloc((sz > 0) ? sz : 1);
+
+    if (NULL == p)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void *p) throw()
+{
+    free(p);
+}
+
+HOBSTRUCT(Leaf, "LEAF",
+    (uint32_t, id   , 0   )
+    (float   , value, 0.0f)
+)
+
+// Same fields, another UID
+
+HOBSTRUCT(Twig, "TWIG",
+    (uint32_t, id   , 0   )
+    (float   , value, 0.0f)
+)
+
+HOBSTRUCT(Branch, "BRANCH",
+    (Leaf          , first )
+    (optional<Leaf>, spare )
+    (vector<Leaf>  , leaves)
+)
+
+HOBSTRUCT(Tree, "TREE",
+    (Branch  , branch)
+    (uint64_t, stamp )
+)
+
+typedef map<uint8_t, string> Labels;
+
+#define RECORD_FIELDS                                                          \
+    (string          , name   )                                                \
+    (vector<string>  , tags   )                                                \
+    (vector<uint32_t>, ids    )                                                \
+    (vector<double>  , values )                                                \
+    (vector<int8_t>  , bytes  )                                                \
+    (Labels          , labels )                                                \
+    (optional<string>, comment)                                                \
+    (uint64_t        , stamp  )
+
+HOBSTRUCT(Record, "RECORD", RECORD_FIELDS)
+
+// The same fields, tracked the other ways
+
+TRACK_CHANGES(ReadRecord, TRACK_READS)
+
+HOBSTRUCT(ReadRecord, "RECORD", RECORD_FIELDS)
+
+TRACK_CHANGES(UntrackedRecord, TRACK_NONE)
+
+HOBSTRUCT(UntrackedRecord, "RECORD", RECORD_FIELDS)
+
+// Large containers
+
+typedef map<uint32_t, double> Points;
+
+#define SERIES_FIELDS                                                          \
+    (vector<double>, samples)                                                  \
+    (Points        , points )
+
+HOBSTRUCT(Series, "SERIES", SERIES_FIELDS)
+
+TRACK_CHANGES(ReadSeries, TRACK_READS)
+
+HOBSTRUCT(ReadSeries, "SERIES", SERIES_FIELDS)
+
+TRACK_CHANGES(UntrackedSeries, TRACK_NONE)
+
+HOBSTRUCT(UntrackedSeries, "SERIES", SERIES_FIELDS)
+
+template<class R>
+static void fill_series(R &r, size_t k)
+{
+    r.samples.resize(16384);
+
+    for (size_t i=0; i<r.samples.size(); i++)
+    {
+        r.samples[i] = static_cast<double>(i) * 0.25;
+    }
+
+    r.samples.back() += static_cast<double>(k);
+
+    r.points.clear();
+
+    for (uint32_t i=0; i<1024; i++)
+    {
+        r.points[i * 7] = static_cast<double>(i) * 0.5;
+    }
+
+    r.points[7 * 1023] += static_cast<double>(k);
+}
+
+static void fill(Series          &r, size_t k) { fill_series(r, k); }
+static void fill(ReadSeries      &r, size_t k) { fill_series(r, k); }
+static void fill(UntrackedSeries &r, size_t k) { fill_series(r, k); }
+
+static void fill(Tree &t, size_t k)
+{
+    t.stamp              = k;
+    t.branch.first.id    = static_cast<uint32_t>(k);
+    t.branch.first.value = 0.5f;
+    t.branch.spare       = Leaf();
+    t.branch.leaves.resize(16);
+
+    for (size_t i=0; i<t.branch.leaves.size(); i++)
+    {
+        t.branch.leaves[i].id    = static_cast<uint32_t>(k + i);
+        t.branch.leaves[i].value = static_cast<float>(i) * 0.25f;
+    }
+}
+
+template<class R>
+static void fill(R &r, size_t k)
+{
+    r.name    = (0 == k) ? "a name well past the short string size"
+                         : "another name past the short string size";
+    r.comment = string("a comment well past the short string size");
+    r.stamp   = k;
+
+    r.tags.assign(8, string("a tag well past the short string size"));
+    r.tags[k] = "just another tag past the short string size";
+
+    r.labels.clear();
+
+    r.ids.resize(300);
+    r.values.resize(64);
+    r.bytes.assign(48, static_cast<int8_t>(k));
+
+    for (size_t i=0; i<r.ids.size(); i++)
+    {
+        r.ids[i] = static_cast<uint32_t>((i * 977) + k);
+    }
+
+    for (size_t i=0; i<r.values.size(); i++)
+    {
+        r.values[i] = static_cast<double>(i + k) * 0.5;
+    }
+
+    for (uint8_t i=0; i<16; i++)
+    {
+        r.labels[i * 3] = (0 == k) ? "a label well past the short string size"
+                                   : "another label past the short string size";
+    }
+}
+
+// Decodes two alternating frames over and over into the same object
+//
+template<class T>
+static void check_steady(size_t count)
+{
+    T                        t;
+    vector<vector<uint8_t> > frames(2);
+    vector<T>                ref(2);
+
+    for (size_t i=0; i<frames.size(); i++)
+    {
+        fill(ref[i], i);
+
+        CHECK(ref[i].serialize_to(frames[i]) > 0);
+    }
+
+    T d;
+
+    // Warm up: the first decodes size the fields
+
+    for (size_t i=0; i<frames.size(); i++)
+    {
+        CHECK(d << HOB::View(&frames[i][0], frames[i].size()));
+        CHECK(d == ref[i]);
+    }
+
+    size_t a = allocations;
+
+    for (size_t i=0; i<count; i++)
+    {
+        const vector<uint8_t> &f = frames[i & 1];
+
+        CHECK(d << HOB::View(&f[0], f.size()));
+        CHECK(d == ref[i & 1]);
+    }
+
+    CHECK(allocations == a);
+
+    string s;
+
+    for (size_t i=0; i<count; i++)
+    {
+        const vector<uint8_t> &f = frames[i & 1];
+
+        s.append(reinterpret_cast<const char *>(&f[0]), f.size());
+    }
+
+    istringstream ss(s);
+
+    a = allocations;
+
+    for (size_t i=0; i<count; i++)
+    {
+        CHECK(d.read_from(ss) > 0);
+        CHECK(d == ref[i & 1]);
+    }
+
+    CHECK(allocations == a);
+}
+
+// What is changed on a new frame, and on the same frame again
+//
+template<class T>
+static void check_tracking(size_t count)
+{
+    T                        t;
+    vector<vector<uint8_t> > frames(2);
+
+    for (size_t i=0; i<frames.size(); i++)
+    {
+        fill(t, i);
+
+        CHECK(t.serialize_to(frames[i]) > 0);
+    }
+
+    bool changes = (HOB::TRACK_NONE  != HOB::Tracked<T>::mode);
+    bool same    = (HOB::TRACK_READS == HOB::Tracked<T>::mode);
+
+    T d;
+
+    for (size_t i=0; i<count; i++)
+    {
+        const vector<uint8_t> &f = frames[i & 1];
+
+        CHECK(d << HOB::View(&f[0], f.size()));
+        CHECK(changes == static_cast<bool>(d));
+
+        CHECK(d << HOB::View(&f[0], f.size()));
+        CHECK(same == static_cast<bool>(d));
+
+        string       s(reinterpret_cast<const char *>(&f[0]), f.size());
+        stringstream ss(s);
+
+        CHECK(d.read_from(ss) > 0);
+        CHECK(same == static_cast<bool>(d));
+    }
+
+    fill(t, 1);
+
+    CHECK(d == t);
+}
+
+// Decodes records of changing shapes into the same object: strings and
+// vectors growing and shrinking, map keys added and dropped, the optional
+// value set and cleared
+//
+static void check_shapes()
+{
+    vector<Record>           ref(4);
+    vector<vector<uint8_t> > frames(ref.size());
+
+    fill(ref[0], 0);
+    fill(ref[1], 1);
+
+    ref[2] = ref[1];
+    ref[2].name.clear();
+    ref[2].tags.resize(2);
+    ref[2].ids.resize(1000, 7);
+    ref[2].values.clear();
+    ref[2].bytes.resize(3);
+    ref[2].labels.erase(0);
+    ref[2].labels.erase(45);
+    ref[2].labels[1]   = "a new key";
+    ref[2].labels[255] = "a new last key";
+    ref[2].comment.reset();
+
+    ref[3].tags.assign(20, string("a tag well past the short string size"));
+
+    for (size_t i=0; i<ref.size(); i++)
+    {
+        CHECK(ref[i].serialize_to(frames[i]) > 0);
+    }
+
+    Record d;
+
+    for (size_t i=0; i<64; i++)
+    {
+        size_t k = (i * 7) % ref.size();
+
+        if (i & 1)
+        {
+            CHECK(d << HOB::View(&frames[k][0], frames[k].size()));
+        }
+        else
+        {
+            string       s(reinterpret_cast<const char *>(&frames[k][0]),
+                           frames[k].size());
+            stringstream ss(s);
+
+            CHECK(d.read_from(ss) > 0);
+        }
+
+        CHECK(d == ref[k]);
+    }
+}
+
+// Offset of the n-th occurrence of the UID of a nested HOB in frame
+//
+static size_t find(const vector<uint8_t> &frame, const vector<uint8_t> &uid,
+                   size_t n)
+{
+    for (size_t i=1; (i + uid.size()) <= frame.size(); i++)
+    {
+        if ((0 == memcmp(&frame[i], &uid[0], uid.size())) && (0 == n--))
+        {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+// UID bytes of a HOB, as written at the start of its frame, followed by
+// a payload size of 1 byte
+//
+template<class T>
+static vector<uint8_t> uid()
+{
+    T               t;
+    vector<uint8_t> f;
+
+    CHECK(t.serialize_to(f) > 0);
+
+    HOB::View v(&f[0], f.size());
+
+    CHECK(v.payload_size() < 128);
+
+    f.resize(static_cast<size_t>(v.payload() - &f[0]) - 1);
+
+    return f;
+}
+
+static void check_wrong_uid()
+{
+    Tree t;
+
+    fill(t, 7);
+
+    vector<uint8_t> frame;
+
+    CHECK(t.serialize_to(frame) > 0);
+
+    vector<uint8_t> leaf = uid<Leaf>();
+    vector<uint8_t> twig = uid<Twig>();
+
+    CHECK(leaf.size() == twig.size());
+    CHECK(leaf != twig);
+
+    // first, spare and the 16 leaves
+
+    size_t n = 0;
+
+    for (size_t at; 0 != (at = find(frame, leaf, n)); n++)
+    {
+        vector<uint8_t> bad(frame);
+
+        memcpy(&bad[at], &twig[0], twig.size());
+
+        Tree d;
+
+        CHECK(!(d << HOB::View(&bad[0], bad.size())));
+
+        string       s(reinterpret_cast<const char *>(&bad[0]), bad.size());
+        stringstream ss(s);
+
+        CHECK(d.read_from(ss) < 0);
+
+        // The long lived object decodes the next good frame
+
+        CHECK(d << HOB::View(&frame[0], frame.size()));
+        CHECK(d == t);
+    }
+
+    CHECK(18 == n);
+}
+
+int main()
+{
+    check_steady<Tree  >(1000);
+    check_steady<Record>(1000);
+    check_shapes();
+
+    check_tracking<Record         >(100);
+    check_tracking<ReadRecord     >(100);
+    check_tracking<UntrackedRecord>(100);
+    check_tracking<Series         >(10);
+    check_tracking<ReadSeries     >(10);
+    check_tracking<UntrackedSeries>(10);
+    check_wrong_uid();
+
+    return 0;
+}
@@ -0,0 +1,396 @@
+/******************************************************************************
+//
+// Delta frames checks
+//
+// Replicates a state through delta frames of the fields changed, with a
+// snapshot every few frames, and checks that the replica follows the state
+// with only the fields in each frame changed, that a lost frame is detected
+// and no partial frame applied until a snapshot (periodic or asked with
+// resync()) brings the replica back in sync, that a replica joining late
+// waits for a snapshot, that the delta frames are read from a stream among
+// other frames, and that fields named as the parameters of the generated
+// members are sent as they are.
+//
+// Usage:
+//
+//    ./check_delta
+//
+******************************************************************************/
+#include <sstream>
+#include "check.h"
+
+typedef map<uint8_t, string> Labels;
+
+HOBSTRUCT(State, "STATE",
+    (string          , name   )
+    (uint32_t        , id     )
+    (double          , x      )
+    (double          , y      )
+    (float           , battery)
+    (bool            , armed  )
+    (vector<uint32_t>, route  )
+    (Labels          , labels )
+    (optional<string>, comment)
+    (uint64_t        , stamp  )
+)
+
+// Fields named as the parameters of the generated members
+
+HOBSTRUCT(Names, "NAMES",
+    (uint64_t, seq  )
+    (uint32_t, d    )
+    (string  , sizes)
+)
+
+static void fill(State &s)
+{
+    s.name    = "a vehicle name well past the short string size";
+    s.id      = 7;
+    s.x       = 0.0;
+    s.y       = 0.0;
+    s.battery = 0.8f;
+    s.armed   = true;
+    s.stamp   = 0;
+
+    s.route.resize(32);
+
+    for (size_t i=0; i<s.route.size(); i++)
+    {
+        s.route[i] = static_cast<uint32_t>(i * 977);
+    }
+
+    for (uint8_t i=0; i<8; i++)
+    {
+        s.labels[i] = "a label well past the short string size";
+    }
+
+    ~s;
+}
+
+// Sets the field i % 8 to a value drawn from r
+//
+static void set_field(State &s, size_t i, uint64_t r)
+{
+    string s_(static_cast<size_t>(r % 100), static_cast<char>('a' + r % 26));
+
+    switch (i % 8)
+    {
+        case 0:
+            s.set_name(s_);
+            break;
+        case 1:
+            s.set_x(static_cast<double>(r % 1000));
+            break;
+        case 2:
+            s.set_y(-static_cast<double>(r % 1000));
+            break;
+        case 3:
+            s.set_armed(r & 1);
+            break;
+        case 4:
+            s.route.resize(r % 64, 3);
+            s.touch(State::_route);
+            break;
+        case 5:
+            s.labels[static_cast<uint8_t>(r)] = s_;
+            s.touch(State::_labels);
+            break;
+        case 6:
+            s.set_comment((r & 1) ? optional<string>(s_) : optional<string>());
+            break;
+        default:
+            s.set_stamp(r);
+            break;
+    }
+}
+
+// Writes the next delta frame of s
+//
+static void send(HOB::DeltaWriter &w, State &s, vector<uint8_t> &f)
+{
+    f.clear();
+
+    CHECK(w.write(s, f) == f.size());
+    CHECK(f.size() > 0);
+}
+
+static bool apply(HOB::DeltaReader &r, State &d, const vector<uint8_t> &f)
+{
+    return r.read(d, HOB::View(&f[0], f.size()));
+}
+
+// The replica follows, every frame holding the fields changed only
+//
+static void check_follow()
+{
+    State            s;
+    State            d;
+    HOB::DeltaWriter w(10);
+    HOB::DeltaReader r;
+    vector<uint8_t>  f;
+    size_t           snapshot = 0;
+
+    fill(s);
+
+    CHECK(!r.synced());
+
+    for (size_t i=0; i<200; i++)
+    {
+        uint64_t q = w.sequence();
+
+        set_field(s, i, check_random());
+
+        if (i & 1)
+        {
+            set_field(s, i + 3, check_random());
+        }
+
+        send(w, s, f);
+
+        CHECK(w.sequence() == (q + 1));
+        CHECK(!s);
+
+        if (0 == q)
+        {
+            snapshot = f.size();
+        }
+
+        CHECK(apply(r, d, f));
+        CHECK(r.synced());
+        CHECK(d == s);
+
+        // Partial frames change the fields they hold only
+
+        if (0 != (q % 10))
+        {
+            bool stamp = (7 == (i % 8)) || ((i & 1) && (7 == ((i + 3) % 8)));
+
+            CHECK(!(d & State::_id));
+            CHECK(static_cast<bool>(d & State::_stamp) == stamp);
+        }
+    }
+
+    // Nothing changed: a frame of no field, the replica unchanged
+
+    while (0 == (w.sequence() % 10))
+    {
+        send(w, s, f);
+
+        CHECK(apply(r, d, f));
+    }
+
+    send(w, s, f);
+
+    CHECK(f.size() < snapshot);
+    CHECK(apply(r, d, f));
+    CHECK(r.synced() && (d == s) && !d);
+}
+
+// A lost frame: out of sync up to the next snapshot
+//
+static void check_lost(size_t every)
+{
+    State            s;
+    State            d;
+    HOB::DeltaWriter w(every);
+    HOB::DeltaReader r;
+    vector<uint8_t>  f;
+
+    fill(s);
+
+    for (size_t i=0; i<5; i++)
+    {
+        set_field(s, i, check_random());
+        send(w, s, f);
+
+        CHECK(apply(r, d, f));
+    }
+
+    set_field(s, 1, check_random());
+    send(w, s, f);
+
+    // Lost, the partial frames that follow are not applied
+
+    for (size_t i=0; (0 == every) ? (i < 20) : (0 != (w.sequence() % every));
+         i++)
+    {
+        State k(d);
+
+        set_field(s, i, check_random());
+        send(w, s, f);
+
+        CHECK(!apply(r, d, f));
+        CHECK(!r.synced());
+        CHECK(d == k);
+    }
+
+    // Snapshot: asked for, or the periodic one
+
+    if (0 == every)
+    {
+        w.resync();
+    }
+
+    set_field(s, 2, check_random());
+    send(w, s, f);
+
+    CHECK(apply(r, d, f));
+    CHECK(r.synced() && (d == s));
+
+    set_field(s, 3, check_random());
+    send(w, s, f);
+
+    CHECK(apply(r, d, f));
+    CHECK(r.synced() && (d == s));
+
+    // The same frame again is out of sequence
+
+    CHECK(!apply(r, d, f));
+    CHECK(!r.synced());
+}
+
+// A replica joining late waits for the next snapshot
+//
+static void check_late()
+{
+    State            s;
+    State            d;
+    HOB::DeltaWriter w(8);
+    HOB::DeltaReader r;
+    vector<uint8_t>  f;
+
+    fill(s);
+
+    for (size_t i=0; i<3; i++)
+    {
+        set_field(s, i, check_random());
+        send(w, s, f);
+    }
+
+    while (0 != (w.sequence() % 8))
+    {
+        set_field(s, 1, check_random());
+        send(w, s, f);
+
+        CHECK(!apply(r, d, f));
+        CHECK(!r.synced());
+    }
+
+    send(w, s, f);
+
+    CHECK(apply(r, d, f));
+    CHECK(r.synced() && (d == s));
+
+    // Whole frames are not delta frames
+
+    vector<uint8_t> g;
+
+    CHECK(s.serialize_to(g) > 0);
+    CHECK(!apply(r, d, g));
+}
+
+// From a stream, among other frames
+//
+static void check_stream()
+{
+    State            s;
+    State            d;
+    HOB::DeltaWriter w(4);
+    HOB::DeltaReader r;
+    stringstream     ss;
+
+    fill(s);
+
+    for (size_t i=0; i<20; i++)
+    {
+        set_field(s, i, check_random());
+
+        CHECK(w.write(s, ss));
+        CHECK(s >> ss);
+    }
+
+    for (size_t i=0; i<20; i++)
+    {
+        CHECK(r.read(d, ss) > 0);
+        CHECK(0 == r.read(d, ss));
+        CHECK(r.synced());
+    }
+
+    CHECK(d == s);
+    CHECK(r.read(d, ss) < 0);
+
+    // A lost frame: the ones that follow are skipped, up to the snapshot
+
+    stringstream ls;
+    size_t       n = 0;
+    int          k;
+
+    set_field(s, 1, check_random());
+
+    CHECK(w.write(s, ls));
+
+    ls.str(string());
+
+    for (size_t i=0; i<4; i++)
+    {
+        set_field(s, i, check_random());
+
+        CHECK(w.write(s, ls));
+        CHECK(s >> ls);
+    }
+
+    while ((k = r.read(d, ls)) >= 0)
+    {
+        n += static_cast<size_t>(k);
+    }
+
+    CHECK(1 == n);
+    CHECK(r.synced() && (d == s));
+}
+
+static void check_names()
+{
+    Names            s;
+    Names            r;
+    HOB::DeltaWriter w;
+    HOB::DeltaReader dr;
+    vector<uint8_t>  f;
+
+    s.set_seq(42);
+    s.set_d(7);
+    s.set_sizes("sizes");
+
+    for (uint64_t i=0; i<3; i++)
+    {
+        f.clear();
+
+        CHECK(w.write(s, f) > 0);
+        CHECK(dr.read(r, HOB::View(&f[0], f.size())));
+        CHECK(r == s);
+        CHECK((r.seq == (42 + i)) && (7 == r.d));
+        CHECK("sizes" == r.sizes);
+
+        s.set_seq(s.seq + 1);
+    }
+
+    stringstream ss;
+
+    w.resync();
+    s.set_d(8);
+
+    CHECK(w.write(s, ss));
+    CHECK(dr.read(r, ss) > 0);
+    CHECK((r == s) && (45 == r.seq) && (8 == r.d));
+}
+
+int main()
+{
+    check_follow();
+    check_lost(0);
+    check_lost(16);
+    check_late();
+    check_stream();
+    check_names();
+
+    return 0;
+}
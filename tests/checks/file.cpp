@@ -0,0 +1,240 @@
+/******************************************************************************
+//
+// Log reading checks
+//
+// Writes a log of HOBs, then reads it back the usual way (generic HOB first,
+// then the typed one) and in a single pass (HOB::read_one_of(), read_from()),
+// from a file and from a stream that can't be sought, and checks that every
+// HOB is decoded with the very same values.
+//
+// Usage:
+//
+//    ./check_file [path]
+//
+******************************************************************************/
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include "check.h"
+
+HOBSTRUCT(Sample, "SAMPLE",
+    (uint64_t, stamp  )
+    (uint32_t, channel)
+    (double  , value  )
+    (string  , unit   )
+)
+
+HOBSTRUCT(Event, "EVENT",
+    (uint64_t, stamp)
+    (string  , text )
+)
+
+//
+// Stream buffer handing out a few bytes at time, that can't be sought, as
+// pipes and sockets
+//
+class PipeBuf: public streambuf
+{
+public:
+    PipeBuf(const string &s): _s(s), _p(0) {}
+
+protected:
+    virtual int_type underflow()
+    {
+        if (_p >= _s.size())
+        {
+            return traits_type::eof();
+        }
+
+        size_t n = ((_s.size() - _p) < 5) ? (_s.size() - _p) : 5;
+
+        char *b = const_cast<char *>(_s.data()) + _p;
+
+        setg(b, b, b + n);
+
+        _p += n;
+
+        return traits_type::to_int_type(*b);
+    }
+
+    virtual pos_type seekoff(off_type, ios_base::seekdir, ios_base::openmode)
+    {
+        return pos_type(off_type(-1));
+    }
+
+    virtual pos_type seekpos(pos_type, ios_base::openmode)
+    {
+        return pos_type(off_type(-1));
+    }
+
+private:
+    string _s;
+    size_t _p;
+};
+
+static double value(size_t i)
+{
+    return static_cast<double>(i % 1000) * 0.125;
+}
+
+static void write_log(ostream &os, size_t count)
+{
+    Sample s;
+    Event  e;
+
+    s.unit = "degC";
+    e.text = "threshold crossed";
+
+    for (size_t i=0; i<count; i++)
+    {
+        s.stamp   = i;
+        s.channel = static_cast<uint32_t>(i % 16);
+        s.value   = value(i);
+
+        CHECK(s >> os);
+
+        if (0 == (i % 10))
+        {
+            e.stamp = i;
+
+            CHECK(e >> os);
+        }
+    }
+}
+
+static void check_sample(const Sample &s, size_t i)
+{
+    CHECK(s.stamp   == i);
+    CHECK(s.channel == (i % 16));
+    CHECK(s.value   == value(i));
+    CHECK(s.unit    == "degC");
+}
+
+static void check_event(const Event &e, size_t i)
+{
+    CHECK(e.stamp == (i * 10));
+    CHECK(e.text  == "threshold crossed");
+}
+
+static void check_generic(istream &is, size_t count)
+{
+    Sample s;
+    Event  e;
+    HOB    h;
+    size_t samples = 0;
+    size_t events  = 0;
+
+    while (h << is)
+    {
+        if (s << h)
+        {
+            check_sample(s, samples++);
+        }
+        else
+        if (e << h)
+        {
+            check_event(e, events++);
+        }
+        else
+        {
+            CHECK(false);
+        }
+    }
+
+    CHECK(samples == count);
+    CHECK(events  == ((count + 9) / 10));
+}
+
+static void check_one_of(istream &is, size_t count)
+{
+    Sample   s;
+    Event    e;
+    HOB     *hobs[] = { &s, &e };
+    size_t   samples = 0;
+    size_t   events  = 0;
+    ssize_t  i;
+
+    while ((i = HOB::read_one_of(is, hobs)) >= 0)
+    {
+        CHECK(i < 2);
+
+        if (0 == i)
+        {
+            check_sample(s, samples++);
+        }
+        else
+        {
+            check_event(e, events++);
+        }
+    }
+
+    CHECK(samples == count);
+    CHECK(events  == ((count + 9) / 10));
+}
+
+// Events are skipped
+
+static void check_read_from(istream &is, size_t count)
+{
+    Sample s;
+    size_t samples = 0;
+    int    r;
+
+    while ((r = s.read_from(is)) >= 0)
+    {
+        if (r > 0)
+        {
+            check_sample(s, samples++);
+        }
+    }
+
+    CHECK(is.eof());
+
+    CHECK(samples == count);
+}
+
+static void check_stream(void (*read)(istream &, size_t), size_t count)
+{
+    stringstream ss;
+
+    write_log(ss, count);
+
+    PipeBuf pb(ss.str());
+    istream ps(&pb);
+
+    read(ps, count);
+}
+
+static void check_file(void (*read)(istream &, size_t), size_t count,
+                       const char *path)
+{
+    {
+        ofstream os(path, ios::binary);
+
+        write_log(os, count);
+    }
+
+    ifstream is(path, ios::binary);
+
+    read(is, count);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = (argc > 1) ? argv[1] : "check_file.dat";
+
+    for (size_t n=0; n<=1000; n+=(n < 20) ? 1 : 490)
+    {
+        check_stream(check_generic  , n);
+        check_stream(check_one_of   , n);
+        check_stream(check_read_from, n);
+    }
+
+    check_file(check_generic  , 10000, path);
+    check_file(check_one_of   , 10000, path);
+    check_file(check_read_from, 10000, path);
+
+    remove(path);
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+/******************************************************************************
+//
+// FIXED32 encoding hint checks
+//
+// Checks that the fields hinted FIXED32 take 4 bytes and round trip for the
+// types of 32 bits at most (integers and float). Built with FIXED32_WIDE set
+// to a wider type (int64_t, double), it must not compile: such fields would
+// be truncated.
+//
+// Usage:
+//
+//    ./check_fixed32
+//
+******************************************************************************/
+#include "check.h"
+
+#if defined(FIXED32_WIDE)
+
+HOBSTRUCT(Wide, "WIDE",
+    (FIXED32_WIDE, value, 0, FIXED32)
+)
+
+int main()
+{
+    Wide            w;
+    vector<uint8_t> f;
+
+    return (w.serialize_to(f) > 0) ? 0 : 1;
+}
+
+#else // !FIXED32_WIDE
+
+HOBSTRUCT(Fixed, "FIXED",
+    (int32_t , i32, 0   , FIXED32)
+    (uint32_t, u32, 0   , FIXED32)
+    (int16_t , i16, 0   , FIXED32)
+    (uint8_t , u8 , 0   , FIXED32)
+    (float   , f32, 0.0f, FIXED32)
+)
+
+static void check_fixed(int32_t i32, uint32_t u32, int16_t i16, uint8_t u8,
+                        float f32)
+{
+    Fixed t;
+
+    t.i32 = i32;
+    t.u32 = u32;
+    t.i16 = i16;
+    t.u8  = u8;
+    t.f32 = f32;
+
+    vector<uint8_t> f;
+
+    CHECK(t.serialize_to(f) > 0);
+
+    HOB::View v(&f[0], f.size());
+
+    CHECK(v.payload_size() == 5 * sizeof(uint32_t));
+
+    Fixed d;
+
+    CHECK(d << v);
+    CHECK(d == t);
+}
+
+int main()
+{
+    check_fixed(0, 0, 0, 0, 0.0f);
+    check_fixed(-1, 0xffffffff, -1, 0xff, -1.5f);
+    check_fixed(-2147483647 - 1, 0x80000000, -32768, 0x80, 3.4e38f);
+    check_fixed(2147483647, 0x7fffffff, 32767, 0x7f, 1.0e-38f);
+
+    return 0;
+}
+
+#endif // !FIXED32_WIDE
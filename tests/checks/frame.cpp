@@ -0,0 +1,358 @@
+/******************************************************************************
+//
+// HOB::Frame checks
+//
+// Checks that copies of a frame share its payload, that frames keep their
+// payload across the following reads and are written as read, that a
+// stream of HOBs read into owned frames on the main thread, queued and
+// decoded on worker threads, gives every HOB with the very same values it
+// was written with, and that copies of one frame taken and dropped by many
+// threads at once keep its payload. Built as C++98 and as C++11, for both
+// reference counts.
+//
+// Usage:
+//
+//    ./check_frame
+//
+******************************************************************************/
+#include <pthread.h>
+#include <sstream>
+#include <vector>
+#include "check.h"
+
+HOBSTRUCT(Sample, "SAMPLE",
+    (uint64_t        , stamp  )
+    (uint32_t        , channel)
+    (vector<double>  , values )
+    (string          , unit   )
+)
+
+// Frames are handed to the workers in chunks, through a mutex protected queue
+//
+class Queue
+{
+public:
+    Queue()
+        : _closed(false)
+    {
+        pthread_mutex_init(&_m, NULL);
+        pthread_cond_init (&_c, NULL);
+    }
+
+    ~Queue()
+    {
+        pthread_cond_destroy (&_c);
+        pthread_mutex_destroy(&_m);
+    }
+
+    void push(const vector<HOB::Frame> &chunk)
+    {
+        pthread_mutex_lock(&_m);
+
+        _q.push_back(chunk);
+
+        pthread_cond_signal(&_c);
+        pthread_mutex_unlock(&_m);
+    }
+
+    void close()
+    {
+        pthread_mutex_lock(&_m);
+
+        _closed = true;
+
+        pthread_cond_broadcast(&_c);
+        pthread_mutex_unlock(&_m);
+    }
+
+    bool pop(vector<HOB::Frame> &chunk)
+    {
+        pthread_mutex_lock(&_m);
+
+        while (_q.empty() && !_closed)
+        {
+            pthread_cond_wait(&_c, &_m);
+        }
+
+        bool rv = !_q.empty();
+
+        if (rv)
+        {
+            chunk.swap(_q.back());
+
+            _q.pop_back();
+        }
+
+        pthread_mutex_unlock(&_m);
+
+        return rv;
+    }
+
+private:
+    pthread_mutex_t             _m;
+    pthread_cond_t              _c;
+    vector<vector<HOB::Frame> > _q;
+    bool                        _closed;
+};
+
+static double value(uint64_t i)
+{
+    return static_cast<double>(i % 1000) * 0.5;
+}
+
+struct Worker
+{
+    Queue    *queue;
+    size_t    decoded;
+    uint64_t  stamps;   // sum of the decoded stamps
+    bool      ok;
+};
+
+static void *work(void *arg)
+{
+    Worker            &w = *static_cast<Worker *>(arg);
+    Sample             s;
+    vector<HOB::Frame> chunk;
+
+    while (w.queue->pop(chunk))
+    {
+        for (size_t i=0; i<chunk.size(); i++)
+        {
+            if (!(s << chunk[i]))
+            {
+                w.ok = false;
+
+                continue;
+            }
+
+            w.ok = w.ok
+                   &&
+                   (s.channel == (s.stamp % 16))
+                   &&
+                   (s.values == vector<double>(8, value(s.stamp)))
+                   &&
+                   (s.unit == "degC");
+
+            w.stamps += s.stamp;
+
+            w.decoded++;
+        }
+
+        chunk.clear();
+    }
+
+    return NULL;
+}
+
+static string write_log(size_t count)
+{
+    stringstream ss;
+    Sample       s;
+
+    s.unit = "degC";
+
+    for (size_t i=0; i<count; i++)
+    {
+        s.stamp   = i;
+        s.channel = static_cast<uint32_t>(i % 16);
+        s.values.assign(8, value(i));
+
+        CHECK(s >> ss);
+    }
+
+    return ss.str();
+}
+
+static void check_frames()
+{
+    string       wire = write_log(16);
+    stringstream is(wire);
+    Sample       s;
+    HOB::Frame   f;
+
+    CHECK(f.empty());
+    CHECK(f << is);
+    CHECK(!f.empty());
+
+    // Copies of one frame share the payload
+
+    HOB::Frame c(f);
+    HOB::Frame a;
+
+    a = c;
+
+    CHECK(c.payload() == f.payload());
+    CHECK(a.payload() == f.payload());
+
+    // Frames keep their payload across the following reads
+
+    HOB::Frame g(f);
+
+    CHECK(f << is);
+    CHECK(g.payload() != f.payload());
+    CHECK(a.payload() == g.payload());
+    CHECK((s << g) && (0 == s.stamp));
+    CHECK((s << f) && (1 == s.stamp));
+
+    // Frames are written as read
+
+    stringstream os;
+
+    CHECK(g >> os);
+
+    size_t first = os.str().size();
+
+    CHECK(f >> os);
+    CHECK(os.str() == wire.substr(0, os.str().size()));
+
+    // Generic HOBs take a copy of any frame
+
+    HOB any;
+
+    CHECK((any << g) && (any == s));
+    CHECK(any >> s);
+    CHECK(0 == s.stamp);
+
+    // Read to the end, then past it
+
+    size_t n = 2;
+
+    while (f << is)
+    {
+        CHECK((s << f) && (n == s.stamp));
+
+        n++;
+    }
+
+    CHECK(16 == n);
+    CHECK((s << g) && (0 == s.stamp));
+
+    // Truncated streams give no frame
+
+    for (size_t l=0; l<first; l++)
+    {
+        stringstream ts(wire.substr(0, l));
+        HOB::Frame   t;
+
+        CHECK(!(t << ts));
+    }
+}
+
+static void check_workers(size_t count, size_t workers)
+{
+    string            wire = write_log(count);
+    Queue             queue;
+    vector<Worker>    w(workers);
+    vector<pthread_t> th(workers);
+
+    for (size_t i=0; i<workers; i++)
+    {
+        w[i].queue   = &queue;
+        w[i].decoded = 0;
+        w[i].stamps  = 0;
+        w[i].ok      = true;
+
+        CHECK(0 == pthread_create(&th[i], NULL, work, &w[i]));
+    }
+
+    stringstream       is(wire);
+    HOB::Frame         f;
+    vector<HOB::Frame> chunk;
+
+    while (f << is)
+    {
+        chunk.push_back(f);
+
+        if (chunk.size() == 256)
+        {
+            queue.push(chunk);
+
+            chunk.clear();
+        }
+    }
+
+    queue.push(chunk);
+    queue.close();
+
+    size_t   decoded = 0;
+    uint64_t stamps  = 0;
+
+    for (size_t i=0; i<workers; i++)
+    {
+        CHECK(0 == pthread_join(th[i], NULL));
+        CHECK(w[i].ok);
+
+        decoded += w[i].decoded;
+        stamps  += w[i].stamps;
+    }
+
+    CHECK(decoded == count);
+    CHECK(stamps  == (static_cast<uint64_t>(count) * (count - 1)) / 2);
+}
+
+struct Sharer
+{
+    const HOB::Frame *frame;
+    size_t            copies;
+    bool              ok;
+};
+
+static void *share(void *arg)
+{
+    Sharer            &w = *static_cast<Sharer *>(arg);
+    Sample             s;
+    vector<HOB::Frame> held(16);
+
+    for (size_t i=0; i<w.copies; i++)
+    {
+        HOB::Frame c(*w.frame);
+
+        held[i % held.size()] = c;
+    }
+
+    w.ok = (s << held[0]) && (s.unit == "degC");
+
+    return NULL;
+}
+
+static void check_shared(size_t copies, size_t workers)
+{
+    string            wire = write_log(1);
+    stringstream      is(wire);
+    HOB::Frame        f;
+    vector<Sharer>    w(workers);
+    vector<pthread_t> th(workers);
+
+    CHECK(f << is);
+
+    for (size_t i=0; i<workers; i++)
+    {
+        w[i].frame  = &f;
+        w[i].copies = copies;
+        w[i].ok     = false;
+
+        CHECK(0 == pthread_create(&th[i], NULL, share, &w[i]));
+    }
+
+    for (size_t i=0; i<workers; i++)
+    {
+        CHECK(0 == pthread_join(th[i], NULL));
+        CHECK(w[i].ok);
+    }
+
+    // The copies are gone, the frame is still there, as read
+
+    stringstream os;
+
+    CHECK(f >> os);
+    CHECK(os.str() == wire);
+}
+
+int main()
+{
+    check_frames();
+    check_workers(100000, 4);
+    check_shared(1000000, 4);
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+/******************************************************************************
+//
+// Content hash checks
+//
+// Checks that equal records hash the same, also with their unordered map
+// pairs inserted in another order and as read back, that any field, nested
+// ones too, and the seed change the hash, and that records dedup exactly
+// through an unordered_map keyed by HOB::HashedKey<>.
+//
+// Usage:
+//
+//    ./check_hash
+//
+******************************************************************************/
+#include "check.h"
+
+typedef map<uint8_t, string>            Labels;
+typedef unordered_map<uint32_t, double> Weights;
+
+HOBSTRUCT(Origin, "ORIGIN",
+    (string  , host)
+    (uint32_t, pid )
+)
+
+HOBSTRUCT(Record, "RECORD",
+    (Origin          , origin )
+    (string          , name   )
+    (vector<string>  , tags   )
+    (vector<uint32_t>, ids    )
+    (vector<double>  , values )
+    (Labels          , labels )
+    (Weights         , weights)
+    (uint64_t        , stamp  )
+)
+
+typedef HOB::HashedKey<Record> Key;
+
+static void fill(Record &r, size_t k)
+{
+    r.origin.host = "a host name well past the short string size";
+    r.origin.pid  = 1234;
+    r.name        = "a name well past the short string size";
+    r.stamp       = k;
+
+    r.tags.assign(8, string("a tag well past the short string size"));
+    r.ids.resize(300);
+    r.values.resize(64);
+
+    for (size_t i=0; i<r.ids.size(); i++)
+    {
+        r.ids[i] = static_cast<uint32_t>(i * 977);
+    }
+
+    for (size_t i=0; i<r.values.size(); i++)
+    {
+        r.values[i] = static_cast<double>(i) * 0.5;
+    }
+
+    for (uint8_t i=0; i<16; i++)
+    {
+        r.labels[i * 3] = "a label well past the short string size";
+    }
+
+    for (uint32_t i=0; i<16; i++)
+    {
+        r.weights[i * 5] = static_cast<double>(i);
+    }
+}
+
+static void check_equal()
+{
+    Record a;
+    Record b;
+
+    fill(a, 0);
+    fill(b, 0);
+
+    // The same pairs, inserted the other way round
+
+    b.weights.clear();
+
+    for (uint32_t i=16; i>0; i--)
+    {
+        b.weights[(i - 1) * 5] = static_cast<double>(i - 1);
+    }
+
+    CHECK(a == b);
+    CHECK(a.content_hash() == b.content_hash());
+    CHECK(a.content_hash(1) != a.content_hash(2));
+    CHECK(a.content_hash(1) == b.content_hash(1));
+
+    // Any field, nested ones too, changes the hash
+
+    uint64_t h = a.content_hash();
+
+    b.origin.pid++;
+
+    CHECK(b.content_hash() != h);
+
+    b.origin.pid--;
+    b.origin.host += "x";
+
+    CHECK(b.content_hash() != h);
+
+    b.origin.host.erase(b.origin.host.size() - 1);
+    b.values[63] += 1.0;
+
+    CHECK(b.content_hash() != h);
+
+    b.values[63] -= 1.0;
+    b.weights[5] += 1.0;
+
+    CHECK(b.content_hash() != h);
+
+    b.weights[5] -= 1.0;
+    b.labels[0] += "x";
+
+    CHECK(b.content_hash() != h);
+
+    b.labels[0].erase(b.labels[0].size() - 1);
+    b.stamp = 1;
+
+    CHECK(b.content_hash() != h);
+
+    b.stamp = 0;
+
+    CHECK(b.content_hash() == h);
+
+    // As read back
+
+    vector<uint8_t> f;
+
+    CHECK(a.serialize_to(f) > 0);
+
+    Record d;
+
+    CHECK(d << HOB::View(&f[0], f.size()));
+    CHECK(d.content_hash() == h);
+}
+
+static void check_keys()
+{
+    Record a;
+    Record b;
+
+    fill(a, 0);
+    fill(b, 1);
+
+    Key ka(a);
+    Key kb(b);
+    Key kc(a);
+
+    CHECK(ka.content_hash() == a.content_hash());
+    CHECK(ka == kc);
+    CHECK(ka != kb);
+    CHECK(ka.value() == a);
+
+    // Dedup of a stream of records, 1 out of 16 new
+
+    unordered_map<Key, size_t, HOB::ContentHash> seen;
+
+    size_t n = 10000;
+    size_t d = 0;
+
+    for (size_t i=0; i<n; i++)
+    {
+        a.stamp = ((0 == (i & 0xf)) ? 0x10 + i : (i & 0xf));
+
+        if (1 == ++seen[Key(a)])
+        {
+            d++;
+        }
+    }
+
+    // Stamps 1 to 15, and one new stamp every 16 records
+
+    CHECK(d == seen.size());
+    CHECK(d == (15 + (n + 15) / 16));
+
+    a.stamp = 0x10;
+
+    CHECK(1 == seen[Key(a)]);
+
+    a.stamp = 7;
+
+    CHECK(((n + 8) / 16) == seen[Key(a)]);
+}
+
+int main()
+{
+    check_equal();
+    check_keys();
+
+    return 0;
+}
@@ -0,0 +1,281 @@
+/******************************************************************************
+//
+// HOBSTRUCT::Lazy checks
+//
+// Checks that every lazy accessor of a frame held in memory returns the very
+// same value of the full decoding, that truncated payloads and frames of
+// another type are not valid, that the accessors then never read past the
+// end of the span, and that a HOBSTRUCT named as a HOB nested type, of
+// fields named as HOB members, has its Lazy accessors too.
+//
+// Usage:
+//
+//    ./check_lazy
+//
+******************************************************************************/
+#include <string.h>
+#include <sstream>
+#include <vector>
+#include "check.h"
+#include "../hobs.h"
+
+class Codec: public HOB
+{
+public:
+    static bool header(ostream &os, const UID &id, size_t sz)
+    {
+        return HOB::_w(os, id) && HOB::_w(os, sz);
+    }
+};
+
+// Named as a HOB nested type, of fields named as HOB members
+
+HOBSTRUCT(Frame, "FRAME",
+    (uint32_t, x)
+    (string  , d)
+    (double  , k)
+)
+
+static void fill(NumericMessage &m)
+{
+    m.valid = true;
+    m.bytes.assign(32, -3);
+    m.levels.assign(16, 0.5);
+    m.opt_param = string("optional");
+    m.numbers.assign(8, 2.5f);
+    m.names.assign(4, string("name"));
+
+    for (size_t i=0; i<16; i++)
+    {
+        MyStruct s;
+
+        s.anEnum = static_cast<uint32_t>(i);
+        s.aChar  = static_cast<uint8_t>('A' + i);
+
+        m.structs.push_back(s);
+    }
+
+    m.opt_struct = m.structs[3];
+
+    for (size_t i=0; i<256; i++)
+    {
+        m.ids.push_back(1000 + 3 * static_cast<uint32_t>(i));
+        m.samples.push_back(20.0 + static_cast<double>(i % 7) * 0.25);
+        m.history.push_back(static_cast<uint32_t>(check_random() & 0xffff));
+    }
+
+    m.counters.assign(64, -2);
+    m.states.assign(64, 1);
+    m.readings.assign(32, 1.5f);
+    m.trace.assign(32, 0.125);
+    m.stamp  = 0x0123456789abcdefllu;
+    m.offset = -7;
+    m.level  = 12;
+    m.shift  = 5;
+    m.ratio  = 0.75;
+}
+
+static void fill(ComplexStruct &m)
+{
+    for (size_t i=0; i<m.bits.size(); i++)
+    {
+        m.bits.set(i, (i % 3) == 0);
+    }
+
+    m.var_bits.assign(100, true);
+    m.iperbits.assign(5, FlagsT(5));
+    m.root.aMap[1] = "one";
+    m.root.aMap[2] = "two";
+    m.root.dat.aFloat = 2.5f;
+}
+
+static void fill(AnotherStruct &m)
+{
+    m.smin = -300;
+    m.lmax = 1234567890123ll;
+    m.bar  = 2.5;
+    m.aMap[0] = "zero";
+    m.aMap[1] = "one";
+    m.dat.aChar = 'Z';
+}
+
+// Accessed in reverse order, to exercise the offsets index
+
+static bool check(NumericMessage::Lazy &l, const NumericMessage &m)
+{
+    return (l.trace()      == m.trace     )
+           &&
+           (l.history()    == m.history   )
+           &&
+           (l.ratio()      == m.ratio     )
+           &&
+           (l.shift()      == m.shift     )
+           &&
+           (l.level()      == m.level     )
+           &&
+           (l.offset()     == m.offset    )
+           &&
+           (l.stamp()      == m.stamp     )
+           &&
+           (l.readings()   == m.readings  )
+           &&
+           (l.samples()    == m.samples   )
+           &&
+           (l.states()     == m.states    )
+           &&
+           (l.counters()   == m.counters  )
+           &&
+           (l.ids()        == m.ids       )
+           &&
+           (l.structs()    == m.structs   )
+           &&
+           (l.names()      == m.names     )
+           &&
+           (l.numbers()    == m.numbers   )
+           &&
+           (l.opt_struct() == m.opt_struct)
+           &&
+           (l.opt_param()  == m.opt_param )
+           &&
+           (l.levels()     == m.levels    )
+           &&
+           (l.bytes()      == m.bytes     )
+           &&
+           (l.text()       == m.text      )
+           &&
+           (l.valid()      == m.valid     );
+}
+
+static bool check(ComplexStruct::Lazy &l, const ComplexStruct &m)
+{
+    return (l.iperbits() == m.iperbits)
+           &&
+           (l.var_bits() == m.var_bits)
+           &&
+           (l.bits()     == m.bits    )
+           &&
+           (l.root()     == m.root    );
+}
+
+static bool check(AnotherStruct::Lazy &l, const AnotherStruct &m)
+{
+    return (l.aMap() == m.aMap)
+           &&
+           (l.dat()  == m.dat )
+           &&
+           (l.bar()  == m.bar )
+           &&
+           (l.lmax() == m.lmax)
+           &&
+           (l.smin() == m.smin)
+           &&
+           (l.bnil() == m.bnil);
+}
+
+// Last field of the frame
+
+static uint64_t last(NumericMessage::Lazy &l) { return l.trace().size();    }
+static uint64_t last(ComplexStruct::Lazy  &l) { return l.iperbits().size(); }
+static uint64_t last(AnotherStruct::Lazy  &l) { return l.aMap().size();     }
+
+static uint64_t last(const NumericMessage &m) { return m.trace.size();    }
+static uint64_t last(const ComplexStruct  &m) { return m.iperbits.size(); }
+static uint64_t last(const AnotherStruct  &m) { return m.aMap.size();     }
+
+template<class T>
+static void check()
+{
+    T m;
+
+    fill(m);
+
+    vector<uint8_t> frame;
+
+    CHECK(m.serialize_to(frame) > 0);
+
+    {
+        typename T::Lazy l(HOB::View(&frame[0], frame.size()));
+
+        CHECK(l.frame_ok());
+        CHECK(check(l, m));
+
+        // Again, from the offsets index
+
+        CHECK(check(l, m));
+    }
+
+    {
+        typename T::Lazy l(HOB::View(&frame[0], frame.size()));
+
+        CHECK(last(l) == last(m));
+    }
+
+    // Truncated payloads: the accessors fall back to the default values,
+    // never reading past the end of the span
+
+    HOB::View whole(&frame[0], frame.size());
+
+    for (size_t l=0; l<whole.payload_size(); l++)
+    {
+        stringstream hs;
+
+        CHECK(Codec::header(hs, whole.id(), l));
+
+        string   h = hs.str();
+        uint8_t *p = static_cast<uint8_t *>(malloc(h.size() + l));
+
+        memcpy(p, h.data(), h.size());
+        memcpy(p + h.size(), whole.payload(), l);
+
+        typename T::Lazy z(HOB::View(p, h.size() + l));
+
+        CHECK(!z.frame_ok());
+
+        (void)last(z);
+
+        free(p);
+    }
+}
+
+static void check_names()
+{
+    Frame m;
+
+    m.x = 7;
+    m.d = "a string well past the short string size";
+    m.k = 0.5;
+
+    vector<uint8_t> frame;
+
+    CHECK(m.serialize_to(frame) > 0);
+
+    Frame::Lazy l(HOB::View(&frame[0], frame.size()));
+
+    CHECK(l.frame_ok());
+    CHECK(l.k() == m.k);
+    CHECK(l.d() == m.d);
+    CHECK(l.x() == m.x);
+}
+
+int main()
+{
+    check<AnotherStruct >();
+    check<NumericMessage>();
+    check<ComplexStruct >();
+
+    // Frames of another type are not valid
+
+    NumericExtraParameters x;
+    vector<uint8_t>        frame;
+
+    CHECK(x.serialize_to(frame) > 0);
+
+    NumericMessage::Lazy l(HOB::View(&frame[0], frame.size()));
+
+    CHECK(!l.frame_ok());
+    CHECK(l.text() == NumericMessage().text);
+
+    check_names();
+
+    return 0;
+}
@@ -0,0 +1,277 @@
+/******************************************************************************
+//
+// Decoding limits checks
+//
+// Checks that frames claiming huge containers and strings in a few bytes are
+// rejected, from memory and from an istream, without any heap allocation,
+// that the limits set at run time on items, chars, frame size and nesting
+// depth apply, that text groups nested too deep are rejected, and that the
+// well formed frames still decode.
+//
+// Usage:
+//
+//    ./check_limits
+//
+******************************************************************************/
+#include <new>
+#include <sstream>
+#include "check.h"
+
+static size_t allocations = 0;
+
+// Heap allocations counter
+
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(size_t sz) throw(std::bad_alloc)
+{
+    allocations++;
+
+    void *p = malloc((sz > 0) ? sz : 1);
+
+    if (NULL == p)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void *p) throw()
+{
+    free(p);
+}
+
+HOBSTRUCT(Buffer, "BUFFER",
+    (vector<uint32_t>, items)
+    (string          , name )
+)
+
+// A single count, to forge the payloads of the Buffers with
+
+HOBSTRUCT(Count, "COUNT",
+    (uint64_t, count)
+)
+
+HOBSTRUCT(Inner, "INNER",
+    (uint32_t, id)
+)
+
+HOBSTRUCT(Middle, "MIDDLE",
+    (Inner, inner)
+)
+
+HOBSTRUCT(Outer, "OUTER",
+    (Middle, middle)
+)
+
+// The payload bytes of a frame
+//
+static void payload(const vector<uint8_t> &f, vector<uint8_t> &p)
+{
+    HOB::View v(&f[0], f.size());
+
+    CHECK(v.consumed() == f.size());
+
+    p.insert(p.end(), v.payload(), v.payload() + v.payload_size());
+}
+
+// The count as written on the wire
+//
+static void count(uint64_t n, vector<uint8_t> &p)
+{
+    Count           c;
+    vector<uint8_t> f;
+
+    c.count = n;
+
+    CHECK(c.serialize_to(f) > 0);
+
+    payload(f, p);
+}
+
+// A Buffer frame of the given (short) payload
+//
+static void forge(const vector<uint8_t> &p, vector<uint8_t> &f)
+{
+    Buffer          b;
+    vector<uint8_t> e;
+
+    CHECK(b.serialize_to(e) > 0);
+
+    HOB::View v(&e[0], e.size());
+
+    CHECK(p.size() < 0x80);
+
+    // The ID as is, the single byte payload size replaced
+
+    f.assign(e.begin(), e.begin() + (v.consumed() - v.payload_size() - 1));
+    f.push_back(static_cast<uint8_t>(p.size()));
+    f.insert(f.end(), p.begin(), p.end());
+}
+
+// A forged frame is rejected from memory and from an istream, and decoding
+// it allocates nothing
+//
+static void check_reject(const vector<uint8_t> &f)
+{
+    Buffer d;
+
+    size_t a = allocations;
+
+    CHECK(!(d << HOB::View(&f[0], f.size())));
+    CHECK(allocations == a);
+
+    stringstream ss;
+
+    ss.write(reinterpret_cast<const char *>(&f[0]), f.size());
+
+    CHECK(d.read_from(ss) < 0);
+}
+
+static void check_forged()
+{
+    vector<uint8_t> p;
+    vector<uint8_t> f;
+
+    // The forged frames are as read by the well formed ones
+
+    count(2, p);
+    count(7, p);
+    count(300, p);
+    count(2, p);
+
+    p.push_back('a');
+    p.push_back('b');
+
+    forge(p, f);
+
+    {
+        Buffer d;
+
+        CHECK(d << HOB::View(&f[0], f.size()));
+        CHECK((d.items.size() == 2) && (d.items[1] == 300));
+        CHECK(d.name == "ab");
+    }
+
+    // 2^40 items, 2^40 chars, in a few bytes
+
+    p.clear();
+
+    count(1llu << 40, p);
+    count(7, p);
+
+    forge(p, f);
+    check_reject(f);
+
+    p.clear();
+
+    count(0, p);
+    count(1llu << 40, p);
+
+    p.push_back('a');
+
+    forge(p, f);
+    check_reject(f);
+
+    // Within the limits, but past the bytes left in the frame
+
+    p.clear();
+
+    count(1000, p);
+    count(7, p);
+
+    forge(p, f);
+    check_reject(f);
+}
+
+static void check_runtime()
+{
+    Buffer          b;
+    vector<uint8_t> f;
+
+    b.items.assign(100, 7);
+    b.name.assign(100, 'a');
+
+    CHECK(b.serialize_to(f) > 0);
+
+    Buffer d;
+
+    HOB::limits().items = 99;
+
+    CHECK(!(d << HOB::View(&f[0], f.size())));
+
+    HOB::limits().items = 100;
+    HOB::limits().chars = 99;
+
+    CHECK(!(d << HOB::View(&f[0], f.size())));
+
+    HOB::limits().chars = 100;
+    HOB::limits().frame = f.size() / 2;
+
+    CHECK(0 == HOB::View(&f[0], f.size()).consumed());
+
+    HOB::limits().frame = HOB_MAX_FRAME;
+
+    CHECK(d << HOB::View(&f[0], f.size()));
+    CHECK(d == b);
+}
+
+static void check_depth()
+{
+    Outer           o;
+    vector<uint8_t> f;
+
+    o.middle.inner.id = 1;
+
+    CHECK(o.serialize_to(f) > 0);
+
+    Outer        d;
+    stringstream ss;
+
+    ss.write(reinterpret_cast<const char *>(&f[0]), f.size());
+
+    HOB::limits().depth = 1;
+
+    CHECK(!(d << HOB::View(&f[0], f.size())));
+    CHECK(d.read_from(ss) < 0);
+
+    HOB::limits().depth = 2;
+
+    CHECK(d << HOB::View(&f[0], f.size()));
+    CHECK(d == o);
+
+    HOB::limits().depth = HOB_MAX_DEPTH;
+}
+
+// Text groups nested too deep, then as deep as allowed
+//
+static void check_groups()
+{
+    string t(100000, '[');
+
+    stringstream txt(t);
+    stringstream raw;
+    HOB::Src     src(txt);
+    HOB::Snk     snk(raw);
+
+    CHECK(!(src >> snk));
+
+    t.assign(HOB_MAX_GROUPS - 1, '[');
+    t.append(HOB_MAX_GROUPS - 1, ']');
+
+    txt.clear();
+    txt.str(t);
+
+    CHECK(src >> snk);
+}
+
+int main()
+{
+    check_forged();
+    check_runtime();
+    check_depth();
+    check_groups();
+
+    return 0;
+}
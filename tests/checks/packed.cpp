@@ -0,0 +1,133 @@
+/******************************************************************************
+//
+// Packed integer vectors checks
+//
+// Checks that packed<T> decodes the very same values as vector<T>, that the
+// packing method giving the smallest size is chosen for typical data sets,
+// and round trips the extreme values and the sizes around the block size.
+//
+// Usage:
+//
+//    ./check_packed
+//
+******************************************************************************/
+#include <sstream>
+#include <vector>
+#include "check.h"
+
+class Codec: public HOB
+{
+public:
+    template<class T>
+    static bool write(ostream &os, const T &v)
+    {
+        return HOB::_w(os, v);
+    }
+
+    template<class T>
+    bool read(istream &is, T &v)
+    {
+        return HOB::_r(is, v);
+    }
+
+    // Packing method written after the number of items
+    //
+    static int method(const string &s)
+    {
+        const uint8_t *d = reinterpret_cast<const uint8_t *>(s.data());
+
+        return d[varint_prefix_length(d[0])];
+    }
+
+    static int FOR()   { return PACKED_FOR;   }
+    static int DELTA() { return PACKED_DELTA; }
+    static int RLE()   { return PACKED_RLE;   }
+};
+
+//
+// Data sets
+//
+static uint64_t sorted_ids(size_t i)     { return 100000 + i * 3 + (check_random() % 3); }
+static uint64_t slow_counters(size_t i)  { return 5000000 + i / 16; }
+static uint64_t status_runs(size_t i)    { return (i / 1000) % 4; }
+static uint64_t random_values(size_t i)  { (void)i; return check_random() & 0xfffff; }
+
+template<class T>
+static string check_values(const vector<T> &values)
+{
+    HOB::packed<T> p_values(values);
+
+    stringstream v_ss;
+    stringstream p_ss;
+    Codec        codec;
+
+    CHECK(Codec::write(v_ss, values));
+    CHECK(Codec::write(p_ss, p_values));
+
+    vector<T>      v_decoded;
+    HOB::packed<T> p_decoded;
+
+    CHECK(codec.read(v_ss, v_decoded));
+    CHECK(codec.read(p_ss, p_decoded));
+
+    CHECK(v_decoded == values);
+    CHECK(p_decoded == p_values);
+
+    return p_ss.str();
+}
+
+template<class T>
+static void check_method(uint64_t (*gen)(size_t), size_t count, int method)
+{
+    vector<T> values(count);
+
+    for (size_t i=0; i<count; i++)
+    {
+        values[i] = static_cast<T>(gen(i));
+    }
+
+    CHECK(Codec::method(check_values(values)) == method);
+}
+
+template<class T>
+static void check_sizes(T lo, T hi)
+{
+    static const size_t sizes[] = { 0, 1, 2, 127, 128, 129, 255, 256, 257 };
+
+    for (size_t s=0; s<sizeof(sizes)/sizeof(sizes[0]); s++)
+    {
+        vector<T> runs(sizes[s]);
+        vector<T> swings(sizes[s]);
+        vector<T> noise(sizes[s]);
+
+        for (size_t i=0; i<sizes[s]; i++)
+        {
+            runs[i]   = (i < sizes[s] / 2) ? lo : hi;
+            swings[i] = (i & 1) ? lo : hi;
+            noise[i]  = static_cast<T>(check_random());
+        }
+
+        check_values(runs);
+        check_values(swings);
+        check_values(noise);
+    }
+}
+
+int main()
+{
+    check_method<uint32_t>(sorted_ids   , 100000, Codec::DELTA());
+    check_method<uint64_t>(slow_counters, 100000, Codec::DELTA());
+    check_method<uint8_t >(status_runs  , 100000, Codec::RLE()  );
+    check_method<int32_t >(random_values, 100000, Codec::FOR()  );
+
+    check_sizes<uint8_t >(0, 0xff);
+    check_sizes<int8_t  >(-128, 127);
+    check_sizes<int16_t >(-32768, 32767);
+    check_sizes<uint32_t>(0, 0xffffffff);
+    check_sizes<int32_t >(-2147483647 - 1, 2147483647);
+    check_sizes<uint64_t>(0, 0xffffffffffffffffllu);
+    check_sizes<int64_t >(static_cast<int64_t>(0x8000000000000000llu),
+                          0x7fffffffffffffffll);
+
+    return 0;
+}
@@ -0,0 +1,288 @@
+/******************************************************************************
+//
+// HOB serialization checks
+//
+// Checks that the serialization of a HOB through std::ostream (stringstream
+// and HOB::Buffer) and the direct to memory serialize_to(), into new, reused
+// and appended destinations, produce the very same bytes, of the size given
+// in advance by size_t(hob), and that a HOB::Buffer appended to grows
+// geometrically. Trees of nested HOBs, whose payload sizes are evaluated
+// once per serialization, are checked the same way, also after changing
+// them.
+//
+// Usage:
+//
+//    ./check_serialize
+//
+******************************************************************************/
+#include <string.h>
+#include <sstream>
+#include <vector>
+#include "check.h"
+
+HOBSTRUCT(Item, "ITEM",
+    (uint32_t, id   , 0 )
+    (string  , name ,   )
+    (double  , value, 0.)
+)
+
+HOBSTRUCT(Frame, "FRAME",
+    (uint64_t    , stamp, 0)
+    (vector<Item>, items,  )
+    (string      , note ,  )
+)
+
+HOBSTRUCT(Leaf, "LEAF",
+    (uint32_t        , id    , 0)
+    (vector<uint32_t>, values,  )
+)
+
+HOBSTRUCT(Twig, "TWIG",
+    (uint32_t    , id    , 0)
+    (vector<Leaf>, leaves,  )
+)
+
+HOBSTRUCT(Branch, "BRANCH",
+    (uint32_t    , id   , 0)
+    (vector<Twig>, twigs,  )
+)
+
+HOBSTRUCT(Bough, "BOUGH",
+    (uint32_t      , id      , 0)
+    (vector<Branch>, branches,  )
+)
+
+HOBSTRUCT(Tree, "TREE",
+    (uint32_t     , id    , 0)
+    (vector<Bough>, boughs,  )
+)
+
+// Decodes the bytes at d back into a HOB equal to ref
+//
+template<class T>
+static void check_decode(const T &ref, const void *d, size_t len)
+{
+    istringstream is(string(static_cast<const char *>(d), len));
+    T             v;
+
+    CHECK(v.read_from(is) > 0);
+    CHECK(v == ref);
+}
+
+template<class T>
+static void check_destinations(const T &f)
+{
+    size_t len = f;
+
+    stringstream ref;
+
+    CHECK(f >> ref);
+    CHECK(ref.str().size() == len);
+
+    check_decode(f, ref.str().data(), len);
+
+    HOB::Buffer b;
+
+    CHECK(f >> b);
+    CHECK(b.size() == len);
+    CHECK(memcmp(b.data(), ref.str().data(), len) == 0);
+
+    vector<uint8_t> dst(len);
+
+    CHECK(f.serialize_to(&dst[0], dst.size()) == len);
+    CHECK(memcmp(&dst[0], ref.str().data(), len) == 0);
+
+    CHECK(f.serialize_to(&dst[0], len - 1) == 0);
+    CHECK(f.serialize_to(NULL, len) == 0);
+
+    vector<uint8_t> v;
+
+    CHECK(f.serialize_to(v) == len);
+    CHECK(v.size() == len);
+    CHECK(memcmp(&v[0], ref.str().data(), len) == 0);
+
+    // Appended
+
+    CHECK(f.serialize_to(v) == len);
+    CHECK(v.size() == 2 * len);
+    CHECK(memcmp(&v[len], ref.str().data(), len) == 0);
+
+    HOB::Buffer hb;
+
+    for (size_t i=0; i<3; i++)
+    {
+        CHECK(f.serialize_to(hb) == len);
+        CHECK(hb.size() == (i + 1) * len);
+        CHECK(memcmp(hb.data() + i * len, ref.str().data(), len) == 0);
+    }
+
+    check_decode(f, hb.data() + len, len);
+
+    // Reused
+
+    v.clear();
+    hb.clear();
+
+    CHECK(f.serialize_to(v) == len);
+    CHECK(v.size() == len);
+    CHECK(memcmp(&v[0], ref.str().data(), len) == 0);
+
+    CHECK(f.serialize_to(hb) == len);
+    CHECK(hb.size() == len);
+    CHECK(memcmp(hb.data(), ref.str().data(), len) == 0);
+}
+
+static void check_frames()
+{
+    Frame f;
+
+    check_destinations(f);
+
+    f.stamp = 0x0123456789abcdefllu;
+    f.note  = "serialization check";
+
+    for (size_t i=0; i<16; i++)
+    {
+        Item it;
+
+        it.id    = static_cast<uint32_t>(check_random());
+        it.name  = "item";
+        it.value = static_cast<double>(i) * 0.5;
+
+        f.items.push_back(it);
+    }
+
+    check_destinations(f);
+
+    // Payload sizes across the 1, 2 and 3 bytes VARINT lengths
+
+    f.items.resize(1);
+
+    for (size_t n=100; n<20000; n*=3)
+    {
+        f.note = string(n, 'x');
+
+        check_destinations(f);
+    }
+}
+
+// 4 boughs of 4 branches of 4 twigs of 4 leaves: 341 nested HOBs, far more
+// than the sizes kept in place
+//
+static Tree make_tree(size_t items)
+{
+    Tree t;
+
+    for (size_t a=0; a<4; a++)
+    {
+        Bough bo;
+
+        for (size_t b=0; b<4; b++)
+        {
+            Branch br;
+
+            for (size_t c=0; c<4; c++)
+            {
+                Twig tw;
+
+                for (size_t d=0; d<4; d++)
+                {
+                    Leaf l;
+
+                    for (size_t e=0; e<items; e++)
+                    {
+                        l.values.push_back(static_cast<uint32_t>(check_random()));
+                    }
+
+                    tw.leaves.push_back(l);
+                }
+
+                br.twigs.push_back(tw);
+            }
+
+            bo.branches.push_back(br);
+        }
+
+        t.boughs.push_back(bo);
+    }
+
+    return t;
+}
+
+static void check_trees()
+{
+    Tree t = make_tree(32);
+
+    check_destinations(t);
+
+    // Payload sizes changed at every level, across the VARINT lengths
+
+    t.boughs[3].branches[3].twigs[3].leaves[3].values.resize(5000, 0xffffffff);
+
+    check_destinations(t);
+
+    t.boughs[0].branches[0].twigs[0].leaves[0].values.clear();
+    t.boughs[1].branches.pop_back();
+    t.boughs[2].id = 0xffffffff;
+
+    check_destinations(t);
+
+    // A tree with a single nested HOB, then without any
+
+    Tree s;
+
+    s.boughs.resize(1);
+
+    check_destinations(s);
+
+    s.boughs.clear();
+
+    check_destinations(s);
+
+    // Nested HOBs serialized on their own, between the trees
+
+    check_destinations(t.boughs[2]);
+    check_destinations(t.boughs[3].branches[3].twigs[3]);
+    check_destinations(make_tree(0));
+    check_destinations(t);
+}
+
+// Frames appended one by one to a HOB::Buffer grow it geometrically
+//
+static void check_appended()
+{
+    Leaf l;
+
+    l.id = 1;
+    l.values.resize(3, 7);
+
+    size_t      len = static_cast<size_t>(l);
+    size_t      n   = 0;
+    HOB::Buffer b;
+
+    for (size_t i=0; i<10000; i++)
+    {
+        size_t c = b.capacity();
+
+        CHECK(l.serialize_to(b) == len);
+
+        if (b.capacity() != c)
+        {
+            n++;
+        }
+    }
+
+    CHECK(b.size() == 10000 * len);
+    CHECK(n < 20);
+
+    check_decode(l, b.data() + 9999 * len, len);
+}
+
+int main()
+{
+    check_frames();
+    check_trees();
+    check_appended();
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+/******************************************************************************
+//
+// Floating point series checks
+//
+// Checks that the XOR codec (series<T>) decodes the very same bits as the
+// items of sample series and of the special values (zeros, infinities, NaN,
+// denormals), and that repeated items take a single bit each.
+//
+// Usage:
+//
+//    ./check_series
+//
+******************************************************************************/
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <sstream>
+#include <vector>
+#include "check.h"
+
+class Codec: public HOB
+{
+public:
+    template<class T>
+    static bool write(ostream &os, const T &v)
+    {
+        return HOB::_w(os, v);
+    }
+
+    template<class T>
+    bool read(istream &is, T &v)
+    {
+        return HOB::_r(is, v);
+    }
+};
+
+//
+// Series
+//
+static double check_uniform()
+{
+    return static_cast<double>(check_random() % 1000000) / 1000000.0;
+}
+
+static double temperature(size_t i)
+{
+    double t = 20.0 + 5.0 * sin(static_cast<double>(i) / 1440.0 * 6.2832);
+
+    return floor(t * 100.0 + 0.5) / 100.0;
+}
+
+static double gauge(size_t i)
+{
+    return static_cast<double>((i / 60) % 100) * 0.5;
+}
+
+static double random_walk(size_t i)
+{
+    static double v = 100.0;
+
+    (void)i;
+
+    v += check_uniform() - 0.5;
+
+    return v;
+}
+
+// Series are compared bit by bit, NaN included
+//
+template<class T>
+static string check_values(const vector<T> &values)
+{
+    HOB::series<T> g_values(values);
+
+    stringstream v_ss;
+    stringstream g_ss;
+    Codec        codec;
+
+    CHECK(Codec::write(v_ss, values));
+    CHECK(Codec::write(g_ss, g_values));
+
+    vector<T>      v_decoded;
+    HOB::series<T> g_decoded;
+
+    CHECK(codec.read(v_ss, v_decoded));
+    CHECK(codec.read(g_ss, g_decoded));
+
+    CHECK(v_decoded.size() == values.size());
+    CHECK(g_decoded.size() == values.size());
+
+    if (!values.empty())
+    {
+        size_t n = values.size() * sizeof(T);
+
+        CHECK(memcmp(&v_decoded[0], &values[0], n) == 0);
+        CHECK(memcmp(&g_decoded[0], &values[0], n) == 0);
+    }
+
+    return g_ss.str();
+}
+
+template<class T>
+static void check_series(double (*gen)(size_t), size_t count)
+{
+    vector<T> values(count);
+
+    for (size_t i=0; i<count; i++)
+    {
+        values[i] = static_cast<T>(gen(i));
+    }
+
+    check_values(values);
+}
+
+template<class T>
+static void check_special(T max, T min, T denorm)
+{
+    T special[] =
+    {
+        0, -static_cast<T>(0), 1, -1, max, -max, min, denorm,
+        static_cast<T>(HUGE_VAL), -static_cast<T>(HUGE_VAL),
+        static_cast<T>(sqrt(-1.0))
+    };
+
+    size_t n = sizeof(special)/sizeof(special[0]);
+
+    for (size_t l=0; l<=3; l++)
+    {
+        for (size_t i=0; i<n; i++)
+        {
+            vector<T> values;
+
+            for (size_t j=0; j<l; j++)
+            {
+                values.push_back(special[(i + j * 7) % n]);
+            }
+
+            check_values(values);
+        }
+    }
+
+    check_values(vector<T>(special, special + n));
+}
+
+//
+// 1 VARINT count, 1 VARINT first item, 1 VARINT bitstream size, then one
+// '0' bit per repeated item
+//
+static void check_repeats()
+{
+    string s = check_values(vector<double>(8001, 3.25));
+
+    CHECK(s.size() <= 3 + 9 + 2 + 1000);
+}
+
+int main()
+{
+    check_series<double>(temperature, 100000);
+    check_series<float >(temperature, 100000);
+    check_series<double>(gauge      , 100000);
+    check_series<double>(random_walk, 100000);
+    check_series<float >(random_walk, 100000);
+
+    check_special<double>(DBL_MAX, DBL_MIN, DBL_MIN / 4);
+    check_special<float >(FLT_MAX, FLT_MIN, FLT_MIN / 4);
+
+    check_repeats();
+
+    return 0;
+}
@@ -0,0 +1,294 @@
+/******************************************************************************
+//
+// VARINT codec checks
+//
+// Checks the wire bytes of the VARINT codec core at every length boundary,
+// that memory and iostream paths write and read back the same values, and
+// that the bulk vector reader matches the per item one.
+//
+// Usage:
+//
+//    ./check_varint
+//
+******************************************************************************/
+#include <string.h>
+#include <sstream>
+#include <vector>
+#include "check.h"
+
+class Codec: public HOB
+{
+public:
+    static uint8_t pack(uint8_t *d, const uint64_t &v)
+    {
+        return varint_pack(d, v);
+    }
+
+    static uint8_t unpack(const uint8_t *d, uint64_t &v)
+    {
+        uint8_t b = varint_prefix_length(d[0]);
+
+        v = varint_unpack(d, b);
+
+        return b;
+    }
+
+    static bool write(ostream &os, const uint64_t &v)
+    {
+        return HOB::_w(os, v);
+    }
+
+    bool read(istream &is, uint64_t &v)
+    {
+        return HOB::_r(is, v);
+    }
+
+    template<class T>
+    static bool write(ostream &os, const vector<T> &v)
+    {
+        return HOB::_w(os, v);
+    }
+
+    // Per item vector read
+    //
+    template<class T>
+    bool read_items(istream &is, vector<T> &v)
+    {
+        size_t len = 0;
+
+        if (!HOB::_r(is, len))
+        {
+            return false;
+        }
+
+        v.resize(len);
+
+        return (0 == len) || HOB::_rv<T>(is, &v[0], len);
+    }
+
+    // Bulk vector read
+    //
+    template<class T>
+    bool read_bulk(istream &is, vector<T> &v)
+    {
+        return HOB::_r(is, v);
+    }
+};
+
+//
+// Stream buffer handing out a few bytes at time, to exercise the bulk
+// reader across the buffer boundaries
+//
+class TrickleBuf: public streambuf
+{
+public:
+    TrickleBuf(const string &s): _s(s), _p(0) {}
+
+protected:
+    virtual int_type underflow()
+    {
+        if (_p >= _s.size())
+        {
+            return traits_type::eof();
+        }
+
+        size_t n = ((_s.size() - _p) < 7) ? (_s.size() - _p) : 7;
+
+        char *b = const_cast<char *>(_s.data()) + _p;
+
+        setg(b, b, b + n);
+
+        _p += n;
+
+        return traits_type::to_int_type(*b);
+    }
+
+private:
+    string _s;
+    size_t _p;
+};
+
+//
+// Largest value held by each VARINT length
+//
+static const uint64_t length_max[9] =
+{
+    0x000000000000007fllu,
+    0x0000000000003fffllu,
+    0x00000000001fffffllu,
+    0x000000000fffffffllu,
+    0x00000007ffffffffllu,
+    0x000003ffffffffffllu,
+    0x0001ffffffffffffllu,
+    0x00ffffffffffffffllu,
+    0xffffffffffffffffllu
+};
+
+static void check_bytes(uint64_t v, const char *bytes, uint8_t len)
+{
+    uint8_t  d[9];
+    uint64_t r = 0;
+
+    CHECK(Codec::pack(d, v) == len);
+    CHECK(memcmp(d, bytes, len) == 0);
+    CHECK(Codec::unpack(d, r) == len);
+    CHECK(r == v);
+}
+
+static void check_wire()
+{
+    check_bytes(0x00, "\x00", 1);
+    check_bytes(0x7f, "\x7f", 1);
+    check_bytes(0x80, "\x80\x80", 2);
+    check_bytes(0x3fff, "\xbf\xff", 2);
+    check_bytes(0x4000, "\xc0\x40\x00", 3);
+    check_bytes(0x1fffff, "\xdf\xff\xff", 3);
+    check_bytes(0x200000, "\xe0\x20\x00\x00", 4);
+    check_bytes(0xffffffffffffffffllu,
+                "\xff\xff\xff\xff\xff\xff\xff\xff\xff", 9);
+}
+
+static void check_lengths()
+{
+    uint8_t  d[9];
+    uint64_t r;
+
+    for (uint8_t b=1; b<=9; b++)
+    {
+        uint64_t hi = length_max[b-1];
+        uint64_t lo = (b > 1) ? (length_max[b-2] + 1) : 0;
+
+        CHECK(Codec::pack(d, lo) == b);
+        CHECK(Codec::unpack(d, r) == b);
+        CHECK(r == lo);
+
+        CHECK(Codec::pack(d, hi) == b);
+        CHECK(Codec::unpack(d, r) == b);
+        CHECK(r == hi);
+    }
+}
+
+static void check_streams(size_t count)
+{
+    vector<uint64_t> values;
+    vector<uint8_t>  buf(count * 9 + 16 * 9);
+    size_t           len = 0;
+
+    for (uint8_t b=1; b<=9; b++)
+    {
+        values.push_back(length_max[b-1]);
+        values.push_back((b > 1) ? (length_max[b-2] + 1) : 0);
+    }
+
+    for (size_t i=0; i<count; i++)
+    {
+        values.push_back(check_random() >> (check_random() % 64));
+    }
+
+    stringstream ss;
+    Codec        codec;
+
+    for (size_t i=0; i<values.size(); i++)
+    {
+        len += Codec::pack(&buf[len], values[i]);
+
+        CHECK(Codec::write(ss, values[i]));
+    }
+
+    CHECK(ss.str().size() == len);
+    CHECK(memcmp(ss.str().data(), &buf[0], len) == 0);
+
+    for (size_t i=0; i<values.size(); i++)
+    {
+        uint64_t r = 0;
+
+        CHECK(codec.read(ss, r));
+        CHECK(r == values[i]);
+    }
+
+    uint64_t r;
+
+    CHECK(!codec.read(ss, r));
+}
+
+template<class T>
+static void check_vector(const vector<T> &values)
+{
+    stringstream ss;
+    Codec        codec;
+    vector<T>    items;
+    vector<T>    bulk;
+    vector<T>    trickle;
+
+    CHECK(Codec::write(ss, values));
+
+    CHECK(codec.read_items(ss, items));
+    CHECK(items == values);
+
+    ss.seekg(0);
+
+    CHECK(codec.read_bulk(ss, bulk));
+    CHECK(bulk == values);
+
+    TrickleBuf tb(ss.str());
+    istream    ts(&tb);
+
+    CHECK(codec.read_bulk(ts, trickle));
+    CHECK(trickle == values);
+}
+
+template<class T>
+static void check_vector(uint64_t mask, size_t count)
+{
+    vector<T> values(count);
+
+    for (size_t i=0; i<count; i++)
+    {
+        values[i] = static_cast<T>((check_random() >> (check_random() % 64))
+                                   &
+                                   mask);
+    }
+
+    check_vector(values);
+}
+
+//
+// Runs of 1 byte VARINTs broken by a longer one at every offset and for
+// every length around the width of the bulk 1 byte test
+//
+static void check_runs()
+{
+    static const uint32_t longer[] = { 0x80, 0x4000, 0x200000, 0xffffffff };
+
+    for (size_t l=0; l<4; l++)
+    {
+        for (size_t n=1; n<=20; n++)
+        {
+            for (size_t at=0; at<n; at++)
+            {
+                vector<uint32_t> values(n, 0x7f);
+
+                values[at] = longer[l];
+
+                check_vector(values);
+            }
+        }
+    }
+}
+
+int main()
+{
+    check_wire();
+    check_lengths();
+    check_streams(100000);
+
+    check_vector(vector<uint32_t>());
+    check_vector<uint32_t>(0x7f, 100000);
+    check_vector<uint32_t>(0x1fffff, 100000);
+    check_vector<uint64_t>(0xffffffffffffffffllu, 100000);
+    check_vector<int16_t >(0xffff, 100000);
+    check_vector<int8_t  >(0xff, 100000);
+    check_runs();
+
+    return 0;
+}
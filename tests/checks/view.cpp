@@ -0,0 +1,162 @@
+/******************************************************************************
+//
+// HOB::View checks
+//
+// Checks that the decoding of HOBs from an istream (generic HOB first, then
+// the typed one) and straight from memory through HOB::View give the very
+// same values, and that truncated frames and payloads are rejected without
+// reading past the end of the span.
+//
+// Usage:
+//
+//    ./check_view
+//
+******************************************************************************/
+#include <string.h>
+#include <sstream>
+#include <vector>
+#include "check.h"
+#include "../hobs.h"
+
+class Codec: public HOB
+{
+public:
+    static bool header(ostream &os, const UID &id, size_t sz)
+    {
+        return HOB::_w(os, id) && HOB::_w(os, sz);
+    }
+};
+
+static void fill(NumericMessage &m)
+{
+    m.bytes.assign(32, -3);
+    m.levels.assign(16, 0.5);
+    m.opt_param = string("optional");
+    m.numbers.assign(8, 2.5f);
+    m.names.assign(4, string("name"));
+
+    for (size_t i=0; i<16; i++)
+    {
+        MyStruct s;
+
+        s.anEnum = static_cast<uint32_t>(i);
+        s.aChar  = static_cast<uint8_t>('A' + i);
+
+        m.structs.push_back(s);
+    }
+
+    m.opt_struct = m.structs[3];
+
+    for (size_t i=0; i<256; i++)
+    {
+        m.ids.push_back(1000 + 3 * static_cast<uint32_t>(i));
+        m.samples.push_back(20.0 + static_cast<double>(i % 7) * 0.25);
+        m.history.push_back(static_cast<uint32_t>(check_random() & 0xffff));
+    }
+
+    m.counters.assign(64, -2);
+    m.states.assign(64, 1);
+    m.readings.assign(32, 1.5f);
+    m.trace.assign(32, 0.125);
+    m.stamp = 0x0123456789abcdefllu;
+}
+
+static void fill(ComplexStruct &m)
+{
+    for (size_t i=0; i<m.bits.size(); i++)
+    {
+        m.bits.set(i, (i % 3) == 0);
+    }
+
+    m.var_bits.assign(100, true);
+    m.iperbits.assign(5, FlagsT(5));
+    m.root.aMap[1] = "one";
+    m.root.aMap[2] = "two";
+    m.root.dat.aFloat = 2.5f;
+}
+
+static void fill(AnotherStruct &m)
+{
+    m.aMap[0] = "zero";
+    m.aMap[1] = "one";
+    m.dat.aChar = 'Z';
+}
+
+template<class T>
+static void check()
+{
+    T m;
+
+    fill(m);
+
+    vector<uint8_t> frame;
+
+    CHECK(m.serialize_to(frame) > 0);
+
+    stringstream ss;
+
+    CHECK(m >> ss);
+
+    {
+        T         d;
+        HOB       h;
+        T         e;
+        HOB::View v(&frame[0], frame.size());
+
+        CHECK((h << ss) && (d << h));
+        CHECK(e << v);
+        CHECK(v.consumed() == frame.size());
+        CHECK(d == m);
+        CHECK(e == m);
+    }
+
+    // Truncated frames: the span ends exactly at the end of a heap block,
+    // so that any read past it would be caught by the address sanitizer
+
+    for (size_t l=0; l<frame.size(); l++)
+    {
+        uint8_t  *p = static_cast<uint8_t *>(malloc(l + 1));
+
+        memcpy(p, &frame[0], l);
+
+        HOB::View v(p, l);
+
+        CHECK(0 == v.consumed());
+
+        free(p);
+    }
+
+    // Truncated payloads within well formed frames
+
+    HOB::View whole(&frame[0], frame.size());
+
+    for (size_t l=0; l<whole.payload_size(); l++)
+    {
+        stringstream hs;
+
+        CHECK(Codec::header(hs, whole.id(), l));
+
+        string    h = hs.str();
+        uint8_t  *p = static_cast<uint8_t *>(malloc(h.size() + l));
+
+        memcpy(p, h.data(), h.size());
+        memcpy(p + h.size(), whole.payload(), l);
+
+        HOB::View v(p, h.size() + l);
+        T         d;
+
+        CHECK(v.consumed() == (h.size() + l));
+        CHECK(!(d << v));
+
+        free(p);
+    }
+}
+
+int main()
+{
+    check<AnotherStruct >();
+    check<NumericMessage>();
+    check<ComplexStruct >();
+
+    return 0;
+}
@@ -116,6 +116,18 @@ HOBSTRUCT(NumericMessage, HOB::UID(42),
      (vector<float>     , numbers)
      (vector<string>    , names)
      (vector<MyStruct>  , structs)
+     (packed<uint32_t>  , ids)
+     (packed<int16_t>   , counters)
+     (packed<uint8_t>   , states)
+     (series<double>    , samples)
+     (series<float>     , readings)
+     (uint64_t          , stamp   , 0 , FIXED64)
+     (int32_t           , offset  , -1, FIXED32)
+     (int16_t           , level   , 3 , VARINT )
+     (uint32_t          , shift   , 0 , ZIGZAG )
+     (double            , ratio   , 0., FIXED64)
+     (vector<uint32_t>  , history ,   , DELTA  )
+     (vector<double>    , trace   ,   , DELTA  )
 )
 
 HOBSTRUCT(NumericExtraParameters, HOB::UID(43),
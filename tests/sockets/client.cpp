@@ -19,28 +19,31 @@ Bye   m_bye;
 
 static void handleServer(std::iostream *io)
 {
-    HOB m;
+    HOB  m;
+    HOB *hobs[] = { &m_hi, &m_put, &m_get, &m_bye, &m };
 
-    while ((*io) >> m)
+    ssize_t i;
+
+    while ((i = HOB::read_one_of(*io, hobs)) >= 0)
     {
         std::cout << "Received: ";
 
-        if (m >> m_hi)
+        if (hobs[i] == &m_hi)
         {
             std::cout << m_hi(HOB::JSON);
         }
         else
-        if (m >> m_put)
+        if (hobs[i] == &m_put)
         {
             std::cout << m_put(HOB::JSON);
         }
         else
-        if (m >> m_get)
+        if (hobs[i] == &m_get)
         {
             std::cout << m_get(HOB::JSON);
         }
         else
-        if (m >> m_bye)
+        if (hobs[i] == &m_bye)
         {
             std::cout << m_bye(HOB::JSON);
         }
@@ -51,7 +54,7 @@ static void handleServer(std::iostream *io)
 
         std::cout << std::endl;
 
-        if (m == m_bye)
+        if (hobs[i] == &m_bye)
         {
             break;
         }
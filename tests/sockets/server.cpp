@@ -33,26 +33,26 @@ static void wall(HOB &m, ostream *s)
 {
     // for (auto s : streamList)
     {
-        if (m >> m_hi)
+        if (m == m_hi)
         {
             (*s) << m_hi; std::cout << "Sending: " << m_hi(HOB::JSON) << std::endl;
         }
         else
-        if (m >> m_put)
+        if (m == m_put)
         {
             m_get.data = "recv some data";
 
             (*s) << m_get; std::cout << "Sending: " << m_get(HOB::JSON) << std::endl;
         }
         else
-        if (m >> m_get)
+        if (m == m_get)
         {
             m_put.data = "sent some data";
 
             (*s) << m_put; std::cout << "Sending: " << m_put(HOB::JSON) << std::endl;
         }
         else
-        if (m >> m_bye)
+        if (m == m_bye)
         {
             (*s) << m_bye; std::cout << "Sending: " << m_bye(HOB::JSON) << std::endl;
         }
@@ -94,12 +94,12 @@ bool handle_message(HOB &m)
     }
 #endif
 
-    if (m >> m_MyStruct)
+    if (m == m_MyStruct)
     {
         LOG(m_MyStruct);
     }
     else
-    if (m >> m_AnotherStruct)
+    if (m == m_AnotherStruct)
     {
         LOG(m_AnotherStruct);
 
@@ -233,27 +233,27 @@ bool handle_message(HOB &m)
         }
     }
     else
-    if (m >> m_NoParamMessage)
+    if (m == m_NoParamMessage)
     {
         LOG(m_NoParamMessage);
     }
     else
-    if (m >> m_NumericNoParamMessage)
+    if (m == m_NumericNoParamMessage)
     {
         LOG(m_NumericNoParamMessage);
     }
     else
-    if (m >> m_NumericMessage)
+    if (m == m_NumericMessage)
     {
         LOG(m_NumericMessage);
     }
     else
-    if (m >> m_ComplexStruct)
+    if (m == m_ComplexStruct)
     {
         LOG(m_ComplexStruct);
     }
     else
-    if (m_NumericExtraParameters << m)
+    if (m == m_NumericExtraParameters)
     {
         LOG(m_NumericExtraParameters);
     }
@@ -286,28 +286,44 @@ static void handleClient(Client client)
     std::iostream io(&sbuf);
     streamList.push_back(&io);
 
-    HOB m;
-
-    while (io >> m)
+    HOB  any;
+    HOB *hobs[] = { &m_hi                    ,
+                    &m_put                   ,
+                    &m_get                   ,
+                    &m_bye                   ,
+                    &m_MyStruct              ,
+                    &m_AnotherStruct         ,
+                    &m_NoParamMessage        ,
+                    &m_NumericNoParamMessage ,
+                    &m_NumericMessage        ,
+                    &m_NumericExtraParameters,
+                    &m_ComplexStruct         ,
+                    &any                     };
+
+    ssize_t i;
+
+    while ((i = HOB::read_one_of(io, hobs)) >= 0)
     {
+        HOB &m = *hobs[i];
+
         std::cout << "Received: ";
 
-        if (m >> m_hi)
+        if (m == m_hi)
         {
             std::cout << m_hi(HOB::JSON);
         }
         else
-        if (m >> m_put)
+        if (m == m_put)
         {
             std::cout << m_put(HOB::JSON);
         }
         else
-        if (m >> m_get)
+        if (m == m_get)
         {
             std::cout << m_get(HOB::JSON);
         }
         else
-        if (m >> m_bye)
+        if (m == m_bye)
         {
             std::cout << m_bye(HOB::JSON);
         }